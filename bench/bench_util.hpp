@@ -0,0 +1,169 @@
+/************************************************
+ *  bench_util.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_BENCH_BENCH_UTIL_HPP_
+#define BPTREE_BENCH_BENCH_UTIL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace bench {
+
+/************************************************
+ * Declaration: struct payload
+ ************************************************/
+
+// A mapped value spanning a whole cache line.
+struct payload {
+    std::int64_t data[8];
+};
+
+/************************************************
+ * Declaration: class sorted_vector<T, C>
+ ************************************************/
+
+// Sorted `std::vector` exposing the subset of the set interface used by the benchmarks.
+template <typename T, typename Compare = std::less<T>>
+class sorted_vector {
+ public:  // Public Type(s)
+    using value_type = T;
+    using key_type = T;
+    using iterator = typename std::vector<T>::const_iterator;
+
+ public:  // Public Method(s)
+    sorted_vector() = default;
+    template <typename InputIt>
+    sorted_vector(InputIt first, InputIt last)
+      : values_(first, last)
+        { std::sort(values_.begin(), values_.end(), Compare()); }
+
+    std::pair<iterator, bool> insert(T const& value) {
+        auto it = std::lower_bound(values_.begin(), values_.end(), value, Compare());
+        if (it != values_.end() && !Compare()(value, *it)) {
+            return {it, false};
+        }
+
+        return {values_.insert(it, value), true};
+    }
+
+    std::size_t erase(T const& key) {
+        auto it = std::lower_bound(values_.begin(), values_.end(), key, Compare());
+        if (it == values_.end() || Compare()(key, *it)) {
+            return 0;
+        }
+
+        values_.erase(it);
+        return 1;
+    }
+
+    iterator find(T const& key) const {
+        auto it = lower_bound(key);
+        return it != end() && !Compare()(key, *it) ? it : end();
+    }
+
+    iterator lower_bound(T const& key) const
+        { return std::lower_bound(values_.begin(), values_.end(), key, Compare()); }
+
+    iterator begin() const noexcept
+        { return values_.begin(); }
+    iterator end() const noexcept
+        { return values_.end(); }
+    std::size_t size() const noexcept
+        { return values_.size(); }
+
+ private:  // Private Property(ies)
+    std::vector<T> values_;
+};
+
+/************************************************
+ * Declaration: benchmark helpers
+ ************************************************/
+
+template <typename T>
+T make_key(std::size_t n);
+
+template <typename Container, typename Key>
+typename Container::value_type make_value(Key const& key);
+
+template <typename T>
+std::vector<T> shuffled_keys(std::size_t n, std::size_t step = 2, unsigned seed = 42);
+
+template <typename T>
+std::vector<T> sorted_keys(std::size_t n, std::size_t step = 2);
+
+void set_ops_per_iteration(benchmark::State& state, std::size_t ops);
+
+/************************************************
+ * Implementation: benchmark helpers
+ ************************************************/
+
+template <typename T>
+inline T make_key(std::size_t n) {
+    return static_cast<T>(n);
+}
+
+// URL-like strings, which share a long prefix and only differ in their last bytes.
+template <>
+inline std::string make_key<std::string>(std::size_t n) {
+    return "https://www.example.com/catalog/item/" + std::to_string(n);
+}
+
+template <typename Key>
+inline Key make_value(Key const& key, Key const*) {
+    return key;
+}
+
+template <typename Key, typename T>
+inline std::pair<Key const, T> make_value(Key const& key, std::pair<Key const, T> const*) {
+    return {key, T()};
+}
+
+template <typename Container, typename Key>
+inline typename Container::value_type make_value(Key const& key) {
+    return make_value(key, static_cast<typename Container::value_type const*>(nullptr));
+}
+
+// Keys are multiples of `step`, so that lookups of the values in between miss.
+template <typename T>
+inline std::vector<T> shuffled_keys(std::size_t n, std::size_t step, unsigned seed) {
+    auto keys = sorted_keys<T>(n, step);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(seed));
+    return keys;
+}
+
+template <typename T>
+inline std::vector<T> sorted_keys(std::size_t n, std::size_t step) {
+    std::vector<T> keys;
+    keys.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        keys.push_back(make_key<T>(i * step));
+    }
+
+    return keys;
+}
+
+// Reports the mean time of a single operation when every iteration performs `ops` of them.
+inline void set_ops_per_iteration(benchmark::State& state, std::size_t ops) {
+    state.SetItemsProcessed(state.iterations() * ops);
+    state.counters["time/op"] = benchmark::Counter(
+        static_cast<double>(ops),
+        benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+}  // namespace bench
+
+#endif  // BPTREE_BENCH_BENCH_UTIL_HPP_
@@ -0,0 +1,421 @@
+/************************************************
+ *  bptree_bench.cpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#include <cstddef>
+#include <cstdint>
+
+#include <functional>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <bptree/bptree.hpp>
+
+#include "./bench_util.hpp"
+
+using bench::payload;
+using bench::set_ops_per_iteration;
+using bench::shuffled_keys;
+using bench::sorted_keys;
+using bench::sorted_vector;
+
+template <typename Container>
+using key_type_of = typename Container::key_type;
+
+template <typename Key>
+using pool_set = bptree::set<
+    Key, std::less<Key>, bptree::leaf_fanout<Key>(), bptree::inner_fanout<Key>(),
+    bptree::pool_allocator<Key>
+>;
+
+// Same order as `std::less<std::string>`, but keeps the generic inner nodes.
+struct string_less : std::less<std::string> {};
+
+template <typename Container>
+Container make_container(std::vector<key_type_of<Container>> const& keys) {
+    Container container;
+    for (auto const& key : keys) {
+        container.insert(bench::make_value<Container>(key));
+    }
+
+    return container;
+}
+
+template <typename Container>
+void BM_Insert(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(state.range(0));
+    for (auto _ : state) {
+        Container container;
+        for (auto const& key : keys) {
+            container.insert(bench::make_value<Container>(key));
+        }
+
+        benchmark::DoNotOptimize(container);
+    }
+
+    set_ops_per_iteration(state, keys.size());
+}
+
+// Like `BM_Insert`, but also counts applying the writes still buffered at the end.
+template <typename Container>
+void BM_InsertFlushed(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(state.range(0));
+    for (auto _ : state) {
+        Container container;
+        for (auto const& key : keys) {
+            container.insert(bench::make_value<Container>(key));
+        }
+
+        container.flush();
+        benchmark::DoNotOptimize(container);
+    }
+
+    set_ops_per_iteration(state, keys.size());
+}
+
+// Like `BM_Insert`, but takes a snapshot every 1024 writes, so that the next writes copy the nodes
+// on their path instead of modifying them in place.
+template <typename Container>
+void BM_InsertSnapshotted(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(state.range(0));
+    for (auto _ : state) {
+        Container container;
+        typename Container::snapshot_type snapshot;
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            container.insert(bench::make_value<Container>(keys[i]));
+            if (i % 1024 == 1023) {
+                snapshot = container.snapshot();
+            }
+        }
+
+        benchmark::DoNotOptimize(snapshot);
+    }
+
+    set_ops_per_iteration(state, keys.size());
+}
+
+template <typename Container>
+void BM_Erase(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(state.range(0));
+    auto filled = make_container<Container>(keys);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto container = filled;
+        state.ResumeTiming();
+
+        for (auto const& key : keys) {
+            benchmark::DoNotOptimize(container.erase(key));
+        }
+    }
+
+    set_ops_per_iteration(state, keys.size());
+}
+
+// Half of the probed keys are missing from the container.
+template <typename Container>
+void BM_Find(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(state.range(0));
+    auto container = make_container<Container>(keys);
+    auto probes = shuffled_keys<key_type_of<Container>>(state.range(0) * 2, 1, 7);
+    for (auto _ : state) {
+        std::size_t found = 0;
+        for (auto const& key : probes) {
+            found += container.find(key) != container.end();
+        }
+
+        benchmark::DoNotOptimize(found);
+    }
+
+    set_ops_per_iteration(state, probes.size());
+}
+
+// Like `BM_Find`, looking the probes up in interleaved groups.
+template <typename Container>
+void BM_FindMany(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(state.range(0));
+    auto container = make_container<Container>(keys);
+    auto probes = shuffled_keys<key_type_of<Container>>(state.range(0) * 2, 1, 7);
+    std::vector<typename Container::const_iterator> results(probes.size());
+    for (auto _ : state) {
+        container.find_many(probes.begin(), probes.end(), results.begin());
+        benchmark::DoNotOptimize(results.data());
+    }
+
+    set_ops_per_iteration(state, probes.size());
+}
+
+// Like `BM_Find`, on the frozen copy of a tree.
+template <typename Tree>
+void BM_FindFrozen(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Tree>>(state.range(0));
+    auto container = make_container<Tree>(keys).freeze();
+    auto probes = shuffled_keys<key_type_of<Tree>>(state.range(0) * 2, 1, 7);
+    for (auto _ : state) {
+        std::size_t found = 0;
+        for (auto const& key : probes) {
+            found += container.find(key) != container.end();
+        }
+
+        benchmark::DoNotOptimize(found);
+    }
+
+    set_ops_per_iteration(state, probes.size());
+}
+
+template <typename Container>
+void BM_LowerBound(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(state.range(0));
+    auto container = make_container<Container>(keys);
+    auto probes = shuffled_keys<key_type_of<Container>>(state.range(0) * 2, 1, 7);
+    for (auto _ : state) {
+        for (auto const& key : probes) {
+            benchmark::DoNotOptimize(container.lower_bound(key));
+        }
+    }
+
+    set_ops_per_iteration(state, probes.size());
+}
+
+template <typename Container>
+void BM_Iterate(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(state.range(0));
+    auto container = make_container<Container>(keys);
+    for (auto _ : state) {
+        for (auto const& value : container) {
+            benchmark::DoNotOptimize(&value);
+        }
+    }
+
+    set_ops_per_iteration(state, container.size());
+}
+
+// Same scan as `BM_Iterate`, but going through the leaf spans of `range`.
+template <typename Container>
+void BM_RangeScan(benchmark::State& state) {
+    using key_type = key_type_of<Container>;
+
+    auto keys = shuffled_keys<key_type>(state.range(0));
+    auto container = make_container<Container>(keys);
+    for (auto _ : state) {
+        for (auto span : container.range(key_type(), std::numeric_limits<key_type>::max())) {
+            for (auto const& value : span) {
+                benchmark::DoNotOptimize(&value);
+            }
+        }
+    }
+
+    set_ops_per_iteration(state, container.size());
+}
+
+// Sums the mapped values of a whole map, going either through iterators or through the spans
+// handed out by `for_each_span`.
+template <typename Container>
+void BM_SumIterate(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(state.range(0));
+    auto container = make_container<Container>(keys);
+    for (auto _ : state) {
+        typename Container::mapped_type sum = 0;
+        for (auto const& value : container) {
+            sum += value.second;
+        }
+
+        benchmark::DoNotOptimize(sum);
+    }
+
+    set_ops_per_iteration(state, container.size());
+}
+
+template <typename Container>
+void BM_SumSpans(benchmark::State& state) {
+    using value_type = typename Container::value_type;
+
+    auto keys = shuffled_keys<key_type_of<Container>>(state.range(0));
+    auto container = make_container<Container>(keys);
+    for (auto _ : state) {
+        typename Container::mapped_type sum = 0;
+        container.for_each_span([&sum](value_type const* data, std::size_t size) {
+            for (std::size_t i = 0; i < size; ++i) {
+                sum += data[i].second;
+            }
+        });
+
+        benchmark::DoNotOptimize(sum);
+    }
+
+    set_ops_per_iteration(state, container.size());
+}
+
+// Same sum as `BM_SumSpans`, reduced on `state.range(1)` threads.
+template <typename Container>
+void BM_ParallelSum(benchmark::State& state) {
+    using value_type = typename Container::value_type;
+    using mapped_type = typename Container::mapped_type;
+
+    auto keys = shuffled_keys<key_type_of<Container>>(state.range(0));
+    auto container = make_container<Container>(keys);
+    auto threads = static_cast<std::size_t>(state.range(1));
+    for (auto _ : state) {
+        auto sum = container.parallel_reduce(
+            mapped_type(0),
+            [](mapped_type acc, value_type const& value) { return acc + value.second; },
+            [](mapped_type x, mapped_type y) { return x + y; },
+            threads);
+        benchmark::DoNotOptimize(sum);
+    }
+
+    set_ops_per_iteration(state, container.size());
+}
+
+// Measures tearing a whole container down.
+template <typename Container>
+void BM_Clear(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto container = make_container<Container>(keys);
+        state.ResumeTiming();
+
+        container.clear();
+        benchmark::DoNotOptimize(container);
+    }
+
+    set_ops_per_iteration(state, keys.size());
+}
+
+template <typename Container>
+void BM_BulkLoad(benchmark::State& state) {
+    auto keys = sorted_keys<key_type_of<Container>>(state.range(0));
+    for (auto _ : state) {
+        Container container(keys.begin(), keys.end());
+        benchmark::DoNotOptimize(container);
+    }
+
+    set_ops_per_iteration(state, keys.size());
+}
+
+// Builds from shuffled keys, sorting a fresh copy of them on `state.range(1)` threads.
+template <typename Container>
+void BM_BuildParallel(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(state.range(0));
+    auto threads = static_cast<std::size_t>(state.range(1));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto input = keys;
+        state.ResumeTiming();
+
+        auto container = bptree::build_parallel<Container>(input.begin(), input.end(), threads);
+        benchmark::DoNotOptimize(container);
+    }
+
+    set_ops_per_iteration(state, keys.size());
+}
+
+// Inserts `keys` into `container` from `threads` threads, each taking an interleaved share of them.
+template <typename Container>
+void insert_from_threads(Container& container, std::vector<key_type_of<Container>> const& keys,
+                         std::size_t threads) {
+    bptree::internal::parallel_invoke(threads, [&](std::size_t t) {
+        for (auto i = t; i < keys.size(); i += threads) {
+            container.insert(bench::make_value<Container>(keys[i]));
+        }
+    });
+}
+
+// Measures inserts from several threads into a single concurrent tree.
+template <typename Container>
+void BM_ConcurrentInsert(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(state.range(0));
+    auto threads = static_cast<std::size_t>(state.range(1));
+    for (auto _ : state) {
+        Container container;
+        insert_from_threads(container, keys, threads);
+        benchmark::DoNotOptimize(container);
+    }
+
+    set_ops_per_iteration(state, keys.size());
+}
+
+// Same as above, into shards split at points sampled from the keys.
+template <typename Container>
+void BM_ShardedInsert(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(state.range(0));
+    auto threads = static_cast<std::size_t>(state.range(1));
+    auto splits = Container::sample_splits(keys.begin(), keys.begin() + keys.size() / 16);
+    for (auto _ : state) {
+        Container container(splits.begin(), splits.end());
+        insert_from_threads(container, keys, threads);
+        benchmark::DoNotOptimize(container);
+    }
+
+    set_ops_per_iteration(state, keys.size());
+}
+
+#define BENCHMARK_SET(bench, key_type)                                                        \
+    BENCHMARK_TEMPLATE(bench, bptree::set<key_type>)->Range(1 << 10, 1 << 20);                \
+    BENCHMARK_TEMPLATE(bench, std::set<key_type>)->Range(1 << 10, 1 << 20);                   \
+    BENCHMARK_TEMPLATE(bench, sorted_vector<key_type>)->Range(1 << 10, 1 << 20)
+
+#define BENCHMARK_MAP(bench, key_type, mapped_type)                                           \
+    BENCHMARK_TEMPLATE(bench, bptree::map<key_type, mapped_type>)->Range(1 << 10, 1 << 20);   \
+    BENCHMARK_TEMPLATE(bench, std::map<key_type, mapped_type>)->Range(1 << 10, 1 << 20)
+
+BENCHMARK_TEMPLATE(BM_Insert, bptree::set<std::int32_t>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Insert, std::set<std::int32_t>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Insert, sorted_vector<std::int32_t>)->Range(1 << 10, 1 << 14);
+BENCHMARK_TEMPLATE(BM_Insert, pool_set<std::int32_t>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Insert, bptree::buffered_set<std::int32_t>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_InsertFlushed, bptree::buffered_set<std::int32_t>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Insert, bptree::persistent_set<std::int32_t>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_InsertSnapshotted, bptree::persistent_set<std::int32_t>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Erase, bptree::set<std::int64_t>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Erase, std::set<std::int64_t>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Erase, sorted_vector<std::int64_t>)->Range(1 << 10, 1 << 14);
+BENCHMARK_MAP(BM_Insert, std::int64_t, payload);
+BENCHMARK_MAP(BM_Erase, std::int64_t, payload);
+
+BENCHMARK_SET(BM_Find, std::int32_t);
+BENCHMARK_SET(BM_Find, std::int64_t);
+BENCHMARK_SET(BM_Find, double);
+BENCHMARK_MAP(BM_Find, std::int64_t, std::int64_t);
+BENCHMARK_MAP(BM_Find, std::int64_t, payload);
+BENCHMARK_TEMPLATE(BM_Find, bptree::set<std::string>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Find, std::set<std::string>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Find, bptree::set<std::string, string_less>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_FindMany, bptree::set<std::int64_t>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_FindMany, bptree::map<std::int64_t, payload>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_FindFrozen, bptree::set<std::int32_t>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_FindFrozen, bptree::set<std::int64_t>)->Range(1 << 10, 1 << 20);
+
+BENCHMARK_SET(BM_LowerBound, std::int32_t);
+BENCHMARK_SET(BM_LowerBound, std::int64_t);
+BENCHMARK_MAP(BM_LowerBound, std::int64_t, payload);
+
+BENCHMARK_SET(BM_Iterate, std::int64_t);
+BENCHMARK_MAP(BM_Iterate, std::int64_t, payload);
+BENCHMARK_TEMPLATE(BM_RangeScan, bptree::set<std::int64_t>)->Range(1 << 10, 1 << 20);
+BENCHMARK_MAP(BM_SumIterate, std::int64_t, std::int64_t);
+BENCHMARK_TEMPLATE(BM_SumSpans, bptree::map<std::int64_t, std::int64_t>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_ParallelSum, bptree::map<std::int64_t, std::int64_t>)
+    ->Ranges({{1 << 16, 1 << 22}, {1, 16}})->UseRealTime();
+
+BENCHMARK_TEMPLATE(BM_ConcurrentInsert, bptree::concurrent_set<std::int64_t>)
+    ->Ranges({{1 << 16, 1 << 20}, {1, 16}})->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ShardedInsert, bptree::sharded_set<std::int64_t, 16>)
+    ->Ranges({{1 << 16, 1 << 20}, {1, 16}})->UseRealTime();
+
+BENCHMARK_SET(BM_BulkLoad, std::int64_t);
+BENCHMARK_TEMPLATE(BM_BuildParallel, bptree::set<std::int64_t>)
+    ->Ranges({{1 << 16, 1 << 22}, {1, 16}})->UseRealTime();
+
+BENCHMARK_TEMPLATE(BM_Clear, bptree::set<std::int64_t>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Clear, pool_set<std::int64_t>)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Clear, std::set<std::int64_t>)->Range(1 << 10, 1 << 20);
@@ -0,0 +1,187 @@
+/************************************************
+ *  static_assoc_bench.cpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#include <cstddef>
+#include <cstdint>
+
+#include <functional>
+#include <set>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <bptree/internal/deny_duplicates.hpp>
+#include <bptree/internal/map_traits.hpp>
+#include <bptree/internal/set_traits.hpp>
+#include <bptree/internal/split_map_traits.hpp>
+#include <bptree/internal/static_assoc.hpp>
+#include <bptree/internal/static_split_assoc.hpp>
+
+#include "./bench_util.hpp"
+
+using bptree::internal::deny_duplicates;
+using bptree::internal::map_traits;
+using bptree::internal::set_traits;
+using bptree::internal::split_map_traits;
+using bptree::internal::static_assoc;
+using bench::payload;
+using bench::set_ops_per_iteration;
+using bench::shuffled_keys;
+using bench::sorted_vector;
+
+template <typename T, std::size_t N>
+using static_set = static_assoc<set_traits<T, std::less<T>>, deny_duplicates, N>;
+
+template <typename Key, typename T, std::size_t N>
+using static_map = static_assoc<map_traits<Key, T, std::less<Key>>, deny_duplicates, N>;
+
+template <typename Key, typename T, std::size_t N>
+using static_split_map = static_assoc<split_map_traits<Key, T, std::less<Key>>, deny_duplicates, N>;
+
+template <typename Container>
+struct capacity_of {
+    static std::size_t constexpr value = 256;
+};
+
+template <typename Traits, template <typename, typename> class Policy, std::size_t N>
+struct capacity_of<static_assoc<Traits, Policy, N>> {
+    static std::size_t constexpr value = N;
+};
+
+template <typename Container>
+using key_type_of = typename Container::key_type;
+
+template <typename Container>
+void BM_Insert(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(capacity_of<Container>::value);
+    for (auto _ : state) {
+        Container container;
+        for (auto const& key : keys) {
+            container.insert(bench::make_value<Container>(key));
+        }
+
+        benchmark::DoNotOptimize(container);
+    }
+
+    set_ops_per_iteration(state, keys.size());
+}
+
+// Half of the container is filled up front, and the other half is inserted as one batch.
+template <typename Container>
+void BM_InsertBatch(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(capacity_of<Container>::value);
+    auto middle = keys.begin() + keys.size() / 2;
+    Container filled(keys.begin(), middle);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto container = filled;
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(container.insert_batch(middle, keys.end()));
+    }
+
+    set_ops_per_iteration(state, keys.end() - middle);
+}
+
+// Same as `BM_InsertBatch`, but the batch is inserted one value at a time.
+template <typename Container>
+void BM_InsertHalf(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(capacity_of<Container>::value);
+    auto middle = keys.begin() + keys.size() / 2;
+    Container filled(keys.begin(), middle);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto container = filled;
+        state.ResumeTiming();
+
+        for (auto it = middle; it != keys.end(); ++it) {
+            benchmark::DoNotOptimize(container.insert(*it));
+        }
+    }
+
+    set_ops_per_iteration(state, keys.end() - middle);
+}
+
+template <typename Container>
+void BM_Erase(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(capacity_of<Container>::value);
+    Container filled;
+    for (auto const& key : keys) {
+        filled.insert(bench::make_value<Container>(key));
+    }
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto container = filled;
+        state.ResumeTiming();
+
+        for (auto const& key : keys) {
+            benchmark::DoNotOptimize(container.erase(key));
+        }
+    }
+
+    set_ops_per_iteration(state, keys.size());
+}
+
+// Half of the probed keys are missing from the container.
+template <typename Container>
+void BM_Find(benchmark::State& state) {
+    auto keys = shuffled_keys<key_type_of<Container>>(capacity_of<Container>::value);
+    Container container;
+    for (auto const& key : keys) {
+        container.insert(bench::make_value<Container>(key));
+    }
+
+    auto probes = shuffled_keys<key_type_of<Container>>(keys.size() * 2, 1, 7);
+    for (auto _ : state) {
+        std::size_t found = 0;
+        for (auto const& key : probes) {
+            found += container.find(key) != container.end();
+        }
+
+        benchmark::DoNotOptimize(found);
+    }
+
+    set_ops_per_iteration(state, probes.size());
+}
+
+#define BENCHMARK_STATIC_SET(bench, key_type)                                                 \
+    BENCHMARK_TEMPLATE(bench, static_set<key_type, 16>);                                      \
+    BENCHMARK_TEMPLATE(bench, static_set<key_type, 64>);                                      \
+    BENCHMARK_TEMPLATE(bench, static_set<key_type, 256>)
+
+#define BENCHMARK_STATIC_MAP(bench, key_type, mapped_type)                                    \
+    BENCHMARK_TEMPLATE(bench, static_map<key_type, mapped_type, 16>);                         \
+    BENCHMARK_TEMPLATE(bench, static_map<key_type, mapped_type, 64>);                         \
+    BENCHMARK_TEMPLATE(bench, static_map<key_type, mapped_type, 256>);                        \
+    BENCHMARK_TEMPLATE(bench, static_split_map<key_type, mapped_type, 16>);                   \
+    BENCHMARK_TEMPLATE(bench, static_split_map<key_type, mapped_type, 64>);                   \
+    BENCHMARK_TEMPLATE(bench, static_split_map<key_type, mapped_type, 256>)
+
+BENCHMARK_STATIC_SET(BM_Insert, std::int32_t);
+BENCHMARK_STATIC_SET(BM_Insert, std::int64_t);
+BENCHMARK_STATIC_SET(BM_Insert, double);
+BENCHMARK_TEMPLATE(BM_Insert, std::set<std::int64_t>);
+BENCHMARK_TEMPLATE(BM_Insert, sorted_vector<std::int64_t>);
+BENCHMARK_STATIC_MAP(BM_Insert, std::int64_t, payload);
+
+BENCHMARK_STATIC_SET(BM_InsertHalf, std::int64_t);
+BENCHMARK_STATIC_SET(BM_InsertBatch, std::int64_t);
+
+BENCHMARK_STATIC_SET(BM_Erase, std::int32_t);
+BENCHMARK_STATIC_SET(BM_Erase, std::int64_t);
+BENCHMARK_TEMPLATE(BM_Erase, std::set<std::int64_t>);
+BENCHMARK_TEMPLATE(BM_Erase, sorted_vector<std::int64_t>);
+
+BENCHMARK_STATIC_SET(BM_Find, std::int32_t);
+BENCHMARK_STATIC_SET(BM_Find, std::int64_t);
+BENCHMARK_STATIC_SET(BM_Find, double);
+BENCHMARK_TEMPLATE(BM_Find, std::set<std::int64_t>);
+BENCHMARK_TEMPLATE(BM_Find, sorted_vector<std::int64_t>);
+BENCHMARK_STATIC_MAP(BM_Find, std::int64_t, std::int64_t);
+BENCHMARK_STATIC_MAP(BM_Find, std::int64_t, payload);
@@ -0,0 +1,96 @@
+/************************************************
+ *  static_vector_bench.cpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <bptree/internal/static_vector.hpp>
+
+#include "./bench_util.hpp"
+
+using bptree::internal::static_vector;
+using bench::payload;
+using bench::set_ops_per_iteration;
+
+template <typename Container>
+struct capacity_of {
+    static std::size_t constexpr value = 256;
+};
+
+template <typename T, std::size_t N>
+struct capacity_of<static_vector<T, N>> {
+    static std::size_t constexpr value = N;
+};
+
+// Fills the container by inserting at the front, which shifts every stored value.
+template <typename Container>
+void BM_InsertFront(benchmark::State& state) {
+    auto const n = capacity_of<Container>::value;
+    for (auto _ : state) {
+        Container container;
+        for (std::size_t i = 0; i < n; ++i) {
+            container.insert(container.begin(), typename Container::value_type());
+        }
+
+        benchmark::DoNotOptimize(container.data());
+    }
+
+    set_ops_per_iteration(state, n);
+}
+
+// Drains a full container by erasing at the front.
+template <typename Container>
+void BM_EraseFront(benchmark::State& state) {
+    auto const n = capacity_of<Container>::value;
+    Container filled(n);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto container = filled;
+        state.ResumeTiming();
+
+        while (!container.empty()) {
+            container.erase(container.begin());
+        }
+
+        benchmark::DoNotOptimize(container.data());
+    }
+
+    set_ops_per_iteration(state, n);
+}
+
+template <typename Container>
+void BM_Copy(benchmark::State& state) {
+    Container filled(capacity_of<Container>::value);
+    for (auto _ : state) {
+        auto container = filled;
+        benchmark::DoNotOptimize(container.data());
+    }
+
+    set_ops_per_iteration(state, filled.size());
+}
+
+#define BENCHMARK_STATIC_VECTOR(bench, type)                                                  \
+    BENCHMARK_TEMPLATE(bench, static_vector<type, 16>);                                       \
+    BENCHMARK_TEMPLATE(bench, static_vector<type, 64>);                                       \
+    BENCHMARK_TEMPLATE(bench, static_vector<type, 256>);                                      \
+    BENCHMARK_TEMPLATE(bench, std::vector<type>)
+
+BENCHMARK_STATIC_VECTOR(BM_InsertFront, std::int32_t);
+BENCHMARK_STATIC_VECTOR(BM_InsertFront, std::int64_t);
+BENCHMARK_STATIC_VECTOR(BM_InsertFront, payload);
+
+BENCHMARK_STATIC_VECTOR(BM_EraseFront, std::int32_t);
+BENCHMARK_STATIC_VECTOR(BM_EraseFront, std::int64_t);
+BENCHMARK_STATIC_VECTOR(BM_EraseFront, payload);
+
+BENCHMARK_STATIC_VECTOR(BM_Copy, std::int64_t);
+BENCHMARK_STATIC_VECTOR(BM_Copy, payload);
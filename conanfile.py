@@ -27,6 +27,9 @@ class BPTreeConan(ConanFile):
         'include/*.hpp',
         'test/CMakeLists.txt',
         'test/*.cpp',
+        'bench/CMakeLists.txt',
+        'bench/*.hpp',
+        'bench/*.cpp',
     )
 
     def requirements(self):
@@ -9,7 +9,199 @@
 #ifndef BPTREE_BPTREE_HPP_
 #define BPTREE_BPTREE_HPP_
 
+#include <cstddef>
+
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "./internal/allow_duplicates.hpp"
+#include "./internal/buffered_tree.hpp"
+#include "./internal/concurrent_tree.hpp"
+#include "./internal/deny_duplicates.hpp"
+#include "./internal/fanout.hpp"
+#include "./internal/frozen_tree.hpp"
+#include "./internal/map_traits.hpp"
+#include "./internal/mapped_tree.hpp"
+#include "./internal/node_pool.hpp"
+#include "./internal/persistent_tree.hpp"
+#include "./internal/relocatable.hpp"
+#include "./internal/set_traits.hpp"
+#include "./internal/sharded_tree.hpp"
+#include "./internal/sorted_input.hpp"
+#include "./internal/tree.hpp"
+
 namespace bptree {
+
+using internal::cache_line_size;
+using internal::default_node_size;
+using internal::leaf_fanout;
+using internal::inner_fanout;
+using internal::ranked_inner_fanout;
+using internal::block_fanout;
+using internal::pool_allocator;
+using internal::sorted_input_t;
+using internal::sorted_input;
+using internal::build_parallel;
+
+// The default fanouts fill nodes of `default_node_size` bytes. To target another node size (e.g.
+// a page), pass `leaf_fanout<value_type>(size)` and `inner_fanout<key_type>(size)` explicitly.
+//
+// Nodes are obtained from `Allocator` rebound to the node types. With `pool_allocator`, they are
+// carved from slabs and `clear()` hands the whole tree back at once.
+
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          std::size_t LeafN = leaf_fanout<std::pair<Key const, T>>(),
+          std::size_t InnerN = inner_fanout<Key>(),
+          typename Allocator = std::allocator<std::pair<Key const, T>>>
+using map = internal::tree<
+    internal::map_traits<Key, T, Compare>, internal::deny_duplicates, LeafN, InnerN, Allocator
+>;
+
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          std::size_t LeafN = leaf_fanout<std::pair<Key const, T>>(),
+          std::size_t InnerN = inner_fanout<Key>(),
+          typename Allocator = std::allocator<std::pair<Key const, T>>>
+using multimap = internal::tree<
+    internal::map_traits<Key, T, Compare>, internal::allow_duplicates, LeafN, InnerN, Allocator
+>;
+
+template <typename Key, typename Compare = std::less<Key>,
+          std::size_t LeafN = leaf_fanout<Key>(), std::size_t InnerN = inner_fanout<Key>(),
+          typename Allocator = std::allocator<Key>>
+using set = internal::tree<
+    internal::set_traits<Key, Compare>, internal::deny_duplicates, LeafN, InnerN, Allocator
+>;
+
+template <typename Key, typename Compare = std::less<Key>,
+          std::size_t LeafN = leaf_fanout<Key>(), std::size_t InnerN = inner_fanout<Key>(),
+          typename Allocator = std::allocator<Key>>
+using multiset = internal::tree<
+    internal::set_traits<Key, Compare>, internal::allow_duplicates, LeafN, InnerN, Allocator
+>;
+
+// Ranked variants, whose inner nodes also count the values below each child, so that `nth()`,
+// `rank()` and `index_of()` take logarithmic time. Inserting and erasing update the counts along
+// the path to the root.
+
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          std::size_t LeafN = leaf_fanout<std::pair<Key const, T>>(),
+          std::size_t InnerN = ranked_inner_fanout<Key>(),
+          typename Allocator = std::allocator<std::pair<Key const, T>>>
+using ranked_map = internal::tree<
+    internal::map_traits<Key, T, Compare>, internal::deny_duplicates, LeafN, InnerN, Allocator,
+    true
+>;
+
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          std::size_t LeafN = leaf_fanout<std::pair<Key const, T>>(),
+          std::size_t InnerN = ranked_inner_fanout<Key>(),
+          typename Allocator = std::allocator<std::pair<Key const, T>>>
+using ranked_multimap = internal::tree<
+    internal::map_traits<Key, T, Compare>, internal::allow_duplicates, LeafN, InnerN, Allocator,
+    true
+>;
+
+template <typename Key, typename Compare = std::less<Key>,
+          std::size_t LeafN = leaf_fanout<Key>(), std::size_t InnerN = ranked_inner_fanout<Key>(),
+          typename Allocator = std::allocator<Key>>
+using ranked_set = internal::tree<
+    internal::set_traits<Key, Compare>, internal::deny_duplicates, LeafN, InnerN, Allocator, true
+>;
+
+template <typename Key, typename Compare = std::less<Key>,
+          std::size_t LeafN = leaf_fanout<Key>(), std::size_t InnerN = ranked_inner_fanout<Key>(),
+          typename Allocator = std::allocator<Key>>
+using ranked_multiset = internal::tree<
+    internal::set_traits<Key, Compare>, internal::allow_duplicates, LeafN, InnerN, Allocator, true
+>;
+
+// Concurrent variants, safe to read and write from any number of threads. Keys and values must be
+// trivially copyable.
+
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          std::size_t LeafN = leaf_fanout<std::pair<Key const, T>>(),
+          std::size_t InnerN = inner_fanout<Key>()>
+using concurrent_map = internal::concurrent_tree<
+    internal::map_traits<Key, T, Compare>, LeafN, InnerN
+>;
+
+template <typename Key, typename Compare = std::less<Key>,
+          std::size_t LeafN = leaf_fanout<Key>(), std::size_t InnerN = inner_fanout<Key>()>
+using concurrent_set = internal::concurrent_tree<
+    internal::set_traits<Key, Compare>, LeafN, InnerN
+>;
+
+// Sharded variants, which range-partition the keys over `Shards` independent trees, each behind
+// its own lock, so that writers to different key ranges do not contend.
+
+template <typename Key, typename T, std::size_t Shards = 8, typename Compare = std::less<Key>,
+          std::size_t LeafN = leaf_fanout<std::pair<Key const, T>>(),
+          std::size_t InnerN = inner_fanout<Key>()>
+using sharded_map = internal::sharded_tree<
+    internal::map_traits<Key, T, Compare>, Shards, LeafN, InnerN
+>;
+
+template <typename Key, std::size_t Shards = 8, typename Compare = std::less<Key>,
+          std::size_t LeafN = leaf_fanout<Key>(), std::size_t InnerN = inner_fanout<Key>()>
+using sharded_set = internal::sharded_tree<
+    internal::set_traits<Key, Compare>, Shards, LeafN, InnerN
+>;
+
+// Immutable variants in an implicit layout, built from sorted values or by `freeze()`.
+
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          std::size_t B = block_fanout<Key>()>
+using frozen_map = internal::frozen_tree<internal::map_traits<Key, T, Compare>, B>;
+
+template <typename Key, typename Compare = std::less<Key>, std::size_t B = block_fanout<Key>()>
+using frozen_set = internal::frozen_tree<internal::set_traits<Key, Compare>, B>;
+
+// Write-optimized variants, which queue writes in the buffers of inner nodes and apply them to
+// the leaves in batches. By default, a buffer holds about as many values as four leaves.
+
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          std::size_t LeafN = leaf_fanout<std::pair<Key const, T>>(),
+          std::size_t InnerN = inner_fanout<Key>(),
+          std::size_t BufferN = leaf_fanout<std::pair<Key const, T>>(4 * default_node_size)>
+using buffered_map = internal::buffered_tree<
+    internal::map_traits<Key, T, Compare>, LeafN, InnerN, BufferN
+>;
+
+template <typename Key, typename Compare = std::less<Key>,
+          std::size_t LeafN = leaf_fanout<Key>(), std::size_t InnerN = inner_fanout<Key>(),
+          std::size_t BufferN = leaf_fanout<Key>(4 * default_node_size)>
+using buffered_set = internal::buffered_tree<
+    internal::set_traits<Key, Compare>, LeafN, InnerN, BufferN
+>;
+
+// Persistent variants, whose `snapshot()` takes an immutable, point-in-time view in constant time
+// by sharing nodes with the tree. Writes copy the shared nodes on their path. Snapshots may be read
+// from other threads while the tree changes.
+
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          std::size_t LeafN = leaf_fanout<std::pair<Key const, T>>(),
+          std::size_t InnerN = inner_fanout<Key>()>
+using persistent_map = internal::persistent_tree<
+    internal::map_traits<Key, T, Compare>, LeafN, InnerN
+>;
+
+template <typename Key, typename Compare = std::less<Key>,
+          std::size_t LeafN = leaf_fanout<Key>(), std::size_t InnerN = inner_fanout<Key>()>
+using persistent_set = internal::persistent_tree<
+    internal::set_traits<Key, Compare>, LeafN, InnerN
+>;
+
+// Read-only variants served from a memory-mapped file, which `write` creates from sorted values.
+// Keys and values must be trivially copyable.
+
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          std::size_t PageSize = 4096>
+using mapped_map = internal::mapped_tree<internal::map_traits<Key, T, Compare>, PageSize>;
+
+template <typename Key, typename Compare = std::less<Key>, std::size_t PageSize = 4096>
+using mapped_set = internal::mapped_tree<internal::set_traits<Key, Compare>, PageSize>;
+
 }  // namespace bptree
 
 #endif  // BPTREE_BPTREE_HPP_
@@ -25,6 +25,13 @@ struct allow_duplicates {
     using insert_result_t = typename Container::iterator;
 
  public:  // Public Method(s)
+    template <typename V>
+    static bool is_insertable(
+            Container const& c, Compare compare, typename Container::const_iterator pos,
+            V const& value);
+    template <typename P, typename V>
+    static bool is_insertable_after(Compare compare, P const& prev, V const& value);
+
     template <typename V>
     static insert_result_t try_insert(  // NOLINTNEXTLINE(runtime/references)
             Container& c, Compare compare, typename Container::const_iterator pos, V&& value);
@@ -38,6 +45,20 @@ struct allow_duplicates {
  * Implementation: struct allow_duplicates<Container, Compare>
  ************************************************/
 
+template <typename Container, typename Compare>
+template <typename V>
+inline bool allow_duplicates<Container, Compare>::is_insertable(
+        Container const&, Compare, typename Container::const_iterator, V const&) {
+    return true;
+}
+
+template <typename Container, typename Compare>
+template <typename P, typename V>
+inline bool allow_duplicates<Container, Compare>::is_insertable_after(
+        Compare, P const&, V const&) {
+    return true;
+}
+
 template <typename Container, typename Compare>
 template <typename V>
 inline typename allow_duplicates<Container, Compare>::insert_result_t
@@ -0,0 +1,492 @@
+/************************************************
+ *  buffered_node.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_BUFFERED_NODE_HPP_
+#define BPTREE_INTERNAL_BUFFERED_NODE_HPP_
+
+#include <cstddef>
+
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "./allow_duplicates.hpp"
+#include "./deny_duplicates.hpp"
+#include "./map_traits.hpp"
+#include "./relocatable.hpp"
+#include "./search.hpp"
+#include "./static_assoc.hpp"
+#include "./static_vector.hpp"
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: enum class message_kind
+ ************************************************/
+
+enum class message_kind : unsigned char {
+    insert,  // insert the value unless its key is present
+    assign,  // insert the value, replacing the one of the same key if present
+    erase    // erase the value of the key if present
+};
+
+/************************************************
+ * Declaration: class buffer_message<T>
+ ************************************************/
+
+// Pending write to a single key, held in the buffer of an inner node of `buffered_tree`. Erase
+// messages carry no value.
+template <typename ValueTraits>
+class buffer_message {
+ public:  // Public Type(s)
+    using key_type = typename ValueTraits::key_type;
+    using value_type = typename ValueTraits::value_type;
+
+ public:  // Public Method(s)
+    buffer_message(message_kind kind, value_type const& value);
+    explicit buffer_message(key_type const& key);
+    buffer_message(buffer_message const& other);
+    buffer_message(buffer_message&& other);
+    ~buffer_message();
+
+    buffer_message& operator=(buffer_message const& other);
+    buffer_message& operator=(buffer_message&& other);
+
+    message_kind kind() const noexcept;
+    key_type const& key() const noexcept;
+    value_type const& value() const noexcept;
+
+    void combine(buffer_message&& newer);
+
+ private:  // Private Method(s)
+    bool has_value() const noexcept;
+    void construct_empty(std::true_type) noexcept;
+    void construct_empty(std::false_type) noexcept;
+    void reset() noexcept;
+
+ private:  // Private Property(ies)
+    message_kind kind_;
+    key_type key_;
+    union {
+        value_type value_;  // alive unless the message is an erase
+    };
+};
+
+/************************************************
+ * Declaration: struct message_traits<T>
+ ************************************************/
+
+// Orders the messages of a buffer by key, like `map_traits` orders its pairs.
+template <typename ValueTraits>
+struct message_traits {
+ public:  // Public Type(s)
+    using key_type = typename ValueTraits::key_type;
+    using value_type = buffer_message<ValueTraits>;
+
+    using key_compare = typename ValueTraits::key_compare;
+
+    template <std::size_t N>
+    using storage_type = static_vector<value_type, N>;
+
+    class value_compare : protected key_compare {
+     protected:  // Protected Method(s)
+        explicit value_compare(key_compare comp)
+          : key_compare(comp)
+            { /* do nothing */ }
+
+     public:  // Public Method(s)
+        bool operator()(value_type const& lhs, value_type const& rhs) const {
+            return key_compare::operator()(lhs.key(), rhs.key());
+        }
+    };
+
+ protected:  // Protected Type(s)
+    class core_compare {
+     public:  // Public Method(s)
+        explicit core_compare(key_compare comp)
+          : comp_(comp)
+            { /* do nothing */ }
+
+        template <typename K>
+        bool operator()(K const& lhs, value_type const& rhs) const {
+            return comp_(lhs, rhs.key());
+        }
+
+        template <typename K>
+        bool operator()(value_type const& lhs, K const& rhs) const {
+            return comp_(lhs.key(), rhs);
+        }
+
+     private:  // Private Method(s)
+        key_compare comp_;
+    };
+
+ public:  // Static Public Method(s)
+    static key_type const& get_key(value_type const& value) noexcept {
+        return value.key();
+    }
+};
+
+/************************************************
+ * Declaration: class buffered_node
+ ************************************************/
+
+// Common part of the nodes of `buffered_tree`.
+class buffered_node {
+ public:  // Public Type(s)
+    using size_type = std::size_t;
+
+ public:  // Public Method(s)
+    explicit buffered_node(size_type level) noexcept;
+
+    size_type level() const noexcept;
+    bool is_leaf() const noexcept;
+
+ private:  // Private Property(ies)
+    size_type level_;
+};
+
+/************************************************
+ * Declaration: class buffered_inner_node<T, N, B>
+ ************************************************/
+
+// Laid out like `inner_node`, plus a buffer of up to `B` messages bound for the subtree, at most
+// one per key and sorted by key.
+template <typename ValueTraits, std::size_t N, std::size_t B>
+class buffered_inner_node
+  : public buffered_node,
+    public static_assoc<
+        map_traits<typename ValueTraits::key_type, buffered_node*,
+                   typename ValueTraits::key_compare>,
+        allow_duplicates, N
+    > {
+ private:  // Private Type(s)
+    using child_traits = map_traits<
+        typename ValueTraits::key_type, buffered_node*, typename ValueTraits::key_compare
+    >;
+    using base_t = static_assoc<child_traits, allow_duplicates, N>;
+    using search_kernel_type = search_kernel<child_traits, N>;
+
+ public:  // Public Type(s)
+    using key_type = typename base_t::key_type;
+    using key_compare = typename base_t::key_compare;
+    using size_type = typename base_t::size_type;
+    using buffer_type = static_assoc<message_traits<ValueTraits>, deny_duplicates, B>;
+
+ public:  // Public Method(s)
+    buffered_inner_node(size_type level, key_compare const& comp);
+
+    buffered_node* child(size_type pos) const;
+    key_type const& key(size_type pos) const;
+    key_type const& first_key() const;
+    template <typename K>
+    size_type upper_child(K const& key) const;
+
+    buffer_type& buffer() noexcept;
+    buffer_type const& buffer() const noexcept;
+
+    void insert_child(size_type pos, key_type const& key, buffered_node* child);
+    void split_into(buffered_inner_node& right);
+
+ private:  // Private Property(ies)
+    buffer_type buffer_;
+};
+
+/************************************************
+ * Declaration: class buffered_leaf_node<T, N>
+ ************************************************/
+
+template <typename ValueTraits, std::size_t N>
+class buffered_leaf_node
+  : public buffered_node,
+    public static_assoc<ValueTraits, deny_duplicates, N> {
+ private:  // Private Type(s)
+    using base_t = static_assoc<ValueTraits, deny_duplicates, N>;
+
+ public:  // Public Type(s)
+    using key_type = typename base_t::key_type;
+    using key_compare = typename base_t::key_compare;
+
+ public:  // Public Method(s)
+    explicit buffered_leaf_node(key_compare const& comp);
+
+    key_type const& first_key() const;
+    buffered_leaf_node* next_leaf() const noexcept;
+
+    void split_into(buffered_leaf_node& right);
+
+ private:  // Private Property(ies)
+    buffered_leaf_node* next_;
+};
+
+/************************************************
+ * Implementation: class buffer_message<T>
+ ************************************************/
+
+template <typename T>
+inline buffer_message<T>::buffer_message(message_kind kind, value_type const& value)
+  : kind_(kind), key_(T::get_key(value)), value_(value) {
+    // do nothing
+}
+
+template <typename T>
+inline buffer_message<T>::buffer_message(key_type const& key)
+  : kind_(message_kind::erase), key_(key) {
+    construct_empty(std::is_trivial<value_type>());
+}
+
+template <typename T>
+inline buffer_message<T>::buffer_message(buffer_message const& other)
+  : kind_(other.kind_), key_(other.key_) {
+    if (has_value()) {
+        new (&value_) value_type(other.value_);
+    } else {
+        construct_empty(std::is_trivial<value_type>());
+    }
+}
+
+template <typename T>
+inline buffer_message<T>::buffer_message(buffer_message&& other)
+  : kind_(other.kind_), key_(std::move(other.key_)) {
+    if (has_value()) {
+        new (&value_) value_type(std::move(other.value_));
+    } else {
+        construct_empty(std::is_trivial<value_type>());
+    }
+}
+
+template <typename T>
+inline buffer_message<T>::~buffer_message() {
+    reset();
+}
+
+template <typename T>
+inline buffer_message<T>& buffer_message<T>::operator=(buffer_message const& other) {
+    if (this != &other) {
+        reset();
+        kind_ = other.kind_;
+        key_ = other.key_;
+        if (has_value()) {
+            new (&value_) value_type(other.value_);
+        }
+    }
+
+    return *this;
+}
+
+template <typename T>
+inline buffer_message<T>& buffer_message<T>::operator=(buffer_message&& other) {
+    if (this != &other) {
+        reset();
+        kind_ = other.kind_;
+        key_ = std::move(other.key_);
+        if (has_value()) {
+            new (&value_) value_type(std::move(other.value_));
+        }
+    }
+
+    return *this;
+}
+
+template <typename T>
+inline message_kind buffer_message<T>::kind() const noexcept {
+    return kind_;
+}
+
+template <typename T>
+inline typename buffer_message<T>::key_type const& buffer_message<T>::key() const noexcept {
+    return key_;
+}
+
+template <typename T>
+inline typename buffer_message<T>::value_type const& buffer_message<T>::value() const noexcept {
+    return value_;
+}
+
+// Folds a newer message for the same key into this one, so that applying the result has the same
+// effect as applying this message and then `newer`.
+template <typename T>
+void buffer_message<T>::combine(buffer_message&& newer) {
+    if (newer.kind_ == message_kind::insert) {
+        if (kind_ != message_kind::erase) {
+            return;  // the key is present by the time `newer` applies
+        }
+
+        newer.kind_ = message_kind::assign;
+    }
+
+    *this = std::move(newer);
+}
+
+template <typename T>
+inline bool buffer_message<T>::has_value() const noexcept {
+    return kind_ != message_kind::erase;
+}
+
+// Value-initializes the unused value of an erase message if that is trivial, so that the compiler
+// never sees a copy of the message read indeterminate memory.
+template <typename T>
+inline void buffer_message<T>::construct_empty(std::true_type) noexcept {
+    new (&value_) value_type();
+}
+
+template <typename T>
+inline void buffer_message<T>::construct_empty(std::false_type) noexcept {
+    // do nothing
+}
+
+template <typename T>
+inline void buffer_message<T>::reset() noexcept {
+    if (has_value()) {
+        value_.~value_type();
+        kind_ = message_kind::erase;
+    }
+}
+
+/************************************************
+ * Implementation: class buffered_node
+ ************************************************/
+
+inline buffered_node::buffered_node(size_type level) noexcept
+  : level_(level) {
+    // do nothing
+}
+
+inline buffered_node::size_type buffered_node::level() const noexcept {
+    return level_;
+}
+
+inline bool buffered_node::is_leaf() const noexcept {
+    return level_ == 0;
+}
+
+/************************************************
+ * Implementation: class buffered_inner_node<T, N, B>
+ ************************************************/
+
+template <typename T, std::size_t N, std::size_t B>
+inline buffered_inner_node<T, N, B>::buffered_inner_node(size_type level, key_compare const& comp)
+  : buffered_node(level), base_t(comp), buffer_(comp) {
+    // do nothing
+}
+
+template <typename T, std::size_t N, std::size_t B>
+inline buffered_node* buffered_inner_node<T, N, B>::child(size_type pos) const {
+    return this->values()[pos].second;
+}
+
+template <typename T, std::size_t N, std::size_t B>
+inline typename buffered_inner_node<T, N, B>::key_type const&
+buffered_inner_node<T, N, B>::key(size_type pos) const {
+    return this->values()[pos].first;
+}
+
+template <typename T, std::size_t N, std::size_t B>
+inline typename buffered_inner_node<T, N, B>::key_type const&
+buffered_inner_node<T, N, B>::first_key() const {
+    return key(0);
+}
+
+template <typename T, std::size_t N, std::size_t B>
+template <typename K>
+inline typename buffered_inner_node<T, N, B>::size_type
+buffered_inner_node<T, N, B>::upper_child(K const& key) const {
+    auto first = this->cbegin() + 1;
+    auto it = search_kernel_type::upper_bound(first, this->cend(), key, this->core_comp());
+    return it - first;
+}
+
+template <typename T, std::size_t N, std::size_t B>
+inline typename buffered_inner_node<T, N, B>::buffer_type&
+buffered_inner_node<T, N, B>::buffer() noexcept {
+    return buffer_;
+}
+
+template <typename T, std::size_t N, std::size_t B>
+inline typename buffered_inner_node<T, N, B>::buffer_type const&
+buffered_inner_node<T, N, B>::buffer() const noexcept {
+    return buffer_;
+}
+
+template <typename T, std::size_t N, std::size_t B>
+inline void buffered_inner_node<T, N, B>::insert_child(size_type pos, key_type const& key,
+                                                       buffered_node* child) {
+    auto& values = this->values();
+    values.emplace(values.cbegin() + pos, key, child);
+}
+
+// Moves the upper half of the children to `right`, along with the messages bound for them.
+template <typename T, std::size_t N, std::size_t B>
+void buffered_inner_node<T, N, B>::split_into(buffered_inner_node& right) {
+    auto& values = this->values();
+    auto mid = values.data() + (values.size() + 1) / 2;
+    auto last = values.data() + values.size();
+
+    auto& right_values = right.values();
+    right_values.insert(right_values.cend(),
+                        std::make_move_iterator(mid), std::make_move_iterator(last));
+    values.erase(values.cbegin() + (mid - values.data()), values.cend());
+
+    auto it = buffer_.lower_bound(right.first_key());
+    right.buffer_.insert(std::make_move_iterator(it), std::make_move_iterator(buffer_.end()));
+    buffer_.erase(it, buffer_.cend());
+}
+
+/************************************************
+ * Implementation: class buffered_leaf_node<T, N>
+ ************************************************/
+
+template <typename T, std::size_t N>
+inline buffered_leaf_node<T, N>::buffered_leaf_node(key_compare const& comp)
+  : buffered_node(0), base_t(comp), next_(nullptr) {
+    // do nothing
+}
+
+template <typename T, std::size_t N>
+inline typename buffered_leaf_node<T, N>::key_type const&
+buffered_leaf_node<T, N>::first_key() const {
+    return T::get_key(this->values().front());
+}
+
+template <typename T, std::size_t N>
+inline buffered_leaf_node<T, N>* buffered_leaf_node<T, N>::next_leaf() const noexcept {
+    return next_;
+}
+
+template <typename T, std::size_t N>
+void buffered_leaf_node<T, N>::split_into(buffered_leaf_node& right) {
+    auto& values = this->values();
+    auto mid = values.data() + (values.size() + 1) / 2;
+    auto last = values.data() + values.size();
+
+    auto& right_values = right.values();
+    right_values.insert(right_values.cend(),
+                        std::make_move_iterator(mid), std::make_move_iterator(last));
+    values.erase(values.cbegin() + (mid - values.data()), values.cend());
+
+    right.next_ = next_;
+    next_ = &right;
+}
+
+}  // namespace internal
+
+// Messages hold no pointers into themselves, so they relocate as trivially as their contents.
+template <typename ValueTraits>
+struct is_trivially_relocatable<internal::buffer_message<ValueTraits>>
+  : std::integral_constant<
+        bool,
+        is_trivially_relocatable<typename ValueTraits::key_type>::value &&
+            is_trivially_relocatable<typename ValueTraits::value_type>::value
+    > {};
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_BUFFERED_NODE_HPP_
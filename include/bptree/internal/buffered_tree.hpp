@@ -0,0 +1,403 @@
+/************************************************
+ *  buffered_tree.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_BUFFERED_TREE_HPP_
+#define BPTREE_INTERNAL_BUFFERED_TREE_HPP_
+
+#include <cstddef>
+
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include "./buffered_node.hpp"
+#include "./static_vector.hpp"
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: class buffered_tree<T, M, N, B>
+ ************************************************/
+
+// Write-optimized B+ tree in the style of a B^epsilon tree: writes are queued as messages in the
+// buffer of the root, and a full buffer flushes the messages bound for its busiest child in one
+// batch, so that a write costs a fraction of a leaf access on average. Lookups merge the messages
+// met on the way down with the contents of the leaf.
+//
+// Since the effect of a write is only known once it reaches a leaf, `insert` and `erase` do not
+// report it. Counting and visiting the values first flush every pending message to the leaves.
+// Leaves emptied by `erase` stay in the tree and are only freed along with it.
+template <typename ValueTraits, std::size_t LeafN, std::size_t InnerN, std::size_t BufferN>
+class buffered_tree {
+    static_assert(LeafN >= 2, "leaf nodes must be able to hold at least 2 values");
+    static_assert(InnerN >= 4, "inner nodes must be able to hold at least 4 children");
+    static_assert(BufferN >= 1, "inner nodes must be able to buffer at least 1 message");
+
+ private:  // Private Type(s)
+    using value_traits = ValueTraits;
+    using node_type = buffered_node;
+    using inner_node_type = buffered_inner_node<ValueTraits, InnerN, BufferN>;
+    using leaf_node_type = buffered_leaf_node<ValueTraits, LeafN>;
+    using message_type = buffer_message<ValueTraits>;
+    using batch_type = static_vector<message_type, BufferN>;
+
+ public:  // Public Type(s)
+    using key_type = typename value_traits::key_type;
+    using value_type = typename value_traits::value_type;
+    using key_compare = typename value_traits::key_compare;
+    using size_type = std::size_t;
+
+ public:  // Public Method(s)
+    explicit buffered_tree(key_compare const& comp = key_compare());
+    buffered_tree(buffered_tree const&) = delete;
+    ~buffered_tree();
+
+    buffered_tree& operator=(buffered_tree const&) = delete;
+
+    void insert(value_type const& value);
+    void erase(key_type const& key);
+    void flush();
+
+    template <typename F>
+    bool find(key_type const& key, F f) const;
+    bool contains(key_type const& key) const;
+    template <typename F>
+    void for_each(F f);
+
+    bool empty();
+    size_type size();
+    size_type pending() const noexcept;
+    size_type height() const noexcept;
+    key_compare key_comp() const;
+
+ private:  // Private Method(s)
+    void put(message_type&& message);
+    node_type* push(node_type* node, message_type&& message);
+    node_type* apply(leaf_node_type* leaf, message_type&& message);
+    node_type* flush(inner_node_type* inner);
+    node_type* drain(node_type* node);
+    node_type* split(inner_node_type* inner);
+    void grow(node_type* right);
+
+    static key_type const& first_key(node_type const* node);
+    static void destroy(node_type* node) noexcept;
+
+ private:  // Private Property(ies)
+    key_compare comp_;
+    node_type* root_;
+    size_type size_;
+    size_type pending_;
+};
+
+/************************************************
+ * Implementation: class buffered_tree<T, M, N, B>
+ ************************************************/
+
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+inline buffered_tree<T, M, N, B>::buffered_tree(key_compare const& comp)
+  : comp_(comp), root_(new leaf_node_type(comp)), size_(0), pending_(0) {
+    // do nothing
+}
+
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+inline buffered_tree<T, M, N, B>::~buffered_tree() {
+    destroy(root_);
+}
+
+// Inserts `value` unless its key is present by the time the message reaches a leaf.
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+inline void buffered_tree<T, M, N, B>::insert(value_type const& value) {
+    put(message_type(message_kind::insert, value));
+}
+
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+inline void buffered_tree<T, M, N, B>::erase(key_type const& key) {
+    put(message_type(key));
+}
+
+// Applies every pending message to the leaves.
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+void buffered_tree<T, M, N, B>::flush() {
+    while (pending_ > 0) {
+        if (auto right = drain(root_)) {
+            grow(right);
+        }
+    }
+}
+
+// Calls `f` with the value of `key` and returns whether there was one. The messages met on the way
+// down are newer than anything below them, so the first erase or assign decides the outcome, while
+// an insert only does if the key turns out to be absent further down.
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+template <typename F>
+bool buffered_tree<T, M, N, B>::find(key_type const& key, F f) const {
+    message_type const* inserted = nullptr;
+    node_type const* node = root_;
+    while (!node->is_leaf()) {
+        auto inner = static_cast<inner_node_type const*>(node);
+        auto const& buffer = inner->buffer();
+        auto it = buffer.find(key);
+        if (it != buffer.cend()) {
+            if (it->kind() == message_kind::erase) {
+                break;
+            } else if (it->kind() == message_kind::assign) {
+                f(it->value());
+                return true;
+            }
+
+            inserted = &*it;
+        }
+
+        node = inner->child(inner->upper_child(key));
+    }
+
+    if (node->is_leaf()) {
+        auto leaf = static_cast<leaf_node_type const*>(node);
+        auto it = leaf->find(key);
+        if (it != leaf->cend()) {
+            f(*it);
+            return true;
+        }
+    }
+
+    if (inserted) {
+        f(inserted->value());
+        return true;
+    }
+
+    return false;
+}
+
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+inline bool buffered_tree<T, M, N, B>::contains(key_type const& key) const {
+    return find(key, [](value_type const&) {});
+}
+
+// Flushes the pending messages, then calls `f` with each value in order.
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+template <typename F>
+void buffered_tree<T, M, N, B>::for_each(F f) {
+    flush();
+
+    auto node = root_;
+    while (!node->is_leaf()) {
+        node = static_cast<inner_node_type*>(node)->child(0);
+    }
+
+    for (auto leaf = static_cast<leaf_node_type const*>(node); leaf; leaf = leaf->next_leaf()) {
+        for (auto const& value : *leaf) {
+            f(value);
+        }
+    }
+}
+
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+inline bool buffered_tree<T, M, N, B>::empty() {
+    return size() == 0;
+}
+
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+inline typename buffered_tree<T, M, N, B>::size_type buffered_tree<T, M, N, B>::size() {
+    flush();
+    return size_;
+}
+
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+inline typename buffered_tree<T, M, N, B>::size_type
+buffered_tree<T, M, N, B>::pending() const noexcept {
+    return pending_;
+}
+
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+inline typename buffered_tree<T, M, N, B>::size_type
+buffered_tree<T, M, N, B>::height() const noexcept {
+    return root_->level() + 1;
+}
+
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+inline typename buffered_tree<T, M, N, B>::key_compare buffered_tree<T, M, N, B>::key_comp() const {
+    return comp_;
+}
+
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+inline void buffered_tree<T, M, N, B>::put(message_type&& message) {
+    ++pending_;
+    if (auto right = push(root_, std::move(message))) {
+        grow(right);
+    }
+}
+
+// Delivers `message` to `node`, and returns the new right sibling of `node` if it had to be split.
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+typename buffered_tree<T, M, N, B>::node_type*
+buffered_tree<T, M, N, B>::push(node_type* node, message_type&& message) {
+    if (node->is_leaf()) {
+        return apply(static_cast<leaf_node_type*>(node), std::move(message));
+    }
+
+    auto inner = static_cast<inner_node_type*>(node);
+    auto& buffer = inner->buffer();
+    auto it = buffer.find(message.key());
+    if (it != buffer.end()) {
+        it->combine(std::move(message));
+        --pending_;
+        return nullptr;
+    }
+
+    buffer.insert(std::move(message));
+    return buffer.full() ? flush(inner) : nullptr;
+}
+
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+typename buffered_tree<T, M, N, B>::node_type*
+buffered_tree<T, M, N, B>::apply(leaf_node_type* leaf, message_type&& message) {
+    --pending_;
+
+    auto const& key = message.key();
+    if (message.kind() == message_kind::erase) {
+        size_ -= leaf->erase(key);
+        return nullptr;
+    }
+
+    auto it = leaf->find(key);
+    if (it != leaf->end()) {
+        if (message.kind() == message_kind::assign) {
+            leaf->insert(leaf->erase(it), message.value());
+        }
+
+        return nullptr;
+    }
+
+    ++size_;
+    if (!leaf->full()) {
+        leaf->insert(message.value());
+        return nullptr;
+    }
+
+    std::unique_ptr<leaf_node_type> right(new leaf_node_type(comp_));
+    leaf->split_into(*right);
+    (comp_(key, right->first_key()) ? leaf : right.get())->insert(message.value());
+    return right.release();
+}
+
+// Moves the messages bound for the child that most of the buffer is bound for down to it. Should
+// the node fill up with the children split off meanwhile, the rest of the batch goes back to the
+// buffer and the node is split.
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+typename buffered_tree<T, M, N, B>::node_type*
+buffered_tree<T, M, N, B>::flush(inner_node_type* inner) {
+    auto& buffer = inner->buffer();
+    auto first = buffer.begin();
+    auto last = first;
+    for (auto it = buffer.begin(); it != buffer.end();) {
+        auto pos = inner->upper_child(it->key());
+        auto run_last = pos + 1 < inner->size() ? buffer.lower_bound(inner->key(pos + 1))
+                                                : buffer.end();
+        if (run_last - it > last - first) {
+            first = it;
+            last = run_last;
+        }
+
+        it = run_last;
+    }
+
+    batch_type batch(std::make_move_iterator(first), std::make_move_iterator(last));
+    buffer.erase(first, last);
+
+    for (auto it = batch.begin(); it != batch.end(); ++it) {
+        auto pos = inner->upper_child(it->key());
+        auto right = push(inner->child(pos), std::move(*it));
+        if (!right) {
+            continue;
+        }
+
+        inner->insert_child(pos + 1, first_key(right), right);
+        if (inner->full()) {
+            buffer.insert(std::make_move_iterator(it + 1), std::make_move_iterator(batch.end()));
+            return split(inner);
+        }
+    }
+
+    return nullptr;
+}
+
+// Flushes the buffers of the subtree of `node` down to its leaves, unless a split interrupts it.
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+typename buffered_tree<T, M, N, B>::node_type* buffered_tree<T, M, N, B>::drain(node_type* node) {
+    if (node->is_leaf()) {
+        return nullptr;
+    }
+
+    auto inner = static_cast<inner_node_type*>(node);
+    while (!inner->buffer().empty()) {
+        if (auto right = flush(inner)) {
+            return right;
+        }
+    }
+
+    for (size_type pos = 0; pos < inner->size();) {
+        auto right = drain(inner->child(pos));
+        if (!right) {
+            ++pos;
+            continue;
+        }
+
+        inner->insert_child(pos + 1, first_key(right), right);
+        if (inner->full()) {
+            return split(inner);
+        }
+    }
+
+    return nullptr;
+}
+
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+typename buffered_tree<T, M, N, B>::node_type*
+buffered_tree<T, M, N, B>::split(inner_node_type* inner) {
+    auto right = new inner_node_type(inner->level(), comp_);
+    inner->split_into(*right);
+    return right;
+}
+
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+void buffered_tree<T, M, N, B>::grow(node_type* right) {
+    std::unique_ptr<inner_node_type> root(new inner_node_type(root_->level() + 1, comp_));
+    root->insert_child(0, first_key(right), root_);
+    root->insert_child(1, first_key(right), right);
+    root_ = root.release();
+}
+
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+inline typename buffered_tree<T, M, N, B>::key_type const&
+buffered_tree<T, M, N, B>::first_key(node_type const* node) {
+    return node->is_leaf() ? static_cast<leaf_node_type const*>(node)->first_key()
+                           : static_cast<inner_node_type const*>(node)->first_key();
+}
+
+template <typename T, std::size_t M, std::size_t N, std::size_t B>
+void buffered_tree<T, M, N, B>::destroy(node_type* node) noexcept {
+    if (node->is_leaf()) {
+        delete static_cast<leaf_node_type*>(node);
+        return;
+    }
+
+    auto inner = static_cast<inner_node_type*>(node);
+    for (size_type i = 0; i < inner->size(); ++i) {
+        destroy(inner->child(i));
+    }
+
+    delete inner;
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_BUFFERED_TREE_HPP_
@@ -0,0 +1,229 @@
+/************************************************
+ *  concurrent_node.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_CONCURRENT_NODE_HPP_
+#define BPTREE_INTERNAL_CONCURRENT_NODE_HPP_
+
+#include <cstddef>
+
+#include <iterator>
+#include <utility>
+
+#include "./allow_duplicates.hpp"
+#include "./deny_duplicates.hpp"
+#include "./map_traits.hpp"
+#include "./search.hpp"
+#include "./static_assoc.hpp"
+#include "./version_lock.hpp"
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: class concurrent_node
+ ************************************************/
+
+// Common part of the nodes of `concurrent_tree`. The level of a node (0 for leaves) never changes,
+// so it can be read without validation.
+class concurrent_node {
+ public:  // Public Type(s)
+    using size_type = std::size_t;
+
+ public:  // Public Method(s)
+    explicit concurrent_node(size_type level) noexcept;
+
+    size_type level() const noexcept;
+    bool is_leaf() const noexcept;
+    version_lock& lock() const noexcept;
+
+ private:  // Private Property(ies)
+    mutable version_lock lock_;
+    size_type level_;
+};
+
+/************************************************
+ * Declaration: class concurrent_inner_node<K, C, N>
+ ************************************************/
+
+// Laid out like `inner_node`: each entry pairs a child with the separator key bounding it from
+// below, and the separator of the first entry is never consulted.
+template <typename Key, typename Compare, std::size_t N>
+class concurrent_inner_node
+  : public concurrent_node,
+    public static_assoc<map_traits<Key, concurrent_node*, Compare>, allow_duplicates, N> {
+ private:  // Private Type(s)
+    using base_t = static_assoc<map_traits<Key, concurrent_node*, Compare>, allow_duplicates, N>;
+    using search_kernel_type = search_kernel<map_traits<Key, concurrent_node*, Compare>, N>;
+
+ public:  // Public Type(s)
+    using key_type = typename base_t::key_type;
+    using key_compare = typename base_t::key_compare;
+    using size_type = typename base_t::size_type;
+
+ public:  // Public Method(s)
+    concurrent_inner_node(size_type level, key_compare const& comp);
+
+    concurrent_node* child(size_type pos) const;
+    key_type const& key(size_type pos) const;
+    key_type const& first_key() const;
+    template <typename K>
+    size_type upper_child(K const& key) const;
+
+    void insert_child(size_type pos, key_type const& key, concurrent_node* child);
+    void erase_child(size_type pos);
+    void split_into(concurrent_inner_node& right);
+};
+
+/************************************************
+ * Declaration: class concurrent_leaf_node<T, N>
+ ************************************************/
+
+template <typename ValueTraits, std::size_t N>
+class concurrent_leaf_node
+  : public concurrent_node,
+    public static_assoc<ValueTraits, deny_duplicates, N> {
+ private:  // Private Type(s)
+    using base_t = static_assoc<ValueTraits, deny_duplicates, N>;
+
+ public:  // Public Type(s)
+    using key_type = typename base_t::key_type;
+    using key_compare = typename base_t::key_compare;
+
+ public:  // Public Method(s)
+    explicit concurrent_leaf_node(key_compare const& comp);
+
+    key_type const& first_key() const;
+
+    void split_into(concurrent_leaf_node& right);
+};
+
+/************************************************
+ * Implementation: class concurrent_node
+ ************************************************/
+
+inline concurrent_node::concurrent_node(size_type level) noexcept
+  : lock_(), level_(level) {
+    // do nothing
+}
+
+inline concurrent_node::size_type concurrent_node::level() const noexcept {
+    return level_;
+}
+
+inline bool concurrent_node::is_leaf() const noexcept {
+    return level_ == 0;
+}
+
+inline version_lock& concurrent_node::lock() const noexcept {
+    return lock_;
+}
+
+/************************************************
+ * Implementation: class concurrent_inner_node<K, C, N>
+ ************************************************/
+
+template <typename K, typename C, std::size_t N>
+inline concurrent_inner_node<K, C, N>::concurrent_inner_node(size_type level,
+                                                             key_compare const& comp)
+  : concurrent_node(level), base_t(comp) {
+    // do nothing
+}
+
+// Indexes the storage directly: to an optimistic reader, `pos` may lie past the size the node has
+// by now, which is harmless as long as it is validated afterwards.
+template <typename K, typename C, std::size_t N>
+inline concurrent_node* concurrent_inner_node<K, C, N>::child(size_type pos) const {
+    return this->values().data()[pos].second;
+}
+
+template <typename K, typename C, std::size_t N>
+inline typename concurrent_inner_node<K, C, N>::key_type const&
+concurrent_inner_node<K, C, N>::key(size_type pos) const {
+    return this->values().data()[pos].first;
+}
+
+template <typename K, typename C, std::size_t N>
+inline typename concurrent_inner_node<K, C, N>::key_type const&
+concurrent_inner_node<K, C, N>::first_key() const {
+    return key(0);
+}
+
+// Optimistic readers may see a node in the middle of being modified, so this must stay within
+// the bounds of the node whatever its apparent size.
+template <typename K, typename C, std::size_t N>
+template <typename Key>
+inline typename concurrent_inner_node<K, C, N>::size_type
+concurrent_inner_node<K, C, N>::upper_child(Key const& key) const {
+    if (this->size() <= 1) {
+        return 0;
+    }
+
+    auto first = this->cbegin() + 1;
+    auto it = search_kernel_type::upper_bound(first, this->cend(), key, this->core_comp());
+    return it - first;
+}
+
+template <typename K, typename C, std::size_t N>
+inline void concurrent_inner_node<K, C, N>::insert_child(size_type pos, key_type const& key,
+                                                         concurrent_node* child) {
+    auto& values = this->values();
+    values.emplace(values.cbegin() + pos, key, child);
+}
+
+template <typename K, typename C, std::size_t N>
+inline void concurrent_inner_node<K, C, N>::erase_child(size_type pos) {
+    auto& values = this->values();
+    values.erase(values.cbegin() + pos);
+}
+
+template <typename K, typename C, std::size_t N>
+void concurrent_inner_node<K, C, N>::split_into(concurrent_inner_node& right) {
+    auto& values = this->values();
+    auto mid = values.data() + (values.size() + 1) / 2;
+    auto last = values.data() + values.size();
+
+    auto& right_values = right.values();
+    right_values.insert(right_values.cend(),
+                        std::make_move_iterator(mid), std::make_move_iterator(last));
+    values.erase(values.cbegin() + (mid - values.data()), values.cend());
+}
+
+/************************************************
+ * Implementation: class concurrent_leaf_node<T, N>
+ ************************************************/
+
+template <typename T, std::size_t N>
+inline concurrent_leaf_node<T, N>::concurrent_leaf_node(key_compare const& comp)
+  : concurrent_node(0), base_t(comp) {
+    // do nothing
+}
+
+template <typename T, std::size_t N>
+inline typename concurrent_leaf_node<T, N>::key_type const&
+concurrent_leaf_node<T, N>::first_key() const {
+    return T::get_key(this->values().front());
+}
+
+template <typename T, std::size_t N>
+void concurrent_leaf_node<T, N>::split_into(concurrent_leaf_node& right) {
+    auto& values = this->values();
+    auto mid = values.data() + (values.size() + 1) / 2;
+    auto last = values.data() + values.size();
+
+    auto& right_values = right.values();
+    right_values.insert(right_values.cend(),
+                        std::make_move_iterator(mid), std::make_move_iterator(last));
+    values.erase(values.cbegin() + (mid - values.data()), values.cend());
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_CONCURRENT_NODE_HPP_
@@ -0,0 +1,445 @@
+/************************************************
+ *  concurrent_tree.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_CONCURRENT_TREE_HPP_
+#define BPTREE_INTERNAL_CONCURRENT_TREE_HPP_
+
+#include <cstddef>
+#include <cstring>
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+#include "./concurrent_node.hpp"
+#include "./epoch.hpp"
+#include "./version_lock.hpp"
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: class concurrent_tree<T, M, N>
+ ************************************************/
+
+// B+ tree that any number of threads may read and write at once, using optimistic lock coupling:
+// lookups take no lock and validate node versions instead, while writers lock only the nodes they
+// modify. Full nodes are split on the way down, so that a split never has to climb back up.
+//
+// Since readers may observe a node in the middle of being written, keys and values must be
+// trivially copyable; `find` hands out a validated copy rather than a reference. A leaf emptied by
+// `erase` is unlinked from its parent, unless it is the only child, and retired to the epoch
+// domain: every operation runs inside an `epoch_guard`, so that the leaf is only freed once no
+// thread can still be visiting it.
+template <typename ValueTraits, std::size_t LeafN, std::size_t InnerN>
+class concurrent_tree {
+    static_assert(LeafN >= 2, "leaf nodes must be able to hold at least 2 values");
+    static_assert(InnerN >= 4, "inner nodes must be able to hold at least 4 children");
+    static_assert(std::is_trivially_copy_constructible<typename ValueTraits::value_type>::value &&
+                      std::is_trivially_destructible<typename ValueTraits::value_type>::value,
+                  "values of a concurrent tree must be trivially copyable");
+
+ private:  // Private Type(s)
+    using value_traits = ValueTraits;
+    using node_type = concurrent_node;
+    using inner_node_type = concurrent_inner_node<
+        typename ValueTraits::key_type, typename ValueTraits::key_compare, InnerN
+    >;
+    using leaf_node_type = concurrent_leaf_node<ValueTraits, LeafN>;
+    using version_type = version_lock::version_type;
+
+ public:  // Public Type(s)
+    using key_type = typename value_traits::key_type;
+    using value_type = typename value_traits::value_type;
+    using key_compare = typename value_traits::key_compare;
+    using size_type = std::size_t;
+
+ public:  // Public Method(s)
+    explicit concurrent_tree(key_compare const& comp = key_compare());
+    concurrent_tree(concurrent_tree const&) = delete;
+    ~concurrent_tree();
+
+    concurrent_tree& operator=(concurrent_tree const&) = delete;
+
+    bool insert(value_type const& value);
+    size_type erase(key_type const& key);
+
+    template <typename F>
+    bool find(key_type const& key, F f) const;
+    bool contains(key_type const& key) const;
+
+    size_type size() const;
+    key_compare key_comp() const;
+
+ private:  // Private Method(s)
+    leaf_node_type* find_leaf(key_type const& key, version_type& version) const;
+    bool try_insert(value_type const& value, bool& inserted);
+    bool try_erase(key_type const& key, size_type& erased);
+    template <typename Node>
+    void split(Node* node, inner_node_type* parent);
+    leaf_node_type* create_sibling(leaf_node_type const* node) const;
+    inner_node_type* create_sibling(inner_node_type const* node) const;
+
+    static bool full(node_type const* node);
+    static void destroy(node_type* node) noexcept;
+    static void destroy_leaf(void* leaf) noexcept;
+
+ private:  // Private Property(ies)
+    key_compare comp_;
+    std::atomic<node_type*> root_;
+    std::atomic<size_type> size_;
+};
+
+/************************************************
+ * Implementation: class concurrent_tree<T, M, N>
+ ************************************************/
+
+template <typename T, std::size_t M, std::size_t N>
+inline concurrent_tree<T, M, N>::concurrent_tree(key_compare const& comp)
+  : comp_(comp), root_(new leaf_node_type(comp)), size_(0) {
+    // do nothing
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline concurrent_tree<T, M, N>::~concurrent_tree() {
+    destroy(root_.load(std::memory_order_relaxed));
+}
+
+template <typename T, std::size_t M, std::size_t N>
+bool concurrent_tree<T, M, N>::insert(value_type const& value) {
+    epoch_guard guard;
+    bool inserted = false;
+    while (!try_insert(value, inserted)) {
+        // restart
+    }
+
+    if (inserted) {
+        size_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return inserted;
+}
+
+template <typename T, std::size_t M, std::size_t N>
+typename concurrent_tree<T, M, N>::size_type
+concurrent_tree<T, M, N>::erase(key_type const& key) {
+    epoch_guard guard;
+    size_type erased = 0;
+    while (!try_erase(key, erased)) {
+        // restart
+    }
+
+    if (erased) {
+        size_.fetch_sub(erased, std::memory_order_relaxed);
+    }
+
+    return erased;
+}
+
+// Calls `f` with a copy of the value of `key`, taken from a leaf whose version was validated
+// afterwards, and returns whether there was one.
+template <typename T, std::size_t M, std::size_t N>
+template <typename F>
+bool concurrent_tree<T, M, N>::find(key_type const& key, F f) const {
+    typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type buffer;
+    epoch_guard guard;
+    for (;;) {
+        version_type version;
+        leaf_node_type const* leaf = find_leaf(key, version);
+        if (!leaf) {
+            continue;
+        }
+
+        auto it = leaf->find(key);
+        auto found = it != leaf->cend();
+        if (found) {
+            std::memcpy(&buffer, &*it, sizeof(value_type));
+        }
+
+        if (!leaf->lock().validate(version)) {
+            continue;
+        }
+
+        if (found) {
+            f(*reinterpret_cast<value_type const*>(&buffer));
+        }
+
+        return found;
+    }
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline bool concurrent_tree<T, M, N>::contains(key_type const& key) const {
+    return find(key, [](value_type const&) {});
+}
+
+// Kept in a counter that writers update once they are done, rather than counted from the leaves,
+// which would read nodes in the middle of being written. Only exact while no writer is active.
+template <typename T, std::size_t M, std::size_t N>
+inline typename concurrent_tree<T, M, N>::size_type concurrent_tree<T, M, N>::size() const {
+    return size_.load(std::memory_order_relaxed);
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline typename concurrent_tree<T, M, N>::key_compare concurrent_tree<T, M, N>::key_comp() const {
+    return comp_;
+}
+
+// Descends to the leaf that may hold `key` and returns it along with its version, or null if the
+// lookup has to be restarted. Each child pointer is only followed once the version of its parent
+// has been validated, and the parent is validated again after the child has been read-locked.
+template <typename T, std::size_t M, std::size_t N>
+typename concurrent_tree<T, M, N>::leaf_node_type*
+concurrent_tree<T, M, N>::find_leaf(key_type const& key, version_type& version) const {
+    auto node = root_.load(std::memory_order_acquire);
+    if (!node->lock().read_lock(version) || node != root_.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    while (!node->is_leaf()) {
+        auto inner = static_cast<inner_node_type*>(node);
+        auto child = inner->child(inner->upper_child(key));
+        if (!inner->lock().validate(version)) {
+            return nullptr;
+        }
+
+        version_type child_version;
+        if (!child->lock().read_lock(child_version) || !inner->lock().validate(version)) {
+            return nullptr;
+        }
+
+        node = child;
+        version = child_version;
+    }
+
+    return static_cast<leaf_node_type*>(node);
+}
+
+// Returns false if the insertion has to be restarted, which is also the case after splitting a
+// full node met on the way down.
+template <typename T, std::size_t M, std::size_t N>
+bool concurrent_tree<T, M, N>::try_insert(value_type const& value, bool& inserted) {
+    auto const& key = value_traits::get_key(value);
+
+    auto node = root_.load(std::memory_order_acquire);
+    version_type version;
+    if (!node->lock().read_lock(version) || node != root_.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    inner_node_type* parent = nullptr;
+    version_type parent_version = 0;
+    for (;;) {
+        if (full(node)) {
+            if (parent && !parent->lock().upgrade(parent_version)) {
+                return false;
+            }
+
+            if (!node->lock().upgrade(version)) {
+                if (parent) {
+                    parent->lock().write_unlock();
+                }
+
+                return false;
+            }
+
+            if (!parent && node != root_.load(std::memory_order_relaxed)) {
+                node->lock().write_unlock();
+                return false;
+            }
+
+            try {
+                if (node->is_leaf()) {
+                    split(static_cast<leaf_node_type*>(node), parent);
+                } else {
+                    split(static_cast<inner_node_type*>(node), parent);
+                }
+            } catch (...) {
+                node->lock().write_unlock();
+                if (parent) {
+                    parent->lock().write_unlock();
+                }
+
+                throw;
+            }
+
+            node->lock().write_unlock();
+            if (parent) {
+                parent->lock().write_unlock();
+            }
+
+            return false;
+        }
+
+        if (node->is_leaf()) {
+            break;
+        }
+
+        auto inner = static_cast<inner_node_type*>(node);
+        auto child = inner->child(inner->upper_child(key));
+        if (!inner->lock().validate(version)) {
+            return false;
+        }
+
+        version_type child_version;
+        if (!child->lock().read_lock(child_version) || !inner->lock().validate(version)) {
+            return false;
+        }
+
+        parent = inner;
+        parent_version = version;
+        node = child;
+        version = child_version;
+    }
+
+    // The keys a leaf covers only shrink when the leaf itself is split (unlinking an empty sibling
+    // only extends them), so an unchanged leaf version is enough to know that `key` still belongs
+    // here.
+    auto leaf = static_cast<leaf_node_type*>(node);
+    if (!leaf->lock().upgrade(version)) {
+        return false;
+    }
+
+    inserted = leaf->insert(value).second;
+    leaf->lock().write_unlock();
+    return true;
+}
+
+// Returns false if the erasure has to be restarted. A leaf that the erasure empties is unlinked
+// from its parent under the locks of both, marked obsolete so that the threads still visiting it
+// restart, and retired.
+template <typename T, std::size_t M, std::size_t N>
+bool concurrent_tree<T, M, N>::try_erase(key_type const& key, size_type& erased) {
+    auto node = root_.load(std::memory_order_acquire);
+    version_type version;
+    if (!node->lock().read_lock(version) || node != root_.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    inner_node_type* parent = nullptr;
+    version_type parent_version = 0;
+    size_type pos = 0;
+    while (!node->is_leaf()) {
+        auto inner = static_cast<inner_node_type*>(node);
+        pos = inner->upper_child(key);
+        auto child = inner->child(pos);
+        if (!inner->lock().validate(version)) {
+            return false;
+        }
+
+        version_type child_version;
+        if (!child->lock().read_lock(child_version) || !inner->lock().validate(version)) {
+            return false;
+        }
+
+        parent = inner;
+        parent_version = version;
+        node = child;
+        version = child_version;
+    }
+
+    auto leaf = static_cast<leaf_node_type*>(node);
+    if (leaf->find(key) == leaf->end()) {
+        erased = 0;
+        return leaf->lock().validate(version);
+    }
+
+    // both sizes are confirmed by the upgrades below
+    auto unlink = parent && leaf->size() == 1 && parent->size() > 1;
+    if (unlink && !parent->lock().upgrade(parent_version)) {
+        return false;
+    }
+
+    if (!leaf->lock().upgrade(version)) {
+        if (unlink) {
+            parent->lock().write_unlock();
+        }
+
+        return false;
+    }
+
+    erased = leaf->erase(key);
+    if (!unlink) {
+        leaf->lock().write_unlock();
+        return true;
+    }
+
+    parent->erase_child(pos);
+    parent->lock().write_unlock();
+    leaf->lock().write_unlock_obsolete();
+    epoch_domain::instance().retire(leaf, &destroy_leaf);
+    return true;
+}
+
+// Splits `node`, which must be write-locked along with `parent`, or be the root if `parent` is
+// null. The parent has room for the new child, since full nodes are split on the way down.
+template <typename T, std::size_t M, std::size_t N>
+template <typename Node>
+void concurrent_tree<T, M, N>::split(Node* node, inner_node_type* parent) {
+    std::unique_ptr<inner_node_type> root;
+    if (!parent) {
+        root.reset(new inner_node_type(node->level() + 1, comp_));
+    }
+
+    auto right = create_sibling(node);
+    node->split_into(*right);
+
+    auto const& sep = right->first_key();
+    if (root) {
+        root->insert_child(0, sep, node);
+        root->insert_child(1, sep, right);
+        root_.store(root.release(), std::memory_order_release);
+    } else {
+        parent->insert_child(parent->upper_child(sep) + 1, sep, right);
+    }
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline typename concurrent_tree<T, M, N>::leaf_node_type*
+concurrent_tree<T, M, N>::create_sibling(leaf_node_type const*) const {
+    return new leaf_node_type(comp_);
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline typename concurrent_tree<T, M, N>::inner_node_type*
+concurrent_tree<T, M, N>::create_sibling(inner_node_type const* node) const {
+    return new inner_node_type(node->level(), comp_);
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline bool concurrent_tree<T, M, N>::full(node_type const* node) {
+    return node->is_leaf() ? static_cast<leaf_node_type const*>(node)->full()
+                           : static_cast<inner_node_type const*>(node)->full();
+}
+
+template <typename T, std::size_t M, std::size_t N>
+void concurrent_tree<T, M, N>::destroy_leaf(void* leaf) noexcept {
+    delete static_cast<leaf_node_type*>(leaf);
+}
+
+template <typename T, std::size_t M, std::size_t N>
+void concurrent_tree<T, M, N>::destroy(node_type* node) noexcept {
+    if (node->is_leaf()) {
+        delete static_cast<leaf_node_type*>(node);
+        return;
+    }
+
+    auto inner = static_cast<inner_node_type*>(node);
+    for (size_type i = 0; i < inner->size(); ++i) {
+        destroy(inner->child(i));
+    }
+
+    delete inner;
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_CONCURRENT_TREE_HPP_
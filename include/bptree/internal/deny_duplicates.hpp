@@ -25,6 +25,12 @@ struct deny_duplicates {
     using insert_result_t = std::pair<typename Container::iterator, bool>;
 
  public:  // Public Method(s)
+    template <typename V>
+    static bool is_insertable(Container const& c, Compare comp,
+                              typename Container::const_iterator pos, V const& value);
+    template <typename P, typename V>
+    static bool is_insertable_after(Compare comp, P const& prev, V const& value);
+
     template <typename V>
     static insert_result_t try_insert(  // NOLINTNEXTLINE(runtime/references)
             Container& c, Compare comp, typename Container::const_iterator pos, V&& value);
@@ -38,12 +44,26 @@ struct deny_duplicates {
  * Implementation: struct deny_duplicates<Container, Compare>
  ************************************************/
 
+template <typename Container, typename Compare>
+template <typename V>
+inline bool deny_duplicates<Container, Compare>::is_insertable(Container const& c, Compare comp,
+        typename Container::const_iterator pos, V const& value) {
+    return pos == c.cbegin() || is_insertable_after(comp, *(pos - 1), value);
+}
+
+template <typename Container, typename Compare>
+template <typename P, typename V>
+inline bool deny_duplicates<Container, Compare>::is_insertable_after(
+        Compare comp, P const& prev, V const& value) {
+    return comp(prev, value);
+}
+
 template <typename Container, typename Compare>
 template <typename V>
 inline typename deny_duplicates<Container, Compare>::insert_result_t
 deny_duplicates<Container, Compare>::try_insert(  // NOLINTNEXTLINE(runtime/references)
         Container& c, Compare comp, typename Container::const_iterator pos, V&& value) {
-    if (pos == c.cbegin() || comp(*(pos - 1), value)) {
+    if (is_insertable(c, comp, pos, value)) {
         return {c.insert(pos, std::forward<V>(value)), true};
     } else {
         return {c.begin() + (pos - c.cbegin() - 1), false};
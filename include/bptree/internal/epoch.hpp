@@ -0,0 +1,309 @@
+/************************************************
+ *  epoch.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_EPOCH_HPP_
+#define BPTREE_INTERNAL_EPOCH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: class epoch_domain
+ ************************************************/
+
+// Epoch-based reclamation of nodes that readers may still be visiting after they were unlinked.
+// A thread announces the global epoch while it is inside a critical section (see `epoch_guard`),
+// and a node retired during epoch `e` is only freed once the global epoch has reached `e + 2`.
+// Since the epoch only advances when every thread inside a critical section has announced the
+// current one, all the threads that could have reached the node have left their section by then.
+//
+// Each thread owns a record, found through a thread-local pointer, in which it announces its
+// epoch and keeps the nodes it retired; entering and leaving a section cost a store each (plus a
+// fence on entry). The records are kept in a list that only grows, and are reused once their
+// threads have exited. There is a single domain per process, shared by all the trees.
+class epoch_domain {
+ public:  // Public Type(s)
+    using epoch_type = std::uint64_t;
+    using deleter_type = void (*)(void*);
+
+ public:  // Public Method(s)
+    epoch_domain(epoch_domain const&) = delete;
+    ~epoch_domain();
+
+    epoch_domain& operator=(epoch_domain const&) = delete;
+
+    void enter();
+    void leave() noexcept;
+    void retire(void* ptr, deleter_type deleter) noexcept;
+    void collect() noexcept;
+
+    epoch_type epoch() const noexcept;
+    std::size_t pending() noexcept;
+
+ public:  // Public Static Method(s)
+    static epoch_domain& instance() noexcept;
+
+ public:  // Public Static Property(ies)
+    static constexpr std::size_t collect_threshold = 64;
+
+ private:  // Private Type(s)
+    struct retired_ptr {
+        void* ptr;
+        deleter_type deleter;
+        epoch_type epoch;
+    };
+
+    // `state` holds the announced epoch shifted left by one, with bit 0 set while the owning
+    // thread is inside a critical section.
+    struct record {
+        std::atomic<epoch_type> state{0};
+        std::atomic<bool> in_use{true};
+        std::size_t depth = 0;
+        std::vector<retired_ptr> retired;
+        record* next = nullptr;
+    };
+
+    class record_owner;
+
+ private:  // Private Method(s)
+    epoch_domain() noexcept;
+
+    record& local_record();
+    static record_owner& local_record_owner() noexcept;
+    record* acquire_record();
+    bool try_advance() noexcept;
+    void reclaim(record& rec, epoch_type epoch) noexcept;
+
+ private:  // Private Property(ies)
+    std::atomic<epoch_type> epoch_;
+    std::atomic<record*> records_;
+};
+
+/************************************************
+ * Declaration: class epoch_guard
+ ************************************************/
+
+// Keeps the calling thread inside a critical section for its lifetime: the nodes it can reach
+// meanwhile are not freed, even if they are retired. Guards may be nested. The first guard of a
+// thread allocates its record, and throws `std::bad_alloc` if that fails.
+class epoch_guard {
+ public:  // Public Method(s)
+    epoch_guard();
+    epoch_guard(epoch_guard const&) = delete;
+    ~epoch_guard();
+
+    epoch_guard& operator=(epoch_guard const&) = delete;
+};
+
+/************************************************
+ * Implementation: class epoch_domain::record_owner
+ ************************************************/
+
+// Thread-local owner of the record of a thread, which frees what it can and hands the record
+// over to another thread once the owning thread exits.
+class epoch_domain::record_owner {
+ public:  // Public Method(s)
+    record_owner() noexcept
+      : record_(nullptr)
+        { /* do nothing */ }
+    record_owner(record_owner const&) = delete;
+    ~record_owner();
+
+    record_owner& operator=(record_owner const&) = delete;
+
+    record* get() const noexcept
+        { return record_; }
+    void reset(record* rec) noexcept
+        { record_ = rec; }
+
+ private:  // Private Property(ies)
+    record* record_;
+};
+
+inline epoch_domain::record_owner::~record_owner() {
+    if (record_) {
+        epoch_domain::instance().collect();
+        record_->in_use.store(false, std::memory_order_release);
+    }
+}
+
+/************************************************
+ * Implementation: class epoch_domain
+ ************************************************/
+
+inline epoch_domain::epoch_domain() noexcept
+  : epoch_(0), records_(nullptr) {
+    // do nothing
+}
+
+// Frees every node still retired. No thread may be inside a critical section any more.
+inline epoch_domain::~epoch_domain() {
+    auto rec = records_.load(std::memory_order_acquire);
+    while (rec) {
+        for (auto const& retired : rec->retired) {
+            retired.deleter(retired.ptr);
+        }
+
+        auto next = rec->next;
+        delete rec;
+        rec = next;
+    }
+}
+
+// Announces the current epoch, and fences the announcement before every node the thread then
+// reads. An epoch that is already stale when announced only holds reclamation back further.
+inline void epoch_domain::enter() {
+    auto& rec = local_record();
+    if (rec.depth++ == 0) {
+        auto epoch = epoch_.load(std::memory_order_relaxed);
+        rec.state.store(epoch << 1 | 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+inline void epoch_domain::leave() noexcept {
+    auto& rec = *local_record_owner().get();
+    if (--rec.depth == 0) {
+        rec.state.store(0, std::memory_order_release);
+    }
+}
+
+// Hands `ptr`, which must already be unreachable for threads entering a critical section from
+// now on, over to the domain, which calls `deleter(ptr)` once no thread can still be visiting
+// it. Must be called from inside a critical section. Every `collect_threshold` retirements, the
+// thread tries to advance the epoch and frees what has become safe to free. If the pointer can
+// not be queued for lack of memory, it is leaked rather than freed too early.
+inline void epoch_domain::retire(void* ptr, deleter_type deleter) noexcept {
+    // the fence orders the unlinking of `ptr` before reading the epoch it is retired in
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto epoch = epoch_.load(std::memory_order_relaxed);
+
+    auto& rec = *local_record_owner().get();
+    try {
+        rec.retired.push_back({ptr, deleter, epoch});
+    } catch (...) {
+        return;
+    }
+
+    if (rec.retired.size() % collect_threshold == 0) {
+        collect();
+    }
+}
+
+// Tries to advance the epoch, then frees the nodes the calling thread retired that are safe to
+// free.
+inline void epoch_domain::collect() noexcept {
+    if (auto rec = local_record_owner().get()) {
+        try_advance();
+        reclaim(*rec, epoch_.load(std::memory_order_acquire));
+    }
+}
+
+inline epoch_domain::epoch_type epoch_domain::epoch() const noexcept {
+    return epoch_.load(std::memory_order_acquire);
+}
+
+// Number of nodes the calling thread has retired that are not freed yet.
+inline std::size_t epoch_domain::pending() noexcept {
+    auto rec = local_record_owner().get();
+    return rec ? rec->retired.size() : 0;
+}
+
+// Domain shared by all the trees that reclaim their nodes by epochs.
+inline epoch_domain& epoch_domain::instance() noexcept {
+    static epoch_domain domain;
+    return domain;
+}
+
+inline epoch_domain::record_owner& epoch_domain::local_record_owner() noexcept {
+    static thread_local record_owner owner;
+    return owner;
+}
+
+inline epoch_domain::record& epoch_domain::local_record() {
+    auto& owner = local_record_owner();
+    if (!owner.get()) {
+        owner.reset(acquire_record());
+    }
+
+    return *owner.get();
+}
+
+// Reuses the record of a thread that has exited, or adds a new one to the list.
+inline epoch_domain::record* epoch_domain::acquire_record() {
+    for (auto rec = records_.load(std::memory_order_acquire); rec; rec = rec->next) {
+        auto in_use = false;
+        if (!rec->in_use.load(std::memory_order_relaxed) &&
+                rec->in_use.compare_exchange_strong(in_use, true, std::memory_order_acquire)) {
+            return rec;
+        }
+    }
+
+    auto rec = new record();
+    auto head = records_.load(std::memory_order_relaxed);
+    do {
+        rec->next = head;
+    } while (!records_.compare_exchange_weak(head, rec, std::memory_order_release,
+                                             std::memory_order_relaxed));
+
+    return rec;
+}
+
+// Moves the epoch one step forward, unless a thread is still inside a critical section that it
+// entered during an earlier epoch.
+inline bool epoch_domain::try_advance() noexcept {
+    auto epoch = epoch_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (auto rec = records_.load(std::memory_order_acquire); rec; rec = rec->next) {
+        auto state = rec->state.load(std::memory_order_relaxed);
+        if ((state & 1) && (state >> 1) != epoch) {
+            return false;
+        }
+    }
+
+    return epoch_.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel);
+}
+
+inline void epoch_domain::reclaim(record& rec, epoch_type epoch) noexcept {
+    auto safe = std::partition(rec.retired.begin(), rec.retired.end(),
+                               [epoch](retired_ptr const& retired) {
+                                   return retired.epoch + 2 > epoch;
+                               });
+
+    for (auto it = safe; it != rec.retired.end(); ++it) {
+        it->deleter(it->ptr);
+    }
+
+    rec.retired.erase(safe, rec.retired.end());
+}
+
+/************************************************
+ * Implementation: class epoch_guard
+ ************************************************/
+
+inline epoch_guard::epoch_guard() {
+    epoch_domain::instance().enter();
+}
+
+inline epoch_guard::~epoch_guard() {
+    epoch_domain::instance().leave();
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_EPOCH_HPP_
@@ -0,0 +1,89 @@
+/************************************************
+ *  fanout.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_FANOUT_HPP_
+#define BPTREE_INTERNAL_FANOUT_HPP_
+
+#include <cstddef>
+
+#include <utility>
+
+#include "./static_vector.hpp"
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: node size constants
+ ************************************************/
+
+std::size_t constexpr cache_line_size = 64;
+std::size_t constexpr default_node_size = 4 * cache_line_size;
+
+/************************************************
+ * Declaration: fanout functions
+ ************************************************/
+
+template <typename T>
+constexpr std::size_t fanout(std::size_t node_size, std::size_t min_fanout);
+
+template <typename Value>
+constexpr std::size_t leaf_fanout(std::size_t node_size = default_node_size);
+
+template <typename Key>
+constexpr std::size_t inner_fanout(std::size_t node_size = default_node_size);
+
+template <typename Key>
+constexpr std::size_t ranked_inner_fanout(std::size_t node_size = default_node_size);
+
+template <typename Key>
+constexpr std::size_t block_fanout(std::size_t block_size = cache_line_size);
+
+/************************************************
+ * Implementation: fanout functions
+ ************************************************/
+
+// Returns the largest number of `T` that fit into a node of `node_size` bytes, taking the parent
+// pointer and the `static_vector` header of each node into account.
+template <typename T>
+inline constexpr std::size_t fanout(std::size_t node_size, std::size_t min_fanout) {
+    auto overhead = sizeof(void*) + sizeof(static_vector<T, 1>) - sizeof(T);
+    auto n = node_size > overhead ? (node_size - overhead) / sizeof(T) : 0;
+    return n < min_fanout ? min_fanout : n;
+}
+
+// Leaves also hold the links to both of their siblings.
+template <typename Value>
+inline constexpr std::size_t leaf_fanout(std::size_t node_size) {
+    auto links = 2 * sizeof(void*);
+    return fanout<Value>(node_size > links ? node_size - links : 0, 2);
+}
+
+template <typename Key>
+inline constexpr std::size_t inner_fanout(std::size_t node_size) {
+    return fanout<std::pair<Key const, void*>>(node_size, 4);
+}
+
+// Inner nodes of ranked trees keep the size of each subtree next to the child.
+template <typename Key>
+inline constexpr std::size_t ranked_inner_fanout(std::size_t node_size) {
+    return fanout<std::pair<Key const, std::pair<void*, std::size_t>>>(node_size, 4);
+}
+
+// Returns the number of keys in a block of a frozen tree, which has neither header nor pointers.
+template <typename Key>
+inline constexpr std::size_t block_fanout(std::size_t block_size) {
+    return block_size / sizeof(Key) < 2 ? 2 : block_size / sizeof(Key);
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_FANOUT_HPP_
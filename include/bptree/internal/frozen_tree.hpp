@@ -0,0 +1,313 @@
+/************************************************
+ *  frozen_tree.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_FROZEN_TREE_HPP_
+#define BPTREE_INTERNAL_FROZEN_TREE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "./fanout.hpp"
+#include "./search.hpp"
+#include "./set_traits.hpp"
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: class frozen_tree<T, B>
+ ************************************************/
+
+// Immutable B+ tree in an implicit layout (an S+ tree): the keys of each level are packed into
+// blocks of `B` keys, the children of block `k` are blocks `k * (B + 1)` to `k * (B + 1) + B` of
+// the next level, and the last level holds the keys of all values in order. With no pointers to
+// chase and blocks the size of a cache line, a lookup costs one block search per level, and the
+// blocks of a level can be searched with SIMD.
+//
+// Blocks are padded with the largest key, which compares like an infinite key for every lookup
+// that can end within the tree. Values are kept apart from the keys, in a plain sorted array.
+template <typename ValueTraits, std::size_t B>
+class frozen_tree {
+    static_assert(B >= 2, "blocks must be able to hold at least 2 keys");
+
+ private:  // Private Type(s)
+    using value_traits = ValueTraits;
+
+    struct key_traits : set_traits<typename ValueTraits::key_type,
+                                   typename ValueTraits::key_compare> {
+        using set_traits<typename ValueTraits::key_type,
+                         typename ValueTraits::key_compare>::core_compare;
+    };
+
+    using core_compare = typename key_traits::core_compare;
+    using search_kernel_type = search_kernel<key_traits, B>;
+
+ public:  // Public Type(s)
+    using key_type = typename value_traits::key_type;
+    using value_type = typename value_traits::value_type;
+    using key_compare = typename value_traits::key_compare;
+
+    using reference = value_type const&;
+    using const_reference = value_type const&;
+    using pointer = value_type const*;
+    using const_pointer = value_type const*;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using const_iterator = value_type const*;
+    using iterator = const_iterator;
+
+ public:  // Public Method(s)
+    explicit frozen_tree(key_compare const& comp = key_compare());
+    template <typename InputIt>
+    frozen_tree(InputIt first, InputIt last, key_compare const& comp = key_compare());
+    frozen_tree(frozen_tree const& other);
+    frozen_tree(frozen_tree&&) = default;
+
+    frozen_tree& operator=(frozen_tree const& other);
+    frozen_tree& operator=(frozen_tree&&) = default;
+
+    bool empty() const noexcept;
+    size_type size() const noexcept;
+    size_type height() const noexcept;
+
+    size_type count(key_type const& key) const;
+    const_iterator find(key_type const& key) const;
+    std::pair<const_iterator, const_iterator> equal_range(key_type const& key) const;
+    const_iterator lower_bound(key_type const& key) const;
+    const_iterator upper_bound(key_type const& key) const;
+
+    const_iterator begin() const noexcept;
+    const_iterator cbegin() const noexcept;
+    const_iterator end() const noexcept;
+    const_iterator cend() const noexcept;
+
+    key_compare key_comp() const;
+
+ public:  // Static Public Method(s)
+    static constexpr size_type block_size() noexcept;
+
+ private:  // Private Method(s)
+    void build();
+    template <bool Upper>
+    size_type rank(key_type const& key, key_type const** leaf_key = nullptr) const;
+
+ private:  // Private Property(ies)
+    key_compare comp_;
+    std::vector<value_type> values_;
+    std::vector<key_type> keys_;
+    size_type base_;                // index of the first key of the root, which is cache-aligned
+    std::vector<size_type> blocks_;  // number of blocks of each level, from the root down
+};
+
+/************************************************
+ * Implementation: class frozen_tree<T, B>
+ ************************************************/
+
+template <typename T, std::size_t B>
+inline frozen_tree<T, B>::frozen_tree(key_compare const& comp)
+  : comp_(comp), base_(0) {
+    // do nothing
+}
+
+// The values in [first, last) must be sorted.
+template <typename T, std::size_t B>
+template <typename InputIt>
+inline frozen_tree<T, B>::frozen_tree(InputIt first, InputIt last, key_compare const& comp)
+  : comp_(comp), values_(first, last), base_(0) {
+    build();
+}
+
+// Lays the keys out anew, since the alignment of the copied blocks would be lost.
+template <typename T, std::size_t B>
+inline frozen_tree<T, B>::frozen_tree(frozen_tree const& other)
+  : frozen_tree(other.begin(), other.end(), other.comp_) {
+    // do nothing
+}
+
+template <typename T, std::size_t B>
+inline frozen_tree<T, B>& frozen_tree<T, B>::operator=(frozen_tree const& other) {
+    if (this != &other) {
+        *this = frozen_tree(other);
+    }
+
+    return *this;
+}
+
+template <typename T, std::size_t B>
+inline bool frozen_tree<T, B>::empty() const noexcept {
+    return values_.empty();
+}
+
+template <typename T, std::size_t B>
+inline typename frozen_tree<T, B>::size_type frozen_tree<T, B>::size() const noexcept {
+    return values_.size();
+}
+
+template <typename T, std::size_t B>
+inline typename frozen_tree<T, B>::size_type frozen_tree<T, B>::height() const noexcept {
+    return blocks_.size();
+}
+
+template <typename T, std::size_t B>
+inline typename frozen_tree<T, B>::size_type
+frozen_tree<T, B>::count(key_type const& key) const {
+    return rank<true>(key) - rank<false>(key);
+}
+
+template <typename T, std::size_t B>
+inline typename frozen_tree<T, B>::const_iterator
+frozen_tree<T, B>::find(key_type const& key) const {
+    // compare with the key in the leaf block rather than the value, which is likely not cached
+    key_type const* leaf_key = nullptr;
+    auto pos = rank<false>(key, &leaf_key);
+    return pos < size() && !comp_(key, *leaf_key) ? begin() + pos : end();
+}
+
+template <typename T, std::size_t B>
+inline std::pair<typename frozen_tree<T, B>::const_iterator,
+                 typename frozen_tree<T, B>::const_iterator>
+frozen_tree<T, B>::equal_range(key_type const& key) const {
+    return {lower_bound(key), upper_bound(key)};
+}
+
+template <typename T, std::size_t B>
+inline typename frozen_tree<T, B>::const_iterator
+frozen_tree<T, B>::lower_bound(key_type const& key) const {
+    return begin() + rank<false>(key);
+}
+
+template <typename T, std::size_t B>
+inline typename frozen_tree<T, B>::const_iterator
+frozen_tree<T, B>::upper_bound(key_type const& key) const {
+    return begin() + rank<true>(key);
+}
+
+template <typename T, std::size_t B>
+inline typename frozen_tree<T, B>::const_iterator frozen_tree<T, B>::begin() const noexcept {
+    return values_.data();
+}
+
+template <typename T, std::size_t B>
+inline typename frozen_tree<T, B>::const_iterator frozen_tree<T, B>::cbegin() const noexcept {
+    return begin();
+}
+
+template <typename T, std::size_t B>
+inline typename frozen_tree<T, B>::const_iterator frozen_tree<T, B>::end() const noexcept {
+    return values_.data() + values_.size();
+}
+
+template <typename T, std::size_t B>
+inline typename frozen_tree<T, B>::const_iterator frozen_tree<T, B>::cend() const noexcept {
+    return end();
+}
+
+template <typename T, std::size_t B>
+inline typename frozen_tree<T, B>::key_compare frozen_tree<T, B>::key_comp() const {
+    return comp_;
+}
+
+template <typename T, std::size_t B>
+inline constexpr typename frozen_tree<T, B>::size_type frozen_tree<T, B>::block_size() noexcept {
+    return B;
+}
+
+template <typename T, std::size_t B>
+void frozen_tree<T, B>::build() {
+    if (values_.empty()) {
+        return;
+    }
+
+    auto n = values_.size();
+    blocks_.push_back((n + B - 1) / B);
+    while (blocks_.back() > 1) {
+        blocks_.push_back((blocks_.back() + B) / (B + 1));
+    }
+
+    std::reverse(blocks_.begin(), blocks_.end());
+
+    size_type total = 0;
+    for (auto blocks : blocks_) {
+        total += blocks * B;
+    }
+
+    // pad the front of the array, so that the root and the blocks after it start a cache line
+    auto const& pad = T::get_key(values_.back());
+    auto slack = cache_line_size % sizeof(key_type) == 0 ? cache_line_size / sizeof(key_type) : 0;
+    keys_.reserve(total + slack);
+    if (slack > 0) {
+        auto misalignment = reinterpret_cast<std::uintptr_t>(keys_.data()) % cache_line_size;
+        base_ = misalignment % sizeof(key_type) == 0
+              ? (cache_line_size - misalignment) % cache_line_size / sizeof(key_type)
+              : 0;
+        keys_.assign(base_, pad);
+    }
+
+    // the separator before child `i + 1` of a block is the first key of the leaf block that
+    // starts the subtree of that child, which spans `span` leaf blocks
+    size_type span = 1;
+    for (size_type level = 1; level < blocks_.size(); ++level) {
+        span *= B + 1;
+    }
+
+    for (auto blocks : blocks_) {
+        span /= B + 1;
+        for (size_type k = 0; k < blocks; ++k) {
+            for (size_type i = 0; i < B; ++i) {
+                auto pos = span == 0 ? k * B + i : (k * (B + 1) + i + 1) * span * B;
+                keys_.push_back(pos < n ? T::get_key(values_[pos]) : pad);
+            }
+        }
+    }
+}
+
+// Returns the number of values whose key is less than `key`, or not greater than it if `Upper`,
+// and points `leaf_key` to the key of the value at that position, if any. The child picked at
+// each level is clamped to the blocks that exist, which only matters when the padding was
+// counted, i.e. when every key of the tree precedes `key`.
+template <typename T, std::size_t B>
+template <bool Upper>
+typename frozen_tree<T, B>::size_type
+frozen_tree<T, B>::rank(key_type const& key, key_type const** leaf_key) const {
+    if (blocks_.empty()) {
+        return 0;
+    }
+
+    core_compare comp(comp_);
+    auto level_first = keys_.data() + base_;
+    size_type k = 0;
+    for (size_type level = 0;; ++level) {
+        auto first = level_first + k * B;
+        auto it = Upper ? search_kernel_type::upper_bound(first, first + B, key, comp)
+                        : search_kernel_type::lower_bound(first, first + B, key, comp);
+        size_type i = it - first;
+        if (level + 1 == blocks_.size()) {
+            if (leaf_key) {
+                *leaf_key = first + i;
+            }
+
+            return std::min(k * B + i, values_.size());
+        }
+
+        level_first += blocks_[level] * B;
+        k = std::min(k * (B + 1) + i, blocks_[level + 1] - 1);
+    }
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_FROZEN_TREE_HPP_
@@ -0,0 +1,152 @@
+/************************************************
+ *  leaf_range.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_LEAF_RANGE_HPP_
+#define BPTREE_INTERNAL_LEAF_RANGE_HPP_
+
+#include <cstddef>
+
+#include <iterator>
+#include <type_traits>
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: class leaf_span<T>
+ ************************************************/
+
+// Values stored contiguously in a single leaf.
+template <typename T>
+class leaf_span {
+ public:  // Public Type(s)
+    using value_type = std::remove_const_t<T>;
+    using reference = T&;
+    using pointer = T*;
+    using iterator = T*;
+    using size_type = std::size_t;
+
+ public:  // Public Method(s)
+    leaf_span() noexcept
+      : first_(nullptr), last_(nullptr)
+        { /* do nothing */ }
+    leaf_span(pointer first, pointer last) noexcept
+      : first_(first), last_(last)
+        { /* do nothing */ }
+
+    reference operator[](size_type pos) const noexcept
+        { return first_[pos]; }
+
+    iterator begin() const noexcept
+        { return first_; }
+    iterator end() const noexcept
+        { return last_; }
+    pointer data() const noexcept
+        { return first_; }
+
+    bool empty() const noexcept
+        { return first_ == last_; }
+    size_type size() const noexcept
+        { return last_ - first_; }
+
+ private:  // Private Property(ies)
+    pointer first_;
+    pointer last_;
+};
+
+/************************************************
+ * Declaration: class leaf_range_iterator<I>
+ ************************************************/
+
+// Iterates over the leaves covered by a range of tree iterators, yielding for each leaf the span
+// of its values that lies within the range.
+template <typename Iterator>
+class leaf_range_iterator {
+ public:  // Public Type(s)
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = leaf_span<std::remove_pointer_t<typename Iterator::pointer>>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = value_type;
+
+ public:  // Public Method(s)
+    leaf_range_iterator() = default;
+    leaf_range_iterator(Iterator first, Iterator last)
+      : first_(first), last_(last)
+        { /* do nothing */ }
+
+    reference operator*() const;
+
+    leaf_range_iterator& operator++();
+    leaf_range_iterator operator++(int)
+        { leaf_range_iterator it(*this); ++*this; return it; }
+
+    bool operator==(leaf_range_iterator const& other) const noexcept
+        { return first_ == other.first_; }
+    bool operator!=(leaf_range_iterator const& other) const noexcept
+        { return !(*this == other); }
+
+ private:  // Private Property(ies)
+    Iterator first_;
+    Iterator last_;
+};
+
+/************************************************
+ * Declaration: class leaf_range<I>
+ ************************************************/
+
+// View of the values in [first, last) of a tree as a sequence of contiguous leaf spans, which
+// lets a scan run tight loops over each leaf.
+template <typename Iterator>
+class leaf_range {
+ public:  // Public Type(s)
+    using iterator = leaf_range_iterator<Iterator>;
+    using span_type = typename iterator::value_type;
+
+ public:  // Public Method(s)
+    leaf_range(Iterator first, Iterator last)
+      : first_(first), last_(last)
+        { /* do nothing */ }
+
+    iterator begin() const
+        { return iterator(first_, last_); }
+    iterator end() const
+        { return iterator(last_, last_); }
+
+    bool empty() const
+        { return first_ == last_; }
+
+ private:  // Private Property(ies)
+    Iterator first_;
+    Iterator last_;
+};
+
+/************************************************
+ * Implementation: class leaf_range_iterator<I>
+ ************************************************/
+
+template <typename I>
+inline typename leaf_range_iterator<I>::reference leaf_range_iterator<I>::operator*() const {
+    auto leaf = first_.leaf();
+    auto last = leaf == last_.leaf() ? last_.operator->() : leaf->end().operator->();
+    return value_type(first_.operator->(), last);
+}
+
+template <typename I>
+inline leaf_range_iterator<I>& leaf_range_iterator<I>::operator++() {
+    auto leaf = first_.leaf();
+    first_ = leaf == last_.leaf() ? last_ : I(leaf->next_leaf(), 0);
+    return *this;
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_LEAF_RANGE_HPP_
@@ -9,9 +9,13 @@
 #ifndef BPTREE_INTERNAL_MAP_TRAITS_HPP_
 #define BPTREE_INTERNAL_MAP_TRAITS_HPP_
 
+#include <cstddef>
+
 #include <functional>
 #include <utility>
 
+#include "./static_vector.hpp"
+
 namespace bptree {
 
 namespace internal {
@@ -29,6 +33,9 @@ struct map_traits {
 
     using key_compare = Compare;
 
+    template <std::size_t N>
+    using storage_type = static_vector<value_type, N>;
+
     class value_compare : protected key_compare {
      protected:  // Protected Method(s)
         explicit value_compare(key_compare comp)
@@ -59,8 +66,13 @@ struct map_traits {
         }
 
      private:  // Private Method(s)
-        key_compare const& comp_;
+        key_compare comp_;
     };
+
+ public:  // Static Public Method(s)
+    static key_type const& get_key(value_type const& value) noexcept {
+        return value.first;
+    }
 };
 
 }  // namespace internal
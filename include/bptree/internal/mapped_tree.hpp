@@ -0,0 +1,777 @@
+/************************************************
+ *  mapped_tree.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_MAPPED_TREE_HPP_
+#define BPTREE_INTERNAL_MAPPED_TREE_HPP_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "./leaf_range.hpp"
+#include "./map_traits.hpp"
+#include "./search.hpp"
+#include "./static_vector.hpp"
+#include "./tree_iterator.hpp"
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: mapped file layout
+ ************************************************/
+
+// A mapped file is a sequence of pages of `PageSize` bytes. Page 0 holds the header, followed by
+// the leaves in key order and then the inner nodes level by level, the root being the last page.
+// Nodes refer to their children by page index and leaves to their siblings by a byte offset
+// relative to themselves, so the file is usable wherever it is mapped. The header records the
+// pages of the root and of the last leaf. Values are stored in `static_vector`s, in the byte order
+// of the machine that wrote them.
+struct mapped_header {
+    char magic[8];
+    std::uint32_t format_version;
+    std::uint32_t page_size;
+    std::uint64_t key_size;
+    std::uint64_t value_size;
+    std::uint64_t leaf_capacity;
+    std::uint64_t inner_capacity;
+    std::uint64_t size;
+    std::uint64_t height;
+    std::uint64_t root;
+    std::uint64_t last_leaf;
+    std::uint64_t page_count;
+};
+
+constexpr char mapped_magic[8] = {'B', 'P', 'T', 'R', 'E', 'E', 'M', '\0'};
+constexpr std::uint32_t mapped_format_version = 1;
+
+template <typename T>
+constexpr std::size_t mapped_fanout(std::size_t page_size, std::size_t header_size);
+
+/************************************************
+ * Declaration: class mapped_leaf<T, N>
+ ************************************************/
+
+template <typename Value, std::size_t N>
+class mapped_leaf {
+ public:  // Public Type(s)
+    using storage_type = static_vector<Value, N>;
+    using const_iterator = typename storage_type::const_iterator;
+    using size_type = std::size_t;
+
+ public:  // Public Method(s)
+    mapped_leaf() noexcept;
+
+    const_iterator begin() const noexcept;
+    const_iterator end() const noexcept;
+    size_type size() const noexcept;
+
+    mapped_leaf const* next_leaf() const noexcept;
+    mapped_leaf const* prev_leaf() const noexcept;
+
+    storage_type& values() noexcept;
+    void link(std::int64_t prev, std::int64_t next) noexcept;
+
+ private:  // Private Method(s)
+    mapped_leaf const* sibling(std::int64_t offset) const noexcept;
+
+ private:  // Private Property(ies)
+    std::int64_t prev_;
+    std::int64_t next_;
+    storage_type values_;
+};
+
+/************************************************
+ * Declaration: class mapped_inner<K, N>
+ ************************************************/
+
+// Each entry pairs the page of a child with the first key stored under it; as in `inner_node`,
+// the key of the first entry is never consulted.
+template <typename Key, std::size_t N>
+class mapped_inner {
+ public:  // Public Type(s)
+    using value_type = std::pair<Key const, std::uint64_t>;
+    using storage_type = static_vector<value_type, N>;
+
+ public:  // Public Method(s)
+    storage_type const& entries() const noexcept;
+    storage_type& entries() noexcept;
+
+ private:  // Private Property(ies)
+    storage_type entries_;
+};
+
+/************************************************
+ * Declaration: class mapped_tree<T, P>
+ ************************************************/
+
+// Read-only B+ tree served straight from a memory-mapped file written by `write`. Opening a tree
+// costs a single `mmap` and a pass over the inner pages, which are few next to the leaves, and
+// processes that map the same file share its pages in the page cache.
+//
+// Keys and values must be trivially copyable, since they are stored as raw bytes. A file can only
+// be opened with the same value type and page size it was written with.
+template <typename ValueTraits, std::size_t PageSize>
+class mapped_tree {
+    static_assert(std::is_trivially_copy_constructible<typename ValueTraits::value_type>::value &&
+                      std::is_trivially_destructible<typename ValueTraits::value_type>::value,
+                  "values of a mapped tree must be trivially copyable");
+    static_assert(PageSize >= sizeof(mapped_header), "pages must be able to hold the header");
+
+ private:  // Private Type(s)
+    using value_traits = ValueTraits;
+
+    struct leaf_traits : ValueTraits {
+        using ValueTraits::core_compare;
+    };
+
+    using core_compare = typename leaf_traits::core_compare;
+
+    struct inner_traits : map_traits<typename ValueTraits::key_type, std::uint64_t,
+                                     typename ValueTraits::key_compare> {
+        using map_traits<typename ValueTraits::key_type, std::uint64_t,
+                         typename ValueTraits::key_compare>::core_compare;
+    };
+
+ public:  // Public Type(s)
+    using key_type = typename value_traits::key_type;
+    using value_type = typename value_traits::value_type;
+    using key_compare = typename value_traits::key_compare;
+    using size_type = std::size_t;
+
+    using leaf_page_type = mapped_leaf<
+        value_type, mapped_fanout<value_type>(PageSize, 2 * sizeof(std::int64_t))
+    >;
+    using inner_page_type = mapped_inner<
+        key_type, mapped_fanout<std::pair<key_type const, std::uint64_t>>(PageSize, 0)
+    >;
+
+    using const_iterator = tree_iterator<leaf_page_type const, value_type const>;
+    using iterator = const_iterator;
+    using const_range_type = leaf_range<const_iterator>;
+
+ private:  // Private Type(s)
+    using leaf_search_kernel = search_kernel<
+        value_traits, leaf_page_type::storage_type::capacity()
+    >;
+    using inner_search_kernel = search_kernel<
+        inner_traits, inner_page_type::storage_type::capacity()
+    >;
+
+ public:  // Public Method(s)
+    explicit mapped_tree(std::string const& path, key_compare const& comp = key_compare());
+    mapped_tree(mapped_tree const&) = delete;
+    mapped_tree(mapped_tree&& other) noexcept;
+    ~mapped_tree();
+
+    mapped_tree& operator=(mapped_tree const&) = delete;
+    mapped_tree& operator=(mapped_tree&& other) noexcept;
+
+    bool empty() const noexcept;
+    size_type size() const noexcept;
+    size_type height() const noexcept;
+
+    size_type count(key_type const& key) const;
+    const_iterator find(key_type const& key) const;
+    std::pair<const_iterator, const_iterator> equal_range(key_type const& key) const;
+    const_iterator lower_bound(key_type const& key) const;
+    const_iterator upper_bound(key_type const& key) const;
+    const_range_type range(key_type const& lo, key_type const& hi) const;
+    template <typename F>
+    void for_each_span(F f) const;
+    template <typename F>
+    void for_each_span(key_type const& lo, key_type const& hi, F f) const;
+
+    const_iterator begin() const noexcept;
+    const_iterator cbegin() const noexcept;
+    const_iterator end() const noexcept;
+    const_iterator cend() const noexcept;
+
+    key_compare key_comp() const;
+
+ public:  // Static Public Method(s)
+    template <typename InputIt>
+    static void write(std::string const& path, InputIt first, InputIt last);
+
+    static constexpr size_type page_size() noexcept;
+    static constexpr size_type leaf_capacity() noexcept;
+    static constexpr size_type inner_capacity() noexcept;
+
+ private:  // Private Method(s)
+    void const* page(std::uint64_t index) const noexcept;
+    leaf_page_type const* lower_leaf(key_type const& key) const;
+    leaf_page_type const* upper_leaf(key_type const& key) const;
+    leaf_page_type const* first_leaf() const noexcept;
+    leaf_page_type const* last_leaf() const noexcept;
+    const_iterator make_iterator(leaf_page_type const* leaf, size_type pos) const;
+    void unmap() noexcept;
+
+    void validate(std::string const& path) const;
+
+    static mapped_header make_header(size_type size, size_type height, std::uint64_t root,
+                                     std::uint64_t last_leaf, std::uint64_t page_count);
+
+ private:  // Private Property(ies)
+    key_compare comp_;
+    char const* data_;
+    size_type length_;
+};
+
+/************************************************
+ * Implementation: mapped file layout
+ ************************************************/
+
+// Returns the largest number of `T` that fit into a page next to a header of `header_size` bytes
+// and the size of the `static_vector` holding them.
+template <typename T>
+inline constexpr std::size_t mapped_fanout(std::size_t page_size, std::size_t header_size) {
+    auto overhead = header_size + sizeof(static_vector<T, 1>) - sizeof(T);
+    return page_size > overhead ? (page_size - overhead) / sizeof(T) : 0;
+}
+
+/************************************************
+ * Implementation: class mapped_leaf<T, N>
+ ************************************************/
+
+template <typename T, std::size_t N>
+inline mapped_leaf<T, N>::mapped_leaf() noexcept
+  : prev_(0), next_(0), values_() {
+    // do nothing
+}
+
+template <typename T, std::size_t N>
+inline typename mapped_leaf<T, N>::const_iterator mapped_leaf<T, N>::begin() const noexcept {
+    return values_.begin();
+}
+
+template <typename T, std::size_t N>
+inline typename mapped_leaf<T, N>::const_iterator mapped_leaf<T, N>::end() const noexcept {
+    return values_.end();
+}
+
+template <typename T, std::size_t N>
+inline typename mapped_leaf<T, N>::size_type mapped_leaf<T, N>::size() const noexcept {
+    return values_.size();
+}
+
+template <typename T, std::size_t N>
+inline mapped_leaf<T, N> const* mapped_leaf<T, N>::next_leaf() const noexcept {
+    return sibling(next_);
+}
+
+template <typename T, std::size_t N>
+inline mapped_leaf<T, N> const* mapped_leaf<T, N>::prev_leaf() const noexcept {
+    return sibling(prev_);
+}
+
+template <typename T, std::size_t N>
+inline typename mapped_leaf<T, N>::storage_type& mapped_leaf<T, N>::values() noexcept {
+    return values_;
+}
+
+template <typename T, std::size_t N>
+inline void mapped_leaf<T, N>::link(std::int64_t prev, std::int64_t next) noexcept {
+    prev_ = prev;
+    next_ = next;
+}
+
+template <typename T, std::size_t N>
+inline mapped_leaf<T, N> const* mapped_leaf<T, N>::sibling(std::int64_t offset) const noexcept {
+    if (offset == 0) {
+        return nullptr;
+    }
+
+    return reinterpret_cast<mapped_leaf const*>(reinterpret_cast<char const*>(this) + offset);
+}
+
+/************************************************
+ * Implementation: class mapped_inner<K, N>
+ ************************************************/
+
+template <typename K, std::size_t N>
+inline typename mapped_inner<K, N>::storage_type const&
+mapped_inner<K, N>::entries() const noexcept {
+    return entries_;
+}
+
+template <typename K, std::size_t N>
+inline typename mapped_inner<K, N>::storage_type& mapped_inner<K, N>::entries() noexcept {
+    return entries_;
+}
+
+/************************************************
+ * Implementation: class mapped_tree<T, P>
+ ************************************************/
+
+template <typename T, std::size_t P>
+mapped_tree<T, P>::mapped_tree(std::string const& path, key_compare const& comp)
+  : comp_(comp), data_(nullptr), length_(0) {
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) < 0) {
+        auto error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), "cannot stat " + path);
+    }
+
+    length_ = static_cast<size_type>(st.st_size);
+    if (length_ < P) {
+        ::close(fd);
+        throw std::runtime_error(path + " is not a mapped tree");
+    }
+
+    auto data = ::mmap(nullptr, length_, PROT_READ, MAP_SHARED, fd, 0);
+    auto error = errno;
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        throw std::system_error(error, std::generic_category(), "cannot map " + path);
+    }
+
+    data_ = static_cast<char const*>(data);
+    try {
+        validate(path);
+    } catch (...) {
+        unmap();
+        throw;
+    }
+}
+
+template <typename T, std::size_t P>
+inline mapped_tree<T, P>::mapped_tree(mapped_tree&& other) noexcept
+  : comp_(other.comp_), data_(other.data_), length_(other.length_) {
+    other.data_ = nullptr;
+    other.length_ = 0;
+}
+
+template <typename T, std::size_t P>
+inline mapped_tree<T, P>::~mapped_tree() {
+    unmap();
+}
+
+template <typename T, std::size_t P>
+inline mapped_tree<T, P>& mapped_tree<T, P>::operator=(mapped_tree&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        comp_ = other.comp_;
+        data_ = other.data_;
+        length_ = other.length_;
+        other.data_ = nullptr;
+        other.length_ = 0;
+    }
+
+    return *this;
+}
+
+template <typename T, std::size_t P>
+inline bool mapped_tree<T, P>::empty() const noexcept {
+    return size() == 0;
+}
+
+template <typename T, std::size_t P>
+inline typename mapped_tree<T, P>::size_type mapped_tree<T, P>::size() const noexcept {
+    return data_ ? static_cast<mapped_header const*>(page(0))->size : 0;
+}
+
+template <typename T, std::size_t P>
+inline typename mapped_tree<T, P>::size_type mapped_tree<T, P>::height() const noexcept {
+    if (empty()) {
+        return 0;
+    }
+
+    return static_cast<mapped_header const*>(page(0))->height + 1;
+}
+
+template <typename T, std::size_t P>
+inline typename mapped_tree<T, P>::size_type mapped_tree<T, P>::count(key_type const& key) const {
+    auto range = equal_range(key);
+    return std::distance(range.first, range.second);
+}
+
+template <typename T, std::size_t P>
+typename mapped_tree<T, P>::const_iterator mapped_tree<T, P>::find(key_type const& key) const {
+    auto it = lower_bound(key);
+    if (it != end() && comp_(key, value_traits::get_key(*it))) {
+        it = end();
+    }
+
+    return it;
+}
+
+template <typename T, std::size_t P>
+inline std::pair<typename mapped_tree<T, P>::const_iterator,
+                 typename mapped_tree<T, P>::const_iterator>
+mapped_tree<T, P>::equal_range(key_type const& key) const {
+    return {lower_bound(key), upper_bound(key)};
+}
+
+template <typename T, std::size_t P>
+typename mapped_tree<T, P>::const_iterator
+mapped_tree<T, P>::lower_bound(key_type const& key) const {
+    if (empty()) {
+        return end();
+    }
+
+    auto leaf = lower_leaf(key);
+    auto it = leaf_search_kernel::lower_bound(leaf->begin(), leaf->end(), key,
+                                              core_compare(comp_));
+    return make_iterator(leaf, it - leaf->begin());
+}
+
+template <typename T, std::size_t P>
+typename mapped_tree<T, P>::const_iterator
+mapped_tree<T, P>::upper_bound(key_type const& key) const {
+    if (empty()) {
+        return end();
+    }
+
+    auto leaf = upper_leaf(key);
+    auto it = leaf_search_kernel::upper_bound(leaf->begin(), leaf->end(), key,
+                                              core_compare(comp_));
+    return make_iterator(leaf, it - leaf->begin());
+}
+
+// The values with keys in [lo, hi), as one span per leaf page.
+template <typename T, std::size_t P>
+typename mapped_tree<T, P>::const_range_type
+mapped_tree<T, P>::range(key_type const& lo, key_type const& hi) const {
+    auto first = lower_bound(lo);
+    auto last = comp_(lo, hi) ? lower_bound(hi) : first;
+    return const_range_type(first, last);
+}
+
+template <typename T, std::size_t P>
+template <typename F>
+inline void mapped_tree<T, P>::for_each_span(F f) const {
+    for (auto span : const_range_type(cbegin(), cend())) {
+        f(span.data(), span.size());
+    }
+}
+
+template <typename T, std::size_t P>
+template <typename F>
+inline void mapped_tree<T, P>::for_each_span(key_type const& lo, key_type const& hi, F f) const {
+    for (auto span : range(lo, hi)) {
+        f(span.data(), span.size());
+    }
+}
+
+template <typename T, std::size_t P>
+inline typename mapped_tree<T, P>::const_iterator mapped_tree<T, P>::begin() const noexcept {
+    return cbegin();
+}
+
+template <typename T, std::size_t P>
+inline typename mapped_tree<T, P>::const_iterator mapped_tree<T, P>::cbegin() const noexcept {
+    return const_iterator(first_leaf(), 0);
+}
+
+template <typename T, std::size_t P>
+inline typename mapped_tree<T, P>::const_iterator mapped_tree<T, P>::end() const noexcept {
+    return cend();
+}
+
+template <typename T, std::size_t P>
+inline typename mapped_tree<T, P>::const_iterator mapped_tree<T, P>::cend() const noexcept {
+    auto leaf = last_leaf();
+    return const_iterator(leaf, leaf ? leaf->size() : 0);
+}
+
+template <typename T, std::size_t P>
+inline typename mapped_tree<T, P>::key_compare mapped_tree<T, P>::key_comp() const {
+    return comp_;
+}
+
+// Writes the sorted values in [first, last) to `path`: leaves are filled completely, since the
+// tree will never be modified, and the inner levels are built bottom-up on top of them.
+template <typename T, std::size_t P>
+template <typename InputIt>
+void mapped_tree<T, P>::write(std::string const& path, InputIt first, InputIt last) {
+    static_assert(alignof(leaf_page_type) <= alignof(std::max_align_t) &&
+                      alignof(inner_page_type) <= alignof(std::max_align_t),
+                  "pages must not be over-aligned");
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("cannot open " + path + " for writing");
+    }
+
+    // each page is assembled in a zeroed buffer, so that padding bytes are written as zeros
+    std::vector<char> buffer(P);
+    auto flush = [&]() {
+        out.write(buffer.data(), P);
+        std::fill(buffer.begin(), buffer.end(), 0);
+    };
+
+    flush();  // reserve the header page
+
+    // leaves occupy consecutive pages, so their siblings are one page away
+    std::vector<std::pair<key_type, std::uint64_t>> children;
+    std::uint64_t page_count = 1;
+    std::uint64_t last_leaf = 0;
+    size_type size = 0;
+    while (first != last) {
+        auto leaf = new (buffer.data()) leaf_page_type();
+        auto& values = leaf->values();
+        for (; first != last && values.size() < values.capacity(); ++first, ++size) {
+            values.push_back(*first);
+        }
+
+        leaf->link(children.empty() ? 0 : -static_cast<std::int64_t>(P),
+                   first != last ? static_cast<std::int64_t>(P) : 0);
+        last_leaf = page_count++;
+        children.emplace_back(value_traits::get_key(values.front()), last_leaf);
+        flush();
+    }
+
+    size_type height = 0;
+    for (; children.size() > 1; ++height) {
+        std::vector<std::pair<key_type, std::uint64_t>> parents;
+        auto capacity = inner_page_type::storage_type::capacity();
+        auto num_nodes = (children.size() + capacity - 1) / capacity;
+        auto child = children.begin();
+        for (size_type i = 0; i < num_nodes; ++i) {
+            auto inner = new (buffer.data()) inner_page_type();
+            auto& entries = inner->entries();
+            auto count = children.size() / num_nodes + (i < children.size() % num_nodes);
+            for (size_type pos = 0; pos < count; ++pos, ++child) {
+                entries.emplace_back(child->first, child->second);
+            }
+
+            parents.emplace_back(entries.front().first, page_count++);
+            flush();
+        }
+
+        children = std::move(parents);
+    }
+
+    auto header = make_header(size, height, children.empty() ? 0 : children.front().second,
+                              last_leaf, page_count);
+    out.seekp(0);
+    out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("cannot write " + path);
+    }
+}
+
+template <typename T, std::size_t P>
+inline constexpr typename mapped_tree<T, P>::size_type mapped_tree<T, P>::page_size() noexcept {
+    return P;
+}
+
+template <typename T, std::size_t P>
+inline constexpr typename mapped_tree<T, P>::size_type
+mapped_tree<T, P>::leaf_capacity() noexcept {
+    return leaf_page_type::storage_type::capacity();
+}
+
+template <typename T, std::size_t P>
+inline constexpr typename mapped_tree<T, P>::size_type
+mapped_tree<T, P>::inner_capacity() noexcept {
+    return inner_page_type::storage_type::capacity();
+}
+
+template <typename T, std::size_t P>
+inline void const* mapped_tree<T, P>::page(std::uint64_t index) const noexcept {
+    return data_ + index * P;
+}
+
+template <typename T, std::size_t P>
+typename mapped_tree<T, P>::leaf_page_type const*
+mapped_tree<T, P>::lower_leaf(key_type const& key) const {
+    typename inner_traits::core_compare comp(comp_);
+
+    auto header = static_cast<mapped_header const*>(page(0));
+    auto index = header->root;
+    for (auto level = header->height; level > 0; --level) {
+        auto& entries = static_cast<inner_page_type const*>(page(index))->entries();
+        auto first = entries.begin() + 1;
+        auto it = inner_search_kernel::lower_bound(first, entries.end(), key, comp);
+        index = entries[it - first].second;
+    }
+
+    return static_cast<leaf_page_type const*>(page(index));
+}
+
+template <typename T, std::size_t P>
+typename mapped_tree<T, P>::leaf_page_type const*
+mapped_tree<T, P>::upper_leaf(key_type const& key) const {
+    typename inner_traits::core_compare comp(comp_);
+
+    auto header = static_cast<mapped_header const*>(page(0));
+    auto index = header->root;
+    for (auto level = header->height; level > 0; --level) {
+        auto& entries = static_cast<inner_page_type const*>(page(index))->entries();
+        auto first = entries.begin() + 1;
+        auto it = inner_search_kernel::upper_bound(first, entries.end(), key, comp);
+        index = entries[it - first].second;
+    }
+
+    return static_cast<leaf_page_type const*>(page(index));
+}
+
+// The leaves occupy the pages right after the header.
+template <typename T, std::size_t P>
+inline typename mapped_tree<T, P>::leaf_page_type const*
+mapped_tree<T, P>::first_leaf() const noexcept {
+    return empty() ? nullptr : static_cast<leaf_page_type const*>(page(1));
+}
+
+template <typename T, std::size_t P>
+typename mapped_tree<T, P>::leaf_page_type const*
+mapped_tree<T, P>::last_leaf() const noexcept {
+    if (empty()) {
+        return nullptr;
+    }
+
+    auto header = static_cast<mapped_header const*>(page(0));
+    return static_cast<leaf_page_type const*>(page(header->last_leaf));
+}
+
+template <typename T, std::size_t P>
+inline typename mapped_tree<T, P>::const_iterator
+mapped_tree<T, P>::make_iterator(leaf_page_type const* leaf, size_type pos) const {
+    if (pos == leaf->size()) {
+        auto next = leaf->next_leaf();
+        if (next) {
+            return const_iterator(next, 0);
+        }
+    }
+
+    return const_iterator(leaf, pos);
+}
+
+template <typename T, std::size_t P>
+inline void mapped_tree<T, P>::unmap() noexcept {
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), length_);
+        data_ = nullptr;
+        length_ = 0;
+    }
+}
+
+// Checks the header and then the inner pages level by level against the layout written by
+// `write`, so that no descent can leave the mapping; the leaves themselves are not touched.
+template <typename T, std::size_t P>
+void mapped_tree<T, P>::validate(std::string const& path) const {
+    auto& header = *static_cast<mapped_header const*>(page(0));
+    if (std::memcmp(header.magic, mapped_magic, sizeof(mapped_magic)) != 0) {
+        throw std::runtime_error(path + " is not a mapped tree");
+    }
+
+    auto expected = make_header(header.size, header.height, header.root, header.last_leaf,
+                                header.page_count);
+    if (header.format_version != expected.format_version ||
+            header.page_size != expected.page_size ||
+            header.key_size != expected.key_size ||
+            header.value_size != expected.value_size ||
+            header.leaf_capacity != expected.leaf_capacity ||
+            header.inner_capacity != expected.inner_capacity) {
+        throw std::runtime_error(path + " was written with another format, page or value type");
+    }
+
+    auto corrupted = [&path]() {
+        return std::runtime_error(path + " is truncated or corrupted");
+    };
+
+    if (header.page_count * P != length_ || header.root >= header.page_count) {
+        throw corrupted();
+    }
+
+    if (header.size == 0) {
+        if (header.height != 0 || header.last_leaf != 0 || header.page_count != 1) {
+            throw corrupted();
+        }
+
+        return;
+    }
+
+    if (header.last_leaf == 0 || header.last_leaf >= header.page_count) {
+        throw corrupted();
+    }
+
+    // the pages of each level follow those of the level below, and refer to them in order
+    std::uint64_t level_first = 1;
+    std::uint64_t level_last = header.last_leaf + 1;
+    for (auto level = header.height; level > 0; --level) {
+        auto child = level_first;
+        auto index = level_last;
+        for (; child < level_last; ++index) {
+            if (index >= header.page_count) {
+                throw corrupted();
+            }
+
+            auto& entries = static_cast<inner_page_type const*>(page(index))->entries();
+            if (entries.size() == 0 || entries.size() > inner_capacity()) {
+                throw corrupted();
+            }
+
+            for (auto& entry : entries) {
+                if (entry.second != child++) {
+                    throw corrupted();
+                }
+            }
+        }
+
+        level_first = level_last;
+        level_last = index;
+    }
+
+    if (level_last - level_first != 1 || header.root != level_first ||
+            level_last != header.page_count) {
+        throw corrupted();
+    }
+}
+
+template <typename T, std::size_t P>
+mapped_header mapped_tree<T, P>::make_header(size_type size, size_type height,
+                                             std::uint64_t root, std::uint64_t last_leaf,
+                                             std::uint64_t page_count) {
+    mapped_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, mapped_magic, sizeof(mapped_magic));
+    header.format_version = mapped_format_version;
+    header.page_size = P;
+    header.key_size = sizeof(key_type);
+    header.value_size = sizeof(value_type);
+    header.leaf_capacity = leaf_capacity();
+    header.inner_capacity = inner_capacity();
+    header.size = size;
+    header.height = height;
+    header.root = root;
+    header.last_leaf = last_leaf;
+    header.page_count = page_count;
+    return header;
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_MAPPED_TREE_HPP_
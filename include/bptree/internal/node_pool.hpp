@@ -0,0 +1,369 @@
+/************************************************
+ *  node_pool.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_NODE_POOL_HPP_
+#define BPTREE_INTERNAL_NODE_POOL_HPP_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: class node_pool
+ ************************************************/
+
+// Hands out blocks of a single size, carved from slabs that grow geometrically up to
+// `max_slab_size` bytes. Freed blocks are kept in a free list for reuse, and all the blocks are
+// returned at once by `release()`, which costs one deallocation per slab instead of per block.
+class node_pool {
+ public:  // Public Type(s)
+    using size_type = std::size_t;
+
+ public:  // Public Method(s)
+    node_pool(size_type block_size, size_type block_align) noexcept;
+    node_pool(node_pool const&) = delete;
+    ~node_pool();
+
+    node_pool& operator=(node_pool const&) = delete;
+
+    void* allocate();
+    void deallocate(void* block) noexcept;
+    void release() noexcept;
+
+    size_type block_size() const noexcept;
+    size_type block_align() const noexcept;
+
+ public:  // Public Static Property(ies)
+    static constexpr size_type min_slab_blocks = 16;
+    static constexpr size_type max_slab_size = size_type(1) << 20;
+
+ private:  // Private Type(s)
+    struct slab_header {
+        slab_header* next;
+    };
+
+    struct free_block {
+        free_block* next;
+    };
+
+ private:  // Private Method(s)
+    void grow();
+
+ private:  // Private Property(ies)
+    size_type block_size_;
+    size_type block_align_;
+    size_type slab_blocks_;
+    slab_header* slabs_;
+    free_block* free_list_;
+    unsigned char* unused_first_;
+    unsigned char* unused_last_;
+};
+
+/************************************************
+ * Declaration: class node_pool_resource
+ ************************************************/
+
+// A set of `node_pool`s shared by a `pool_allocator` and all its rebound copies, one per block
+// size and alignment.
+class node_pool_resource {
+ public:  // Public Type(s)
+    using size_type = std::size_t;
+
+ public:  // Public Method(s)
+    node_pool_resource() = default;
+    node_pool_resource(node_pool_resource const&) = delete;
+
+    node_pool_resource& operator=(node_pool_resource const&) = delete;
+
+    node_pool& pool(size_type block_size, size_type block_align);
+    void release() noexcept;
+
+ private:  // Private Type(s)
+    struct entry {
+        size_type block_size;
+        size_type block_align;
+        std::unique_ptr<node_pool> pool;
+    };
+
+ private:  // Private Property(ies)
+    std::vector<entry> pools_;
+};
+
+/************************************************
+ * Declaration: class pool_allocator<T>
+ ************************************************/
+
+// Allocator drawing single objects from a `node_pool`; arrays are forwarded to `operator new`.
+// Copies and rebound copies share their pools, so the pools live as long as any of them does.
+//
+// Trees using this allocator drop all their nodes with a single `release()` on `clear()` and
+// destruction, so one allocator (and its copies) must not serve more than one container at a
+// time. Copies of a container get a fresh pool from `select_on_container_copy_construction()`.
+template <typename T>
+class pool_allocator {
+ public:  // Public Type(s)
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = pool_allocator<U>;
+    };
+
+ public:  // Public Method(s)
+    pool_allocator();
+    pool_allocator(pool_allocator const& other) noexcept;
+    template <typename U>
+    pool_allocator(pool_allocator<U> const& other) noexcept;  // NOLINT(runtime/explicit)
+
+    pool_allocator& operator=(pool_allocator const& other) noexcept;
+
+    T* allocate(size_type n);
+    void deallocate(T* p, size_type n) noexcept;
+    void release() noexcept;
+
+    pool_allocator select_on_container_copy_construction() const;
+
+ private:  // Private Method(s)
+    explicit pool_allocator(std::shared_ptr<node_pool_resource> resource);
+
+ private:  // Private Property(ies)
+    std::shared_ptr<node_pool_resource> resource_;
+    node_pool* pool_;
+
+    template <typename U>
+    friend class pool_allocator;
+    template <typename T1, typename T2>
+    friend bool operator==(pool_allocator<T1> const& x, pool_allocator<T2> const& y) noexcept;
+};
+
+template <typename T1, typename T2>
+bool operator==(pool_allocator<T1> const& x, pool_allocator<T2> const& y) noexcept;
+template <typename T1, typename T2>
+bool operator!=(pool_allocator<T1> const& x, pool_allocator<T2> const& y) noexcept;
+
+/************************************************
+ * Declaration: struct has_bulk_release<A>
+ ************************************************/
+
+// Whether an allocator can return all its memory at once through `release()`.
+template <typename Allocator, typename = void>
+struct has_bulk_release : std::false_type {};
+
+template <typename Allocator>
+struct has_bulk_release<
+    Allocator, decltype(std::declval<Allocator&>().release(), void())
+> : std::true_type {};
+
+/************************************************
+ * Implementation: class node_pool
+ ************************************************/
+
+inline node_pool::node_pool(size_type block_size, size_type block_align) noexcept
+  : block_size_(std::max(block_size, sizeof(free_block))),
+    block_align_(std::max(block_align, alignof(free_block))),
+    slab_blocks_(min_slab_blocks),
+    slabs_(nullptr), free_list_(nullptr), unused_first_(nullptr), unused_last_(nullptr) {
+    // round the block size up, so that every block of a slab is suitably aligned
+    block_size_ = (block_size_ + block_align_ - 1) / block_align_ * block_align_;
+}
+
+inline node_pool::~node_pool() {
+    release();
+}
+
+inline void* node_pool::allocate() {
+    if (free_list_) {
+        auto block = free_list_;
+        free_list_ = block->next;
+        return block;
+    }
+
+    if (unused_first_ == unused_last_) {
+        grow();
+    }
+
+    auto block = unused_first_;
+    unused_first_ += block_size_;
+    return block;
+}
+
+inline void node_pool::deallocate(void* block) noexcept {
+    assert(block != nullptr);
+    free_list_ = ::new(block) free_block{free_list_};
+}
+
+inline void node_pool::release() noexcept {
+    while (slabs_) {
+        auto next = slabs_->next;
+        ::operator delete(slabs_);
+        slabs_ = next;
+    }
+
+    slab_blocks_ = min_slab_blocks;
+    free_list_ = nullptr;
+    unused_first_ = nullptr;
+    unused_last_ = nullptr;
+}
+
+inline node_pool::size_type node_pool::block_size() const noexcept {
+    return block_size_;
+}
+
+inline node_pool::size_type node_pool::block_align() const noexcept {
+    return block_align_;
+}
+
+inline void node_pool::grow() {
+    // the blocks follow the slab header, padded up to the block alignment
+    auto offset = (sizeof(slab_header) + block_align_ - 1) / block_align_ * block_align_;
+    auto raw = ::operator new(offset + slab_blocks_ * block_size_ + block_align_);
+    slabs_ = ::new(raw) slab_header{slabs_};
+
+    auto first = reinterpret_cast<std::uintptr_t>(raw) + offset;
+    first = (first + block_align_ - 1) / block_align_ * block_align_;
+    unused_first_ = reinterpret_cast<unsigned char*>(first);
+    unused_last_ = unused_first_ + slab_blocks_ * block_size_;
+
+    if (slab_blocks_ * block_size_ * 2 <= max_slab_size) {
+        slab_blocks_ *= 2;
+    }
+}
+
+/************************************************
+ * Implementation: class node_pool_resource
+ ************************************************/
+
+inline node_pool& node_pool_resource::pool(size_type block_size, size_type block_align) {
+    for (auto const& entry : pools_) {
+        if (entry.block_size == block_size && entry.block_align == block_align) {
+            return *entry.pool;
+        }
+    }
+
+    std::unique_ptr<node_pool> pool(new node_pool(block_size, block_align));
+    pools_.push_back({block_size, block_align, std::move(pool)});
+    return *pools_.back().pool;
+}
+
+inline void node_pool_resource::release() noexcept {
+    for (auto const& entry : pools_) {
+        entry.pool->release();
+    }
+}
+
+/************************************************
+ * Implementation: class pool_allocator<T>
+ ************************************************/
+
+template <typename T>
+inline pool_allocator<T>::pool_allocator()
+  : pool_allocator(std::make_shared<node_pool_resource>()) {
+    // do nothing
+}
+
+template <typename T>
+inline pool_allocator<T>::pool_allocator(pool_allocator const& other) noexcept
+  : resource_(other.resource_), pool_(other.pool_) {
+    // do nothing
+}
+
+template <typename T>
+template <typename U>
+inline pool_allocator<T>::pool_allocator(pool_allocator<U> const& other) noexcept
+  : resource_(other.resource_), pool_(nullptr) {
+    // the pool for `T` is looked up on first use, since doing so may allocate
+}
+
+template <typename T>
+inline pool_allocator<T>::pool_allocator(std::shared_ptr<node_pool_resource> resource)
+  : resource_(std::move(resource)), pool_(nullptr) {
+    // do nothing
+}
+
+template <typename T>
+inline pool_allocator<T>& pool_allocator<T>::operator=(pool_allocator const& other) noexcept {
+    resource_ = other.resource_;
+    pool_ = other.pool_;
+    return *this;
+}
+
+template <typename T>
+inline T* pool_allocator<T>::allocate(size_type n) {
+    if (n != 1) {
+        if (n > std::numeric_limits<size_type>::max() / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    if (!pool_) {
+        pool_ = &resource_->pool(sizeof(T), alignof(T));
+    }
+
+    return static_cast<T*>(pool_->allocate());
+}
+
+template <typename T>
+inline void pool_allocator<T>::deallocate(T* p, size_type n) noexcept {
+    if (n != 1) {
+        ::operator delete(p);
+        return;
+    }
+
+    // the pool already exists, since `p` comes from it, so looking it up does not allocate
+    if (!pool_) {
+        pool_ = &resource_->pool(sizeof(T), alignof(T));
+    }
+
+    pool_->deallocate(p);
+}
+
+template <typename T>
+inline void pool_allocator<T>::release() noexcept {
+    resource_->release();
+}
+
+template <typename T>
+inline pool_allocator<T> pool_allocator<T>::select_on_container_copy_construction() const {
+    return pool_allocator();
+}
+
+template <typename T1, typename T2>
+inline bool operator==(pool_allocator<T1> const& x, pool_allocator<T2> const& y) noexcept {
+    return x.resource_ == y.resource_;
+}
+
+template <typename T1, typename T2>
+inline bool operator!=(pool_allocator<T1> const& x, pool_allocator<T2> const& y) noexcept {
+    return !(x == y);
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_NODE_POOL_HPP_
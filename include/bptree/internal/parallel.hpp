@@ -0,0 +1,145 @@
+/************************************************
+ *  parallel.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_PARALLEL_HPP_
+#define BPTREE_INTERNAL_PARALLEL_HPP_
+
+#include <cstddef>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: parallel functions
+ ************************************************/
+
+std::size_t default_thread_count() noexcept;
+
+template <typename F>
+void parallel_invoke(std::size_t n, F f);
+
+template <typename F>
+void parallel_for(std::size_t n, F f, std::size_t threads);
+
+template <typename RandomIt, typename Compare>
+void parallel_stable_sort(RandomIt first, RandomIt last, Compare comp, std::size_t threads);
+
+/************************************************
+ * Implementation: parallel functions
+ ************************************************/
+
+// Number of threads used when a caller asks for 0.
+inline std::size_t default_thread_count() noexcept {
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+// Calls `f(i)` for every `i` in `[0, n)`, each on its own thread (the calling thread takes
+// `f(0)`), and waits for all of them. The first exception thrown by a call is rethrown once they
+// have all returned. If no more threads can be started, the calling thread runs the remaining
+// calls itself.
+template <typename F>
+void parallel_invoke(std::size_t n, F f) {
+    std::vector<std::exception_ptr> errors(n);
+    auto run = [&](std::size_t i) {
+        try {
+            f(i);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    std::size_t started = 1;
+    try {
+        workers.reserve(n > 0 ? n - 1 : 0);
+        for (; started < n; ++started) {
+            workers.emplace_back(run, started);
+        }
+    } catch (...) {
+        // do nothing: the calls left are run below
+    }
+
+    if (n > 0) {
+        run(0);
+    }
+
+    for (auto i = started; i < n; ++i) {
+        run(i);
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (auto const& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+// Calls `f(i)` for every `i` in `[0, n)` on up to `threads` threads, which take the next index
+// left as soon as they are done with one, so that uneven tasks still keep every thread busy.
+template <typename F>
+void parallel_for(std::size_t n, F f, std::size_t threads) {
+    std::atomic<std::size_t> next(0);
+    parallel_invoke(std::min(threads, n), [&](std::size_t) {
+        for (auto i = next++; i < n; i = next++) {
+            f(i);
+        }
+    });
+}
+
+// Stable sort over `threads` threads: each one sorts a contiguous chunk of the range, then pairs
+// of adjacent chunks are merged in place, in log2(threads) rounds whose merges run in parallel.
+// Small ranges are sorted on the calling thread.
+template <typename RandomIt, typename Compare>
+void parallel_stable_sort(RandomIt first, RandomIt last, Compare comp, std::size_t threads) {
+    static constexpr std::size_t min_chunk_size = 1 << 14;
+
+    auto size = static_cast<std::size_t>(std::distance(first, last));
+    threads = std::min(threads, size / min_chunk_size);
+    if (threads <= 1) {
+        std::stable_sort(first, last, comp);
+        return;
+    }
+
+    std::vector<RandomIt> bounds;
+    bounds.reserve(threads + 1);
+    for (std::size_t i = 0; i <= threads; ++i) {
+        bounds.push_back(first + size * i / threads);
+    }
+
+    parallel_invoke(threads, [&](std::size_t i) {
+        std::stable_sort(bounds[i], bounds[i + 1], comp);
+    });
+
+    for (std::size_t width = 1; width < threads; width *= 2) {
+        auto merges = (threads - width + 2 * width - 1) / (2 * width);
+        parallel_invoke(merges, [&](std::size_t i) {
+            auto lo = 2 * width * i;
+            auto mid = lo + width;
+            auto hi = std::min(mid + width, threads);
+            std::inplace_merge(bounds[lo], bounds[mid], bounds[hi], comp);
+        });
+    }
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_PARALLEL_HPP_
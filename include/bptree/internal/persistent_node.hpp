@@ -0,0 +1,368 @@
+/************************************************
+ *  persistent_node.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_PERSISTENT_NODE_HPP_
+#define BPTREE_INTERNAL_PERSISTENT_NODE_HPP_
+
+#include <cstddef>
+
+#include <atomic>
+#include <iterator>
+#include <new>
+#include <utility>
+
+#include "./allow_duplicates.hpp"
+#include "./deny_duplicates.hpp"
+#include "./map_traits.hpp"
+#include "./search.hpp"
+#include "./static_assoc.hpp"
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: class persistent_node
+ ************************************************/
+
+// Common part of the nodes of `persistent_tree`. Nodes hold no parent or sibling pointers, so that
+// any number of trees and snapshots may share a subtree; each node counts the references to it
+// instead, and is freed along with the last one. A node referenced only once belongs to a single
+// tree, which may then modify it in place.
+class persistent_node {
+ public:  // Public Type(s)
+    using size_type = std::size_t;
+
+ public:  // Public Method(s)
+    explicit persistent_node(size_type level) noexcept;
+    persistent_node(persistent_node const& other) noexcept;
+
+    persistent_node& operator=(persistent_node const&) = delete;
+
+    size_type level() const noexcept;
+    bool is_leaf() const noexcept;
+    bool shared() const noexcept;
+
+    void retain() const noexcept;
+    bool release() const noexcept;
+
+ private:  // Private Property(ies)
+    size_type level_;
+    mutable std::atomic<size_type> refs_;
+};
+
+/************************************************
+ * Declaration: class persistent_inner_node<T, N>
+ ************************************************/
+
+// Laid out like `inner_node`. A copy shares the children of the original, and thus takes a
+// reference to each of them.
+template <typename ValueTraits, std::size_t N>
+class persistent_inner_node
+  : public persistent_node,
+    public static_assoc<
+        map_traits<typename ValueTraits::key_type, persistent_node*,
+                   typename ValueTraits::key_compare>,
+        allow_duplicates, N
+    > {
+ private:  // Private Type(s)
+    using child_traits = map_traits<
+        typename ValueTraits::key_type, persistent_node*, typename ValueTraits::key_compare
+    >;
+    using base_t = static_assoc<child_traits, allow_duplicates, N>;
+    using search_kernel_type = search_kernel<child_traits, N>;
+
+ public:  // Public Type(s)
+    using key_type = typename base_t::key_type;
+    using value_type = typename base_t::value_type;
+    using key_compare = typename base_t::key_compare;
+    using size_type = typename base_t::size_type;
+
+ public:  // Public Method(s)
+    persistent_inner_node(size_type level, key_compare const& comp);
+    persistent_inner_node(persistent_inner_node const& other);
+
+    persistent_node* child(size_type pos) const;
+    key_type const& key(size_type pos) const;
+    key_type const& first_key() const;
+    template <typename K>
+    size_type upper_child(K const& key) const;
+
+    void insert_child(size_type pos, key_type const& key, persistent_node* child);
+    void erase_child(size_type pos);
+    void replace_child(size_type pos, persistent_node* child);
+    void replace_key(size_type pos, key_type const& key);
+
+    void split_into(persistent_inner_node& right);
+    void merge_from(persistent_inner_node& right, key_type const& sep);
+    void borrow_from_left(persistent_inner_node& left, key_type const& sep);
+    void borrow_from_right(persistent_inner_node& right, key_type const& sep);
+
+ public:  // Static Public Method(s)
+    static constexpr size_type min_size() noexcept;
+};
+
+/************************************************
+ * Declaration: class persistent_leaf_node<T, N>
+ ************************************************/
+
+template <typename ValueTraits, std::size_t N>
+class persistent_leaf_node
+  : public persistent_node,
+    public static_assoc<ValueTraits, deny_duplicates, N> {
+ private:  // Private Type(s)
+    using base_t = static_assoc<ValueTraits, deny_duplicates, N>;
+
+ public:  // Public Type(s)
+    using key_type = typename base_t::key_type;
+    using key_compare = typename base_t::key_compare;
+    using size_type = typename base_t::size_type;
+
+ public:  // Public Method(s)
+    explicit persistent_leaf_node(key_compare const& comp);
+    persistent_leaf_node(persistent_leaf_node const& other) = default;
+
+    key_type const& first_key() const;
+
+    void split_into(persistent_leaf_node& right);
+    void merge_from(persistent_leaf_node& right, key_type const& sep);
+    void borrow_from_left(persistent_leaf_node& left, key_type const& sep);
+    void borrow_from_right(persistent_leaf_node& right, key_type const& sep);
+
+ public:  // Static Public Method(s)
+    static constexpr size_type min_size() noexcept;
+};
+
+/************************************************
+ * Implementation: class persistent_node
+ ************************************************/
+
+inline persistent_node::persistent_node(size_type level) noexcept
+  : level_(level), refs_(1) {
+    // do nothing
+}
+
+// A copy starts out referenced once, by whoever made it.
+inline persistent_node::persistent_node(persistent_node const& other) noexcept
+  : level_(other.level_), refs_(1) {
+    // do nothing
+}
+
+inline persistent_node::size_type persistent_node::level() const noexcept {
+    return level_;
+}
+
+inline bool persistent_node::is_leaf() const noexcept {
+    return level_ == 0;
+}
+
+// Only the tree that holds the sole reference to a node can make it shared, so a node seen
+// unshared stays so until that tree shares it. Acquiring the count orders the releases by other
+// threads before any change the tree then makes in place.
+inline bool persistent_node::shared() const noexcept {
+    return refs_.load(std::memory_order_acquire) > 1;
+}
+
+inline void persistent_node::retain() const noexcept {
+    refs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Returns whether the last reference was dropped, in which case the node is up to the caller to
+// free.
+inline bool persistent_node::release() const noexcept {
+    return refs_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+}
+
+/************************************************
+ * Implementation: class persistent_inner_node<T, N>
+ ************************************************/
+
+template <typename T, std::size_t N>
+inline persistent_inner_node<T, N>::persistent_inner_node(size_type level,
+                                                          key_compare const& comp)
+  : persistent_node(level), base_t(comp) {
+    // do nothing
+}
+
+template <typename T, std::size_t N>
+inline persistent_inner_node<T, N>::persistent_inner_node(persistent_inner_node const& other)
+  : persistent_node(other), base_t(static_cast<base_t const&>(other)) {
+    for (auto const& entry : this->values()) {
+        entry.second->retain();
+    }
+}
+
+template <typename T, std::size_t N>
+inline persistent_node* persistent_inner_node<T, N>::child(size_type pos) const {
+    return this->values()[pos].second;
+}
+
+template <typename T, std::size_t N>
+inline typename persistent_inner_node<T, N>::key_type const&
+persistent_inner_node<T, N>::key(size_type pos) const {
+    return this->values()[pos].first;
+}
+
+template <typename T, std::size_t N>
+inline typename persistent_inner_node<T, N>::key_type const&
+persistent_inner_node<T, N>::first_key() const {
+    return key(0);
+}
+
+template <typename T, std::size_t N>
+template <typename K>
+inline typename persistent_inner_node<T, N>::size_type
+persistent_inner_node<T, N>::upper_child(K const& key) const {
+    auto first = this->cbegin() + 1;
+    auto it = search_kernel_type::upper_bound(first, this->cend(), key, this->core_comp());
+    return it - first;
+}
+
+template <typename T, std::size_t N>
+inline void persistent_inner_node<T, N>::insert_child(size_type pos, key_type const& key,
+                                                      persistent_node* child) {
+    auto& values = this->values();
+    values.emplace(values.cbegin() + pos, key, child);
+}
+
+template <typename T, std::size_t N>
+inline void persistent_inner_node<T, N>::erase_child(size_type pos) {
+    auto& values = this->values();
+    values.erase(values.cbegin() + pos);
+}
+
+// Hands the reference held to the former child over to the caller.
+template <typename T, std::size_t N>
+inline void persistent_inner_node<T, N>::replace_child(size_type pos, persistent_node* child) {
+    this->values()[pos].second = child;
+}
+
+template <typename T, std::size_t N>
+inline void persistent_inner_node<T, N>::replace_key(size_type pos, key_type const& key) {
+    auto ptr = this->values().data() + pos;
+    auto child = ptr->second;
+    ptr->~value_type();
+    ::new(ptr) value_type(key, child);
+}
+
+template <typename T, std::size_t N>
+void persistent_inner_node<T, N>::split_into(persistent_inner_node& right) {
+    auto& values = this->values();
+    auto mid = values.data() + (values.size() + 1) / 2;
+    auto last = values.data() + values.size();
+
+    auto& right_values = right.values();
+    right_values.insert(right_values.cend(),
+                        std::make_move_iterator(mid), std::make_move_iterator(last));
+    values.erase(values.cbegin() + (mid - values.data()), values.cend());
+}
+
+template <typename T, std::size_t N>
+void persistent_inner_node<T, N>::merge_from(persistent_inner_node& right, key_type const& sep) {
+    auto& values = this->values();
+    auto& right_values = right.values();
+
+    values.emplace_back(sep, right.child(0));
+    values.insert(values.cend(),
+                  std::make_move_iterator(right_values.data() + 1),
+                  std::make_move_iterator(right_values.data() + right_values.size()));
+    right_values.clear();
+}
+
+template <typename T, std::size_t N>
+void persistent_inner_node<T, N>::borrow_from_left(persistent_inner_node& left,
+                                                   key_type const& sep) {
+    auto& values = this->values();
+    auto& left_values = left.values();
+
+    replace_key(0, sep);
+    values.emplace(values.cbegin(), std::move(left_values.back()));
+    left_values.pop_back();
+}
+
+template <typename T, std::size_t N>
+void persistent_inner_node<T, N>::borrow_from_right(persistent_inner_node& right,
+                                                    key_type const& sep) {
+    auto& values = this->values();
+    auto& right_values = right.values();
+
+    values.emplace_back(sep, right.child(0));
+    right_values.erase(right_values.cbegin());
+}
+
+template <typename T, std::size_t N>
+inline constexpr typename persistent_inner_node<T, N>::size_type
+persistent_inner_node<T, N>::min_size() noexcept {
+    return N / 2;
+}
+
+/************************************************
+ * Implementation: class persistent_leaf_node<T, N>
+ ************************************************/
+
+template <typename T, std::size_t N>
+inline persistent_leaf_node<T, N>::persistent_leaf_node(key_compare const& comp)
+  : persistent_node(0), base_t(comp) {
+    // do nothing
+}
+
+template <typename T, std::size_t N>
+inline typename persistent_leaf_node<T, N>::key_type const&
+persistent_leaf_node<T, N>::first_key() const {
+    return T::get_key(this->values().front());
+}
+
+template <typename T, std::size_t N>
+void persistent_leaf_node<T, N>::split_into(persistent_leaf_node& right) {
+    auto& values = this->values();
+    auto mid = values.data() + (values.size() + 1) / 2;
+    auto last = values.data() + values.size();
+
+    auto& right_values = right.values();
+    right_values.insert(right_values.cend(),
+                        std::make_move_iterator(mid), std::make_move_iterator(last));
+    values.erase(values.cbegin() + (mid - values.data()), values.cend());
+}
+
+template <typename T, std::size_t N>
+void persistent_leaf_node<T, N>::merge_from(persistent_leaf_node& right, key_type const&) {
+    auto& values = this->values();
+    auto& right_values = right.values();
+    values.insert(values.cend(),
+                  std::make_move_iterator(right_values.data()),
+                  std::make_move_iterator(right_values.data() + right_values.size()));
+    right_values.clear();
+}
+
+template <typename T, std::size_t N>
+void persistent_leaf_node<T, N>::borrow_from_left(persistent_leaf_node& left, key_type const&) {
+    auto& values = this->values();
+    auto& left_values = left.values();
+    values.emplace(values.cbegin(), std::move(left_values.back()));
+    left_values.pop_back();
+}
+
+template <typename T, std::size_t N>
+void persistent_leaf_node<T, N>::borrow_from_right(persistent_leaf_node& right, key_type const&) {
+    auto& values = this->values();
+    auto& right_values = right.values();
+    values.emplace_back(std::move(right_values.front()));
+    right_values.erase(right_values.cbegin());
+}
+
+template <typename T, std::size_t N>
+inline constexpr typename persistent_leaf_node<T, N>::size_type
+persistent_leaf_node<T, N>::min_size() noexcept {
+    return N / 2;
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_PERSISTENT_NODE_HPP_
@@ -0,0 +1,573 @@
+/************************************************
+ *  persistent_tree.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_PERSISTENT_TREE_HPP_
+#define BPTREE_INTERNAL_PERSISTENT_TREE_HPP_
+
+#include <cstddef>
+
+#include <memory>
+#include <utility>
+
+#include "./persistent_node.hpp"
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: class persistent_snapshot<T, M, N>
+ ************************************************/
+
+// Immutable view of a `persistent_tree` at some point in time. Copying one only takes another
+// reference to its root, and a snapshot stays valid (and unchanged) however the tree it was taken
+// from changes, or if that tree is destroyed. Snapshots may be read and released from any thread,
+// while the tree goes on changing in another.
+template <typename ValueTraits, std::size_t LeafN, std::size_t InnerN>
+class persistent_snapshot {
+    static_assert(LeafN >= 2, "leaf nodes must be able to hold at least 2 values");
+    static_assert(InnerN >= 4, "inner nodes must be able to hold at least 4 children");
+
+ protected:  // Protected Type(s)
+    using value_traits = ValueTraits;
+    using node_type = persistent_node;
+    using inner_node_type = persistent_inner_node<ValueTraits, InnerN>;
+    using leaf_node_type = persistent_leaf_node<ValueTraits, LeafN>;
+
+ public:  // Public Type(s)
+    using key_type = typename value_traits::key_type;
+    using value_type = typename value_traits::value_type;
+    using key_compare = typename value_traits::key_compare;
+    using size_type = std::size_t;
+
+ public:  // Public Method(s)
+    explicit persistent_snapshot(key_compare const& comp = key_compare());
+    persistent_snapshot(persistent_snapshot const& other) noexcept;
+    persistent_snapshot(persistent_snapshot&& other) noexcept;
+    ~persistent_snapshot();
+
+    persistent_snapshot& operator=(persistent_snapshot const& other) noexcept;
+    persistent_snapshot& operator=(persistent_snapshot&& other) noexcept;
+    void swap(persistent_snapshot& other) noexcept;
+
+    template <typename F>
+    bool find(key_type const& key, F f) const;
+    bool contains(key_type const& key) const;
+    template <typename F>
+    void for_each(F f) const;
+    template <typename F>
+    void for_each(key_type const& lo, key_type const& hi, F f) const;
+
+    bool empty() const noexcept;
+    size_type size() const noexcept;
+    size_type height() const noexcept;
+    key_compare key_comp() const;
+
+ protected:  // Protected Static Method(s)
+    static void release(node_type const* node) noexcept;
+
+ private:  // Private Method(s)
+    template <typename F>
+    void for_each(node_type const* node, key_type const* lo, key_type const* hi, F& f) const;
+
+ protected:  // Protected Property(ies)
+    key_compare comp_;
+    node_type* root_;
+    size_type size_;
+};
+
+/************************************************
+ * Declaration: class persistent_tree<T, M, N>
+ ************************************************/
+
+// B+ tree whose nodes are shared with the snapshots taken of it, so that `snapshot()` costs O(1).
+// A write copies the nodes on its path that a snapshot still refers to (along with the siblings it
+// borrows from or merges with), and modifies the nodes the tree owns alone in place: it costs
+// O(height * node size) whether or not snapshots are alive.
+//
+// Writes are not synchronized: a tree must be modified by one thread at a time, but its snapshots
+// may be read concurrently. Copying a tree shares its nodes just like a snapshot does.
+template <typename ValueTraits, std::size_t LeafN, std::size_t InnerN>
+class persistent_tree : public persistent_snapshot<ValueTraits, LeafN, InnerN> {
+ private:  // Private Type(s)
+    using base_t = persistent_snapshot<ValueTraits, LeafN, InnerN>;
+    using value_traits = typename base_t::value_traits;
+    using node_type = typename base_t::node_type;
+    using inner_node_type = typename base_t::inner_node_type;
+    using leaf_node_type = typename base_t::leaf_node_type;
+
+ public:  // Public Type(s)
+    using key_type = typename base_t::key_type;
+    using value_type = typename base_t::value_type;
+    using key_compare = typename base_t::key_compare;
+    using size_type = typename base_t::size_type;
+    using snapshot_type = base_t;
+
+ public:  // Public Method(s)
+    using base_t::base_t;
+
+    snapshot_type snapshot() const noexcept;
+
+    bool insert(value_type const& value);
+    size_type erase(key_type const& key);
+    void clear() noexcept;
+
+ private:  // Private Method(s)
+    node_type* insert(node_type* node, bool shared, value_type const& value, node_type*& right);
+    node_type* erase(node_type* node, bool shared, key_type const& key);
+    void rebalance(inner_node_type* inner, size_type pos);
+    template <typename Node>
+    void rebalance(inner_node_type* inner, size_type pos);
+    node_type* own_child(inner_node_type* inner, size_type pos);
+    void replace_root(node_type* root) noexcept;
+
+    template <typename Node>
+    static Node* own(Node* node, bool shared);
+    static void adopt(inner_node_type* inner, size_type pos, node_type* child) noexcept;
+    static key_type const& first_key(node_type const* node);
+};
+
+/************************************************
+ * Implementation: class persistent_snapshot<T, M, N>
+ ************************************************/
+
+template <typename T, std::size_t M, std::size_t N>
+inline persistent_snapshot<T, M, N>::persistent_snapshot(key_compare const& comp)
+  : comp_(comp), root_(nullptr), size_(0) {
+    // do nothing
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline persistent_snapshot<T, M, N>::persistent_snapshot(persistent_snapshot const& other) noexcept
+  : comp_(other.comp_), root_(other.root_), size_(other.size_) {
+    if (root_) {
+        root_->retain();
+    }
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline persistent_snapshot<T, M, N>::persistent_snapshot(persistent_snapshot&& other) noexcept
+  : comp_(other.comp_), root_(other.root_), size_(other.size_) {
+    other.root_ = nullptr;
+    other.size_ = 0;
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline persistent_snapshot<T, M, N>::~persistent_snapshot() {
+    release(root_);
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline persistent_snapshot<T, M, N>&
+persistent_snapshot<T, M, N>::operator=(persistent_snapshot const& other) noexcept {
+    persistent_snapshot(other).swap(*this);
+    return *this;
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline persistent_snapshot<T, M, N>&
+persistent_snapshot<T, M, N>::operator=(persistent_snapshot&& other) noexcept {
+    persistent_snapshot(std::move(other)).swap(*this);
+    return *this;
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline void persistent_snapshot<T, M, N>::swap(persistent_snapshot& other) noexcept {
+    using std::swap;
+    swap(comp_, other.comp_);
+    swap(root_, other.root_);
+    swap(size_, other.size_);
+}
+
+// Calls `f` with the value of `key` and returns whether there was one.
+template <typename T, std::size_t M, std::size_t N>
+template <typename F>
+bool persistent_snapshot<T, M, N>::find(key_type const& key, F f) const {
+    node_type const* node = root_;
+    if (!node) {
+        return false;
+    }
+
+    while (!node->is_leaf()) {
+        auto inner = static_cast<inner_node_type const*>(node);
+        node = inner->child(inner->upper_child(key));
+    }
+
+    auto leaf = static_cast<leaf_node_type const*>(node);
+    auto it = leaf->find(key);
+    if (it == leaf->cend()) {
+        return false;
+    }
+
+    f(*it);
+    return true;
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline bool persistent_snapshot<T, M, N>::contains(key_type const& key) const {
+    return find(key, [](value_type const&) {});
+}
+
+// Calls `f` with each value in order.
+template <typename T, std::size_t M, std::size_t N>
+template <typename F>
+inline void persistent_snapshot<T, M, N>::for_each(F f) const {
+    if (root_) {
+        for_each(root_, nullptr, nullptr, f);
+    }
+}
+
+// Calls `f` with each value whose key lies in `[lo, hi)`, in order.
+template <typename T, std::size_t M, std::size_t N>
+template <typename F>
+inline void persistent_snapshot<T, M, N>::for_each(key_type const& lo, key_type const& hi,
+                                                   F f) const {
+    if (root_ && comp_(lo, hi)) {
+        for_each(root_, &lo, &hi, f);
+    }
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline bool persistent_snapshot<T, M, N>::empty() const noexcept {
+    return size_ == 0;
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline typename persistent_snapshot<T, M, N>::size_type
+persistent_snapshot<T, M, N>::size() const noexcept {
+    return size_;
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline typename persistent_snapshot<T, M, N>::size_type
+persistent_snapshot<T, M, N>::height() const noexcept {
+    return root_ ? root_->level() + 1 : 0;
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline typename persistent_snapshot<T, M, N>::key_compare
+persistent_snapshot<T, M, N>::key_comp() const {
+    return comp_;
+}
+
+// Drops a reference to `node`, and frees it (and releases its children) if it was the last one.
+template <typename T, std::size_t M, std::size_t N>
+void persistent_snapshot<T, M, N>::release(node_type const* node) noexcept {
+    if (!node || !node->release()) {
+        return;
+    }
+
+    if (node->is_leaf()) {
+        delete static_cast<leaf_node_type const*>(node);
+        return;
+    }
+
+    auto inner = static_cast<inner_node_type const*>(node);
+    for (size_type pos = 0; pos < inner->size(); ++pos) {
+        release(inner->child(pos));
+    }
+
+    delete inner;
+}
+
+// Visits the values of the subtree of `node` with keys in `[*lo, *hi)`, where a null bound is
+// unbounded.
+template <typename T, std::size_t M, std::size_t N>
+template <typename F>
+void persistent_snapshot<T, M, N>::for_each(node_type const* node, key_type const* lo,
+                                            key_type const* hi, F& f) const {
+    if (node->is_leaf()) {
+        auto leaf = static_cast<leaf_node_type const*>(node);
+        auto first = lo ? leaf->lower_bound(*lo) : leaf->cbegin();
+        auto last = hi ? leaf->lower_bound(*hi) : leaf->cend();
+        for (; first != last; ++first) {
+            f(*first);
+        }
+
+        return;
+    }
+
+    auto inner = static_cast<inner_node_type const*>(node);
+    auto first = lo ? inner->upper_child(*lo) : 0;
+    auto last = hi ? inner->upper_child(*hi) : inner->size() - 1;
+    for (auto pos = first; pos <= last; ++pos) {
+        for_each(inner->child(pos), pos == first ? lo : nullptr, pos == last ? hi : nullptr, f);
+    }
+}
+
+/************************************************
+ * Implementation: class persistent_tree<T, M, N>
+ ************************************************/
+
+template <typename T, std::size_t M, std::size_t N>
+inline typename persistent_tree<T, M, N>::snapshot_type
+persistent_tree<T, M, N>::snapshot() const noexcept {
+    return *this;
+}
+
+// Inserts `value` unless its key is present, and returns whether it did.
+template <typename T, std::size_t M, std::size_t N>
+bool persistent_tree<T, M, N>::insert(value_type const& value) {
+    if (!this->root_) {
+        std::unique_ptr<leaf_node_type> leaf(new leaf_node_type(this->comp_));
+        leaf->insert(value);
+        this->root_ = leaf.release();
+        this->size_ = 1;
+        return true;
+    }
+
+    node_type* right = nullptr;
+    auto root = insert(this->root_, this->root_->shared(), value, right);
+    if (!root) {
+        return false;
+    }
+
+    replace_root(root);
+    ++this->size_;
+    if (right) {
+        std::unique_ptr<inner_node_type> grown(
+            new inner_node_type(root->level() + 1, this->comp_));
+        grown->insert_child(0, first_key(root), root);
+        grown->insert_child(1, first_key(right), right);
+        this->root_ = grown.release();
+    }
+
+    return true;
+}
+
+template <typename T, std::size_t M, std::size_t N>
+typename persistent_tree<T, M, N>::size_type persistent_tree<T, M, N>::erase(key_type const& key) {
+    if (!this->root_) {
+        return 0;
+    }
+
+    auto root = erase(this->root_, this->root_->shared(), key);
+    if (!root) {
+        return 0;
+    }
+
+    replace_root(root);
+    --this->size_;
+    if (root->is_leaf()) {
+        if (static_cast<leaf_node_type*>(root)->empty()) {
+            replace_root(nullptr);
+        }
+    } else if (static_cast<inner_node_type*>(root)->size() == 1) {
+        auto child = static_cast<inner_node_type*>(root)->child(0);
+        child->retain();
+        replace_root(child);
+    }
+
+    return 1;
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline void persistent_tree<T, M, N>::clear() noexcept {
+    replace_root(nullptr);
+    this->size_ = 0;
+}
+
+// Inserts `value` into the subtree of `node`, which is `shared` if it or any of its ancestors is
+// referred to by a snapshot. Returns the node to take the place of `node` (`node` itself, unless
+// it had to be copied), or null if the key of `value` is present. Should the node be split, sets
+// `right` to its new right sibling.
+template <typename T, std::size_t M, std::size_t N>
+typename persistent_tree<T, M, N>::node_type*
+persistent_tree<T, M, N>::insert(node_type* node, bool shared, value_type const& value,
+                                 node_type*& right) {
+    auto const& key = value_traits::get_key(value);
+    if (node->is_leaf()) {
+        auto leaf = static_cast<leaf_node_type*>(node);
+        auto it = leaf->lower_bound(key);
+        if (it != leaf->end() && !this->comp_(key, value_traits::get_key(*it))) {
+            return nullptr;
+        }
+
+        auto pos = it - leaf->begin();
+        leaf = own(leaf, shared);
+        if (!leaf->full()) {
+            leaf->insert(leaf->cbegin() + pos, value);
+            return leaf;
+        }
+
+        std::unique_ptr<leaf_node_type> sibling(new leaf_node_type(this->comp_));
+        leaf->split_into(*sibling);
+        (this->comp_(key, sibling->first_key()) ? leaf : sibling.get())->insert(value);
+        right = sibling.release();
+        return leaf;
+    }
+
+    auto inner = static_cast<inner_node_type*>(node);
+    auto pos = inner->upper_child(key);
+    auto child = inner->child(pos);
+    node_type* child_right = nullptr;
+    auto new_child = insert(child, shared || child->shared(), value, child_right);
+    if (!new_child) {
+        return nullptr;
+    }
+
+    inner = own(inner, shared);
+    adopt(inner, pos, new_child);
+    if (!child_right) {
+        return inner;
+    }
+
+    if (inner->full()) {
+        std::unique_ptr<inner_node_type> sibling(
+            new inner_node_type(inner->level(), this->comp_));
+        inner->split_into(*sibling);
+        if (pos < inner->size()) {
+            inner->insert_child(pos + 1, first_key(child_right), child_right);
+        } else {
+            sibling->insert_child(pos + 1 - inner->size(), first_key(child_right), child_right);
+        }
+
+        right = sibling.release();
+    } else {
+        inner->insert_child(pos + 1, first_key(child_right), child_right);
+    }
+
+    return inner;
+}
+
+// Erases `key` from the subtree of `node`, and returns the node to take its place like `insert`.
+// The node returned may be underfull, for its parent to rebalance.
+template <typename T, std::size_t M, std::size_t N>
+typename persistent_tree<T, M, N>::node_type*
+persistent_tree<T, M, N>::erase(node_type* node, bool shared, key_type const& key) {
+    if (node->is_leaf()) {
+        auto leaf = static_cast<leaf_node_type*>(node);
+        auto it = leaf->find(key);
+        if (it == leaf->end()) {
+            return nullptr;
+        }
+
+        auto pos = it - leaf->begin();
+        leaf = own(leaf, shared);
+        leaf->erase(leaf->cbegin() + pos);
+        return leaf;
+    }
+
+    auto inner = static_cast<inner_node_type*>(node);
+    auto pos = inner->upper_child(key);
+    auto child = inner->child(pos);
+    auto new_child = erase(child, shared || child->shared(), key);
+    if (!new_child) {
+        return nullptr;
+    }
+
+    inner = own(inner, shared);
+    adopt(inner, pos, new_child);
+    rebalance(inner, pos);
+    return inner;
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline void persistent_tree<T, M, N>::rebalance(inner_node_type* inner, size_type pos) {
+    if (inner->child(pos)->is_leaf()) {
+        rebalance<leaf_node_type>(inner, pos);
+    } else {
+        rebalance<inner_node_type>(inner, pos);
+    }
+}
+
+// Refills the child of `inner` at `pos` from a sibling if it is underfull, or merges both. Like
+// the child itself, the sibling must be owned by the tree before it is modified.
+template <typename T, std::size_t M, std::size_t N>
+template <typename Node>
+void persistent_tree<T, M, N>::rebalance(inner_node_type* inner, size_type pos) {
+    auto node = static_cast<Node*>(inner->child(pos));
+    if (node->size() >= Node::min_size()) {
+        return;
+    }
+
+    if (pos > 0) {
+        auto left = static_cast<Node*>(inner->child(pos - 1));
+        if (left->size() > Node::min_size()) {
+            left = static_cast<Node*>(own_child(inner, pos - 1));
+            node->borrow_from_left(*left, inner->key(pos));
+            inner->replace_key(pos, node->first_key());
+            return;
+        }
+    }
+
+    if (pos + 1 < inner->size()) {
+        auto right = static_cast<Node*>(inner->child(pos + 1));
+        if (right->size() > Node::min_size()) {
+            right = static_cast<Node*>(own_child(inner, pos + 1));
+            node->borrow_from_right(*right, inner->key(pos + 1));
+            inner->replace_key(pos + 1, right->first_key());
+            return;
+        }
+    }
+
+    if (pos > 0) {
+        auto left = static_cast<Node*>(own_child(inner, pos - 1));
+        left->merge_from(*node, inner->key(pos));
+        inner->erase_child(pos);
+        this->release(node);
+    } else {
+        auto right = static_cast<Node*>(own_child(inner, pos + 1));
+        node->merge_from(*right, inner->key(pos + 1));
+        inner->erase_child(pos + 1);
+        this->release(right);
+    }
+}
+
+// Makes sure the tree owns the child of `inner` at `pos`, which must be owned itself, and returns
+// the child.
+template <typename T, std::size_t M, std::size_t N>
+typename persistent_tree<T, M, N>::node_type*
+persistent_tree<T, M, N>::own_child(inner_node_type* inner, size_type pos) {
+    auto child = inner->child(pos);
+    node_type* owned = child->is_leaf()
+        ? static_cast<node_type*>(own(static_cast<leaf_node_type*>(child), child->shared()))
+        : static_cast<node_type*>(own(static_cast<inner_node_type*>(child), child->shared()));
+    adopt(inner, pos, owned);
+    return owned;
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline void persistent_tree<T, M, N>::replace_root(node_type* root) noexcept {
+    if (root != this->root_) {
+        this->release(this->root_);
+        this->root_ = root;
+    }
+}
+
+// Returns `node` if it is not `shared`, or else a copy of it, which the caller then owns.
+template <typename T, std::size_t M, std::size_t N>
+template <typename Node>
+inline Node* persistent_tree<T, M, N>::own(Node* node, bool shared) {
+    return shared ? new Node(*node) : node;
+}
+
+// Puts `child` in place of the child of `inner` at `pos`, dropping the reference to the former
+// one if they differ.
+template <typename T, std::size_t M, std::size_t N>
+inline void persistent_tree<T, M, N>::adopt(inner_node_type* inner, size_type pos,
+                                            node_type* child) noexcept {
+    auto former = inner->child(pos);
+    if (child != former) {
+        inner->replace_child(pos, child);
+        base_t::release(former);
+    }
+}
+
+template <typename T, std::size_t M, std::size_t N>
+inline typename persistent_tree<T, M, N>::key_type const&
+persistent_tree<T, M, N>::first_key(node_type const* node) {
+    return node->is_leaf() ? static_cast<leaf_node_type const*>(node)->first_key()
+                           : static_cast<inner_node_type const*>(node)->first_key();
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_PERSISTENT_TREE_HPP_
@@ -0,0 +1,50 @@
+/************************************************
+ *  prefetch.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_PREFETCH_HPP_
+#define BPTREE_INTERNAL_PREFETCH_HPP_
+
+#include <cstddef>
+
+#include "./fanout.hpp"
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: prefetch functions
+ ************************************************/
+
+template <typename T>
+void prefetch(T const* ptr) noexcept;
+
+/************************************************
+ * Implementation: prefetch functions
+ ************************************************/
+
+// Hints the processor to load every cache line of `*ptr`, so that the lines a search through it
+// touches one after the other are in flight at once. This is a no-op on compilers without
+// `__builtin_prefetch`.
+template <typename T>
+inline void prefetch(T const* ptr) noexcept {
+#if defined(__GNUC__)
+    auto bytes = reinterpret_cast<char const*>(ptr);
+    for (std::size_t offset = 0; offset < sizeof(T); offset += cache_line_size) {
+        __builtin_prefetch(bytes + offset);
+    }
+#else
+    static_cast<void>(ptr);
+#endif
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_PREFETCH_HPP_
@@ -0,0 +1,34 @@
+/************************************************
+ *  relocatable.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_RELOCATABLE_HPP_
+#define BPTREE_INTERNAL_RELOCATABLE_HPP_
+
+#include <type_traits>
+
+namespace bptree {
+
+/************************************************
+ * Declaration: struct is_trivially_relocatable<T>
+ ************************************************/
+
+// Whether moving a value to new storage and destroying the original amounts to copying its bytes,
+// which lets containers shift values with `std::memmove`. This holds for trivially movable and
+// destructible types by default; types such as `std::unique_ptr` may opt in by specializing this
+// trait in namespace `bptree`.
+template <typename T>
+struct is_trivially_relocatable
+  : std::integral_constant<
+        bool,
+        std::is_trivially_move_constructible<T>::value &&
+            std::is_trivially_destructible<T>::value
+    > {};
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_RELOCATABLE_HPP_
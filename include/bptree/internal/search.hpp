@@ -0,0 +1,430 @@
+/************************************************
+ *  search.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_SEARCH_HPP_
+#define BPTREE_INTERNAL_SEARCH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: search constants and type traits
+ ************************************************/
+
+// Nodes that hold at most this many values are searched with a linear scan instead of a
+// binary search.
+std::size_t constexpr linear_search_max_size = 64;
+
+enum class relation { lt, le, gt, ge };
+
+template <typename Compare, typename Key>
+struct is_builtin_compare : std::false_type {};
+
+template <typename Key>
+struct is_builtin_compare<std::less<Key>, Key> : std::true_type {};
+
+template <typename Key>
+struct is_builtin_compare<std::less<void>, Key> : std::true_type {};
+
+template <typename Key>
+struct is_builtin_compare<std::greater<Key>, Key> : std::true_type {};
+
+template <typename Key>
+struct is_builtin_compare<std::greater<void>, Key> : std::true_type {};
+
+template <typename Compare>
+struct is_greater_compare : std::false_type {};
+
+template <typename Key>
+struct is_greater_compare<std::greater<Key>> : std::true_type {};
+
+template <>
+struct is_greater_compare<std::greater<void>> : std::true_type {};
+
+template <typename T>
+struct simd_ops {
+    static constexpr bool enabled = false;
+};
+
+/************************************************
+ * Declaration: struct search_kernel<T, N>
+ ************************************************/
+
+// Node-local `lower_bound` and `upper_bound`. For arithmetic keys ordered by `std::less` or
+// `std::greater` the position is computed as the number of values satisfying a relation with the
+// key: small nodes count them with a (SIMD, if available) linear scan, and large nodes use a
+// branchless binary search. Other key types fall back to `std::lower_bound`/`std::upper_bound`.
+template <typename ValueTraits, std::size_t N>
+struct search_kernel {
+ private:  // Private Type(s)
+    using key_type = typename ValueTraits::key_type;
+    using value_type = typename ValueTraits::value_type;
+    using key_compare = typename ValueTraits::key_compare;
+
+    template <typename K>
+    using is_accelerated = std::integral_constant<bool,
+        std::is_arithmetic<key_type>::value &&
+        is_builtin_compare<key_compare, key_type>::value &&
+        std::is_same<K, key_type>::value
+    >;
+
+    using is_vectorized = std::integral_constant<bool,
+        std::is_same<key_type, value_type>::value && simd_ops<key_type>::enabled
+    >;
+
+    static constexpr bool is_greater = is_greater_compare<key_compare>::value;
+    static constexpr relation lower_relation = is_greater ? relation::gt : relation::lt;
+    static constexpr relation upper_relation = is_greater ? relation::ge : relation::le;
+
+ public:  // Static Public Method(s)
+    template <typename Iterator, typename K, typename Compare>
+    static Iterator lower_bound(Iterator first, Iterator last, K const& key, Compare comp);
+
+    template <typename Iterator, typename K, typename Compare>
+    static Iterator upper_bound(Iterator first, Iterator last, K const& key, Compare comp);
+
+ private:  // Static Private Method(s)
+    template <typename Iterator, typename K, typename Compare>
+    static Iterator lower_bound(Iterator first, Iterator last, K const& key, Compare comp,
+                                std::false_type);
+    template <typename Iterator, typename K, typename Compare>
+    static Iterator lower_bound(Iterator first, Iterator last, K const& key, Compare comp,
+                                std::true_type);
+    template <typename Iterator, typename K, typename Compare>
+    static Iterator upper_bound(Iterator first, Iterator last, K const& key, Compare comp,
+                                std::false_type);
+    template <typename Iterator, typename K, typename Compare>
+    static Iterator upper_bound(Iterator first, Iterator last, K const& key, Compare comp,
+                                std::true_type);
+
+    template <relation R>
+    static std::size_t count(value_type const* first, std::size_t n, key_type key);
+    template <relation R>
+    static std::size_t scan(value_type const* first, std::size_t n, key_type key,
+                            std::false_type);
+    template <relation R>
+    static std::size_t scan(value_type const* first, std::size_t n, key_type key,
+                            std::true_type);
+};
+
+/************************************************
+ * Declaration: search functions
+ ************************************************/
+
+template <typename T>
+T* to_pointer(T* ptr) noexcept;
+
+template <typename Iterator>
+auto to_pointer(Iterator it) noexcept;
+
+template <relation R, typename T>
+constexpr bool satisfies(T lhs, T rhs) noexcept;
+
+template <relation R, typename ValueTraits>
+std::size_t linear_count(typename ValueTraits::value_type const* first, std::size_t n,
+                         typename ValueTraits::key_type key) noexcept;
+
+template <relation R, typename ValueTraits>
+std::size_t branchless_count(typename ValueTraits::value_type const* first, std::size_t n,
+                             typename ValueTraits::key_type key) noexcept;
+
+template <relation R, typename T>
+std::size_t simd_count(T const* first, std::size_t n, T key) noexcept;
+
+/************************************************
+ * Implementation: struct simd_ops<T>
+ ************************************************/
+
+#if defined(__SSE2__) || defined(__AVX2__)
+
+inline unsigned popcount(unsigned mask) noexcept {
+    return __builtin_popcount(mask);
+}
+
+#endif
+
+#if defined(__AVX2__)
+
+template <>
+struct simd_ops<std::int32_t> {
+    using vector_type = __m256i;
+    static constexpr bool enabled = true;
+    static constexpr std::size_t width = 8;
+
+    static vector_type broadcast(std::int32_t key) noexcept
+        { return _mm256_set1_epi32(key); }
+    static unsigned lt_mask(std::int32_t const* ptr, vector_type key) noexcept {
+        auto values = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(ptr));
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(key, values)));
+    }
+    static unsigned gt_mask(std::int32_t const* ptr, vector_type key) noexcept {
+        auto values = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(ptr));
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(values, key)));
+    }
+};
+
+template <>
+struct simd_ops<std::int64_t> {
+    using vector_type = __m256i;
+    static constexpr bool enabled = true;
+    static constexpr std::size_t width = 4;
+
+    static vector_type broadcast(std::int64_t key) noexcept
+        { return _mm256_set1_epi64x(key); }
+    static unsigned lt_mask(std::int64_t const* ptr, vector_type key) noexcept {
+        auto values = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(ptr));
+        return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(key, values)));
+    }
+    static unsigned gt_mask(std::int64_t const* ptr, vector_type key) noexcept {
+        auto values = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(ptr));
+        return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(values, key)));
+    }
+};
+
+template <>
+struct simd_ops<float> {
+    using vector_type = __m256;
+    static constexpr bool enabled = true;
+    static constexpr std::size_t width = 8;
+
+    static vector_type broadcast(float key) noexcept
+        { return _mm256_set1_ps(key); }
+    static unsigned lt_mask(float const* ptr, vector_type key) noexcept
+        { return _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(ptr), key, _CMP_LT_OQ)); }
+    static unsigned gt_mask(float const* ptr, vector_type key) noexcept
+        { return _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(ptr), key, _CMP_GT_OQ)); }
+};
+
+template <>
+struct simd_ops<double> {
+    using vector_type = __m256d;
+    static constexpr bool enabled = true;
+    static constexpr std::size_t width = 4;
+
+    static vector_type broadcast(double key) noexcept
+        { return _mm256_set1_pd(key); }
+    static unsigned lt_mask(double const* ptr, vector_type key) noexcept
+        { return _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(ptr), key, _CMP_LT_OQ)); }
+    static unsigned gt_mask(double const* ptr, vector_type key) noexcept
+        { return _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(ptr), key, _CMP_GT_OQ)); }
+};
+
+#elif defined(__SSE2__)
+
+template <>
+struct simd_ops<std::int32_t> {
+    using vector_type = __m128i;
+    static constexpr bool enabled = true;
+    static constexpr std::size_t width = 4;
+
+    static vector_type broadcast(std::int32_t key) noexcept
+        { return _mm_set1_epi32(key); }
+    static unsigned lt_mask(std::int32_t const* ptr, vector_type key) noexcept {
+        auto values = _mm_loadu_si128(reinterpret_cast<__m128i const*>(ptr));
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(key, values)));
+    }
+    static unsigned gt_mask(std::int32_t const* ptr, vector_type key) noexcept {
+        auto values = _mm_loadu_si128(reinterpret_cast<__m128i const*>(ptr));
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(values, key)));
+    }
+};
+
+template <>
+struct simd_ops<float> {
+    using vector_type = __m128;
+    static constexpr bool enabled = true;
+    static constexpr std::size_t width = 4;
+
+    static vector_type broadcast(float key) noexcept
+        { return _mm_set1_ps(key); }
+    static unsigned lt_mask(float const* ptr, vector_type key) noexcept
+        { return _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(ptr), key)); }
+    static unsigned gt_mask(float const* ptr, vector_type key) noexcept
+        { return _mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(ptr), key)); }
+};
+
+template <>
+struct simd_ops<double> {
+    using vector_type = __m128d;
+    static constexpr bool enabled = true;
+    static constexpr std::size_t width = 2;
+
+    static vector_type broadcast(double key) noexcept
+        { return _mm_set1_pd(key); }
+    static unsigned lt_mask(double const* ptr, vector_type key) noexcept
+        { return _mm_movemask_pd(_mm_cmplt_pd(_mm_loadu_pd(ptr), key)); }
+    static unsigned gt_mask(double const* ptr, vector_type key) noexcept
+        { return _mm_movemask_pd(_mm_cmpgt_pd(_mm_loadu_pd(ptr), key)); }
+};
+
+#endif
+
+/************************************************
+ * Implementation: struct search_kernel<T, N>
+ ************************************************/
+
+template <typename T, std::size_t N>
+template <typename Iterator, typename K, typename Compare>
+inline Iterator search_kernel<T, N>::lower_bound(
+        Iterator first, Iterator last, K const& key, Compare comp) {
+    return lower_bound(first, last, key, comp, is_accelerated<K>());
+}
+
+template <typename T, std::size_t N>
+template <typename Iterator, typename K, typename Compare>
+inline Iterator search_kernel<T, N>::upper_bound(
+        Iterator first, Iterator last, K const& key, Compare comp) {
+    return upper_bound(first, last, key, comp, is_accelerated<K>());
+}
+
+template <typename T, std::size_t N>
+template <typename Iterator, typename K, typename Compare>
+inline Iterator search_kernel<T, N>::lower_bound(
+        Iterator first, Iterator last, K const& key, Compare comp, std::false_type) {
+    return std::lower_bound(first, last, key, comp);
+}
+
+template <typename T, std::size_t N>
+template <typename Iterator, typename K, typename Compare>
+inline Iterator search_kernel<T, N>::lower_bound(
+        Iterator first, Iterator last, K const& key, Compare, std::true_type) {
+    return first + count<lower_relation>(to_pointer(first), last - first, key);
+}
+
+template <typename T, std::size_t N>
+template <typename Iterator, typename K, typename Compare>
+inline Iterator search_kernel<T, N>::upper_bound(
+        Iterator first, Iterator last, K const& key, Compare comp, std::false_type) {
+    return std::upper_bound(first, last, key, comp);
+}
+
+template <typename T, std::size_t N>
+template <typename Iterator, typename K, typename Compare>
+inline Iterator search_kernel<T, N>::upper_bound(
+        Iterator first, Iterator last, K const& key, Compare, std::true_type) {
+    return first + count<upper_relation>(to_pointer(first), last - first, key);
+}
+
+template <typename T, std::size_t N>
+template <relation R>
+inline std::size_t search_kernel<T, N>::count(
+        value_type const* first, std::size_t n, key_type key) {
+    if (N > linear_search_max_size) {
+        return branchless_count<R, T>(first, n, key);
+    } else {
+        return scan<R>(first, n, key, is_vectorized());
+    }
+}
+
+template <typename T, std::size_t N>
+template <relation R>
+inline std::size_t search_kernel<T, N>::scan(
+        value_type const* first, std::size_t n, key_type key, std::false_type) {
+    return linear_count<R, T>(first, n, key);
+}
+
+template <typename T, std::size_t N>
+template <relation R>
+inline std::size_t search_kernel<T, N>::scan(
+        value_type const* first, std::size_t n, key_type key, std::true_type) {
+    return simd_count<R>(first, n, key);
+}
+
+/************************************************
+ * Implementation: search functions
+ ************************************************/
+
+template <typename T>
+inline T* to_pointer(T* ptr) noexcept {
+    return ptr;
+}
+
+template <typename Iterator>
+inline auto to_pointer(Iterator it) noexcept {
+    return it.operator->();
+}
+
+template <relation R, typename T>
+inline constexpr bool satisfies(T lhs, T rhs) noexcept {
+    return R == relation::lt ? lhs < rhs
+         : R == relation::le ? !(rhs < lhs)
+         : R == relation::gt ? rhs < lhs
+         : !(lhs < rhs);
+}
+
+template <relation R, typename ValueTraits>
+inline std::size_t linear_count(typename ValueTraits::value_type const* first, std::size_t n,
+                                typename ValueTraits::key_type key) noexcept {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        count += satisfies<R>(ValueTraits::get_key(first[i]), key);
+    }
+
+    return count;
+}
+
+template <relation R, typename ValueTraits>
+inline std::size_t branchless_count(typename ValueTraits::value_type const* first, std::size_t n,
+                                    typename ValueTraits::key_type key) noexcept {
+    if (n == 0) {
+        return 0;
+    }
+
+    auto base = first;
+    while (n > 1) {
+        auto half = n / 2;
+        base = satisfies<R>(ValueTraits::get_key(base[half]), key) ? base + half : base;
+        n -= half;
+    }
+
+    return (base - first) + satisfies<R>(ValueTraits::get_key(*base), key);
+}
+
+template <relation R, typename T>
+inline std::size_t simd_count(T const* first, std::size_t n, T key) noexcept {
+    using ops = simd_ops<T>;
+
+    std::size_t count = 0;
+    std::size_t i = 0;
+    auto vkey = ops::broadcast(key);
+    for (; i + ops::width <= n; i += ops::width) {
+        count += (R == relation::lt || R == relation::ge)
+               ? popcount(ops::lt_mask(first + i, vkey))
+               : popcount(ops::gt_mask(first + i, vkey));
+    }
+
+    // "less or equal" and "greater or equal" are complements of the counted masks
+    if (R == relation::le || R == relation::ge) {
+        count = i - count;
+    }
+
+    // fewer than a vector of values are left, which bounds the loop for the compiler as well
+    for (std::size_t tail = 1; tail < ops::width && i < n; ++tail, ++i) {
+        count += satisfies<R>(first[i], key);
+    }
+
+    return count;
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_SEARCH_HPP_
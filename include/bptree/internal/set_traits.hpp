@@ -9,8 +9,12 @@
 #ifndef BPTREE_INTERNAL_SET_TRAITS_HPP_
 #define BPTREE_INTERNAL_SET_TRAITS_HPP_
 
+#include <cstddef>
+
 #include <functional>
 
+#include "./static_vector.hpp"
+
 namespace bptree {
 
 namespace internal {
@@ -26,6 +30,9 @@ struct set_traits {
     using value_type = key_type;
 
     using key_compare = Compare;
+
+    template <std::size_t N>
+    using storage_type = static_vector<value_type, N>;
     using value_compare = key_compare;
 
  protected:  // Protected Type(s)
@@ -41,8 +48,13 @@ struct set_traits {
         }
 
      private:  // Private Method(s)
-        key_compare const& comp_;
+        key_compare comp_;
     };
+
+ public:  // Static Public Method(s)
+    static key_type const& get_key(value_type const& value) noexcept {
+        return value;
+    }
 };
 
 }  // namespace internal
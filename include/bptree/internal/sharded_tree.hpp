@@ -0,0 +1,263 @@
+/************************************************
+ *  sharded_tree.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_SHARDED_TREE_HPP_
+#define BPTREE_INTERNAL_SHARDED_TREE_HPP_
+
+#include <cstddef>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "./deny_duplicates.hpp"
+#include "./fanout.hpp"
+#include "./tree.hpp"
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: class sharded_tree<T, S, M, N>
+ ************************************************/
+
+// Front-end that range-partitions the keys over `Shards` independent trees, each behind its own
+// mutex, so that writers to different key ranges never touch the same root or lock. Shard `i`
+// holds the keys in `[splits[i - 1], splits[i])`; the split points are fixed at construction,
+// either given explicitly or picked by `sample_splits()` from a sample of the expected keys. There
+// is no default constructor, as a map without split points would keep every key in one shard.
+//
+// Lookups and writes lock a single shard. `for_each` visits the shards in key order, locking one
+// at a time, so that values come out globally sorted; it is not a snapshot of the whole map, as
+// shards already visited may change meanwhile. Callbacks run with the lock of their shard held,
+// and must not call back into the map.
+template <typename ValueTraits, std::size_t Shards, std::size_t LeafN, std::size_t InnerN>
+class sharded_tree {
+    static_assert(Shards >= 1, "a sharded tree must have at least 1 shard");
+
+ private:  // Private Type(s)
+    using value_traits = ValueTraits;
+    using tree_type = tree<ValueTraits, deny_duplicates, LeafN, InnerN>;
+
+    // Each shard is allocated on its own, and padded so that the next allocation does not share
+    // the cache line of its mutex.
+    struct shard {
+        explicit shard(typename ValueTraits::key_compare const& comp)
+          : tree(comp)
+            { /* do nothing */ }
+
+        mutable std::mutex mutex;
+        tree_type tree;
+        char padding[cache_line_size];
+    };
+
+ public:  // Public Type(s)
+    using key_type = typename value_traits::key_type;
+    using value_type = typename value_traits::value_type;
+    using key_compare = typename value_traits::key_compare;
+    using size_type = std::size_t;
+
+ public:  // Public Method(s)
+    template <typename InputIt>
+    sharded_tree(InputIt first_split, InputIt last_split, key_compare const& comp = key_compare());
+    sharded_tree(sharded_tree const&) = delete;
+
+    sharded_tree& operator=(sharded_tree const&) = delete;
+
+    bool insert(value_type const& value);
+    size_type erase(key_type const& key);
+
+    template <typename F>
+    bool find(key_type const& key, F f) const;
+    bool contains(key_type const& key) const;
+
+    template <typename F>
+    void for_each(F f) const;
+    template <typename F>
+    void for_each(key_type const& lo, key_type const& hi, F f) const;
+
+    size_type size() const;
+    bool empty() const;
+    key_compare key_comp() const;
+
+    std::vector<key_type> const& splits() const noexcept;
+    size_type shard_of(key_type const& key) const;
+
+ public:  // Public Static Method(s)
+    template <typename InputIt>
+    static std::vector<key_type> sample_splits(InputIt first, InputIt last,
+                                               key_compare const& comp = key_compare());
+
+ private:  // Private Method(s)
+    void create_shards();
+
+ private:  // Private Property(ies)
+    key_compare comp_;
+    std::vector<key_type> splits_;
+    std::vector<std::unique_ptr<shard>> shards_;
+};
+
+/************************************************
+ * Implementation: class sharded_tree<T, S, M, N>
+ ************************************************/
+
+// Splits the keys at `[first_split, last_split)`, which must be sorted. Only the first
+// `Shards - 1` split points are used; with fewer, the last shards stay empty.
+template <typename T, std::size_t S, std::size_t M, std::size_t N>
+template <typename InputIt>
+inline sharded_tree<T, S, M, N>::sharded_tree(InputIt first_split, InputIt last_split,
+                                              key_compare const& comp)
+  : comp_(comp) {
+    for (; first_split != last_split && splits_.size() < S - 1; ++first_split) {
+        splits_.push_back(*first_split);
+    }
+
+    create_shards();
+}
+
+template <typename T, std::size_t S, std::size_t M, std::size_t N>
+inline bool sharded_tree<T, S, M, N>::insert(value_type const& value) {
+    auto& target = *shards_[shard_of(value_traits::get_key(value))];
+    std::lock_guard<std::mutex> lock(target.mutex);
+    return target.tree.insert(value).second;
+}
+
+template <typename T, std::size_t S, std::size_t M, std::size_t N>
+inline typename sharded_tree<T, S, M, N>::size_type
+sharded_tree<T, S, M, N>::erase(key_type const& key) {
+    auto& target = *shards_[shard_of(key)];
+    std::lock_guard<std::mutex> lock(target.mutex);
+    return target.tree.erase(key);
+}
+
+// Calls `f` with the value of `key`, if there is one, and returns whether there was.
+template <typename T, std::size_t S, std::size_t M, std::size_t N>
+template <typename F>
+inline bool sharded_tree<T, S, M, N>::find(key_type const& key, F f) const {
+    auto const& target = *shards_[shard_of(key)];
+    std::lock_guard<std::mutex> lock(target.mutex);
+    auto it = target.tree.find(key);
+    if (it == target.tree.cend()) {
+        return false;
+    }
+
+    f(*it);
+    return true;
+}
+
+template <typename T, std::size_t S, std::size_t M, std::size_t N>
+inline bool sharded_tree<T, S, M, N>::contains(key_type const& key) const {
+    return find(key, [](value_type const&) {});
+}
+
+// Calls `f(value)` for every value, in key order.
+template <typename T, std::size_t S, std::size_t M, std::size_t N>
+template <typename F>
+inline void sharded_tree<T, S, M, N>::for_each(F f) const {
+    for (auto const& target : shards_) {
+        std::lock_guard<std::mutex> lock(target->mutex);
+        target->tree.for_each_span([&f](value_type const* data, size_type size) {
+            for (size_type i = 0; i < size; ++i) {
+                f(data[i]);
+            }
+        });
+    }
+}
+
+// Same as above, for the values with keys in [lo, hi). Only the shards overlapping the range are
+// locked.
+template <typename T, std::size_t S, std::size_t M, std::size_t N>
+template <typename F>
+inline void sharded_tree<T, S, M, N>::for_each(key_type const& lo, key_type const& hi,
+                                               F f) const {
+    if (!comp_(lo, hi)) {
+        return;
+    }
+
+    for (auto i = shard_of(lo), last = shard_of(hi); i <= last; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i]->mutex);
+        shards_[i]->tree.for_each_span(lo, hi, [&f](value_type const* data, size_type size) {
+            for (size_type j = 0; j < size; ++j) {
+                f(data[j]);
+            }
+        });
+    }
+}
+
+// Only exact while no writer is active.
+template <typename T, std::size_t S, std::size_t M, std::size_t N>
+inline typename sharded_tree<T, S, M, N>::size_type sharded_tree<T, S, M, N>::size() const {
+    size_type count = 0;
+    for (auto const& target : shards_) {
+        std::lock_guard<std::mutex> lock(target->mutex);
+        count += target->tree.size();
+    }
+
+    return count;
+}
+
+template <typename T, std::size_t S, std::size_t M, std::size_t N>
+inline bool sharded_tree<T, S, M, N>::empty() const {
+    return size() == 0;
+}
+
+template <typename T, std::size_t S, std::size_t M, std::size_t N>
+inline typename sharded_tree<T, S, M, N>::key_compare sharded_tree<T, S, M, N>::key_comp() const {
+    return comp_;
+}
+
+template <typename T, std::size_t S, std::size_t M, std::size_t N>
+inline std::vector<typename sharded_tree<T, S, M, N>::key_type> const&
+sharded_tree<T, S, M, N>::splits() const noexcept {
+    return splits_;
+}
+
+// Index of the shard that holds `key`. The split points never change, so that no lock is needed.
+template <typename T, std::size_t S, std::size_t M, std::size_t N>
+inline typename sharded_tree<T, S, M, N>::size_type
+sharded_tree<T, S, M, N>::shard_of(key_type const& key) const {
+    return std::upper_bound(splits_.cbegin(), splits_.cend(), key, comp_) - splits_.cbegin();
+}
+
+// Picks split points that cut the keys in `[first, last)` into `Shards` parts of about the same
+// size, so that a sample of the expected keys spreads them evenly. Keys repeated in the sample
+// yield a single split point.
+template <typename T, std::size_t S, std::size_t M, std::size_t N>
+template <typename InputIt>
+std::vector<typename sharded_tree<T, S, M, N>::key_type>
+sharded_tree<T, S, M, N>::sample_splits(InputIt first, InputIt last, key_compare const& comp) {
+    std::vector<key_type> sample(first, last);
+    std::sort(sample.begin(), sample.end(), comp);
+
+    std::vector<key_type> splits;
+    for (size_type i = 1; i < S && !sample.empty(); ++i) {
+        auto const& key = sample[sample.size() * i / S];
+        if (splits.empty() || comp(splits.back(), key)) {
+            splits.push_back(key);
+        }
+    }
+
+    return splits;
+}
+
+template <typename T, std::size_t S, std::size_t M, std::size_t N>
+void sharded_tree<T, S, M, N>::create_shards() {
+    shards_.reserve(S);
+    for (size_type i = 0; i < S; ++i) {
+        shards_.emplace_back(new shard(comp_));
+    }
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_SHARDED_TREE_HPP_
@@ -0,0 +1,64 @@
+/************************************************
+ *  sorted_input.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_SORTED_INPUT_HPP_
+#define BPTREE_INTERNAL_SORTED_INPUT_HPP_
+
+#include <algorithm>
+#include <iterator>
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: struct sorted_input_t
+ ************************************************/
+
+// Tag for constructors whose input range is known to be sorted by the value comparator. Values
+// equivalent to a preceding one are dropped by containers that deny duplicates.
+struct sorted_input_t {
+    explicit sorted_input_t() = default;
+};
+
+sorted_input_t constexpr sorted_input{};
+
+/************************************************
+ * Declaration: sorted input functions
+ ************************************************/
+
+template <typename InputIt, typename Compare>
+bool is_sorted_input(InputIt first, InputIt last, Compare comp);
+
+/************************************************
+ * Implementation: sorted input functions
+ ************************************************/
+
+template <typename InputIt, typename Compare>
+inline bool is_sorted_input(InputIt, InputIt, Compare, std::input_iterator_tag) {
+    // single-pass ranges can not be inspected before being consumed
+    return false;
+}
+
+template <typename ForwardIt, typename Compare>
+inline bool is_sorted_input(ForwardIt first, ForwardIt last, Compare comp,
+                            std::forward_iterator_tag) {
+    return std::is_sorted(first, last, comp);
+}
+
+template <typename InputIt, typename Compare>
+inline bool is_sorted_input(InputIt first, InputIt last, Compare comp) {
+    return is_sorted_input(first, last, comp,
+                           typename std::iterator_traits<InputIt>::iterator_category());
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_SORTED_INPUT_HPP_
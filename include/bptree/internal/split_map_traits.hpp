@@ -0,0 +1,124 @@
+/************************************************
+ *  split_map_traits.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_SPLIT_MAP_TRAITS_HPP_
+#define BPTREE_INTERNAL_SPLIT_MAP_TRAITS_HPP_
+
+#include <cstddef>
+
+#include <functional>
+#include <utility>
+
+#include "./search.hpp"
+#include "./set_traits.hpp"
+#include "./static_split_vector.hpp"
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: struct split_map_traits<K, T, C>
+ ************************************************/
+
+// Same as `map_traits`, but stores keys and mapped values in separate arrays. Iterators of the
+// resulting containers yield `std::pair<key_type const&, mapped_type&>` proxies. The map interface
+// of `static_assoc` over this layout lives in `static_split_assoc.hpp`, which is included at the
+// end of this header.
+template <typename Key, typename T, typename Compare = std::less<Key>>
+struct split_map_traits {
+ public:  // Public Type(s)
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<key_type const, mapped_type>;
+
+    using key_compare = Compare;
+
+    template <std::size_t N>
+    using storage_type = static_split_vector<key_type, mapped_type, N>;
+
+    class value_compare : protected key_compare {
+     protected:  // Protected Method(s)
+        explicit value_compare(key_compare comp)
+          : key_compare(comp)
+            { /* do nothing */ }
+
+     public:  // Public Method(s)
+        template <typename F1, typename S1, typename F2, typename S2>
+        bool operator()(std::pair<F1, S1> const& lhs, std::pair<F2, S2> const& rhs) const {
+            return key_compare::operator()(lhs.first, rhs.first);
+        }
+    };
+
+ protected:  // Protected Type(s)
+    class core_compare {
+     public:  // Public Method(s)
+        explicit core_compare(key_compare comp)
+          : comp_(comp)
+            { /* do nothing */ }
+
+        template <typename K, typename F, typename S>
+        bool operator()(K const& lhs, std::pair<F, S> const& rhs) const {
+            return comp_(lhs, rhs.first);
+        }
+
+        template <typename F, typename S, typename K>
+        bool operator()(std::pair<F, S> const& lhs, K const& rhs) const {
+            return comp_(lhs.first, rhs);
+        }
+
+        key_compare key_comp() const {
+            return comp_;
+        }
+
+     private:  // Private Method(s)
+        key_compare comp_;
+    };
+
+ public:  // Static Public Method(s)
+    template <typename F, typename S>
+    static key_type const& get_key(std::pair<F, S> const& value) noexcept {
+        return value.first;
+    }
+};
+
+/************************************************
+ * Declaration: struct search_kernel<split_map_traits<K, T, C>, N>
+ ************************************************/
+
+// Searches run over the dense key array only, so they get the same kernel as a set of keys.
+template <typename Key, typename T, typename Compare, std::size_t N>
+struct search_kernel<split_map_traits<Key, T, Compare>, N> {
+ private:  // Private Type(s)
+    using key_search_kernel = search_kernel<set_traits<Key, Compare>, N>;
+
+ public:  // Static Public Method(s)
+    template <typename Iterator, typename K, typename CoreCompare>
+    static Iterator lower_bound(Iterator first, Iterator last, K const& key, CoreCompare comp) {
+        auto keys = first.keys();
+        auto it = key_search_kernel::lower_bound(keys, keys + (last - first), key, comp.key_comp());
+        return first + (it - keys);
+    }
+
+    template <typename Iterator, typename K, typename CoreCompare>
+    static Iterator upper_bound(Iterator first, Iterator last, K const& key, CoreCompare comp) {
+        auto keys = first.keys();
+        auto it = key_search_kernel::upper_bound(keys, keys + (last - first), key, comp.key_comp());
+        return first + (it - keys);
+    }
+};
+
+}  // namespace internal
+
+}  // namespace bptree
+
+// every user of the traits must see the `static_assoc` specialization for them, or containers of
+// the same type would differ between translation units
+#include "./static_split_assoc.hpp"
+
+#endif  // BPTREE_INTERNAL_SPLIT_MAP_TRAITS_HPP_
@@ -13,6 +13,8 @@
 
 #include <algorithm>
 #include <initializer_list>
+#include <iterator>
+#include <numeric>
 #include <stdexcept>
 #include <type_traits>
 #include <tuple>
@@ -20,6 +22,8 @@
 
 #include "./deny_duplicates.hpp"
 #include "./map_traits.hpp"
+#include "./search.hpp"
+#include "./sorted_input.hpp"
 #include "./static_vector.hpp"
 
 namespace bptree {
@@ -34,10 +38,13 @@ template <typename ValueTraits, template <typename, typename> class InsertionPol
 class static_assoc_base
   : public ValueTraits,
     private ValueTraits::value_compare {
+ protected:  // Protected Type(s)
+    using underlying_type = typename ValueTraits::template storage_type<N>;
+
  private:  // Private Type(s)
     using value_traits = ValueTraits;
-    using underlying_type = static_vector<typename value_traits::value_type, N>;
     using core_compare = typename value_traits::core_compare;
+    using search_kernel_type = search_kernel<value_traits, N>;
 
     using insertion_policy = InsertionPolicy<underlying_type, typename value_traits::value_compare>;
     using insert_result_t = typename insertion_policy::insert_result_t;
@@ -48,6 +55,12 @@ class static_assoc_base
             T
         >::type;
 
+    // keeps heterogeneous keys from capturing iterators meant for `erase(const_iterator)`
+    template <typename K>
+    using enable_if_key_t = typename std::enable_if<
+            !std::is_convertible<K const&, typename underlying_type::const_iterator>::value
+        >::type;
+
  public:  // Public Type(s)
     using key_type = typename value_traits::key_type;
     using value_type = typename value_traits::value_type;
@@ -71,6 +84,9 @@ class static_assoc_base
     explicit static_assoc_base(key_compare comp);
     template <typename InputIt>
     static_assoc_base(InputIt first, InputIt last, key_compare const& comp = key_compare());
+    template <typename InputIt>
+    static_assoc_base(sorted_input_t, InputIt first, InputIt last,
+                      key_compare const& comp = key_compare());
     static_assoc_base(std::initializer_list<value_type> il,
                       key_compare const& comp = key_compare());
     static_assoc_base(static_assoc_base const&) = default;
@@ -90,6 +106,8 @@ class static_assoc_base
     template <typename InputIt>
     void insert(InputIt first, InputIt last);
     void insert(std::initializer_list<value_type> il);
+    template <typename ForwardIt>
+    static_vector<insert_result_t, N> insert_batch(ForwardIt first, ForwardIt last);
     template <typename... Args>
     insert_result_t emplace(Args&&... args);
     template <typename... Args>
@@ -97,6 +115,10 @@ class static_assoc_base
     iterator erase(const_iterator pos);
     iterator erase(const_iterator first, const_iterator last);
     size_type erase(key_type const& key);
+    template <typename K, typename Compare = key_compare,
+              typename = typename Compare::is_transparent,
+              typename = enable_if_key_t<K>>
+    size_type erase(K const& key);
     void clear() noexcept;
 
     bool empty() const noexcept;
@@ -175,6 +197,17 @@ class static_assoc_base
 
  protected:  // Protected Method(s)
     core_compare core_comp() const;
+    underlying_type& values() noexcept;
+    underlying_type const& values() const noexcept;
+    template <typename V>
+    bool append(V&& value);
+    template <typename InputIt>
+    void append(InputIt first, InputIt last);
+
+ private:  // Private Method(s)
+    static void assign_result(iterator& result, iterator it, bool inserted) noexcept;
+    static void assign_result(std::pair<iterator, bool>& result, iterator it,
+                              bool inserted) noexcept;
 
  private:  // Private Property(ies)
     underlying_type values_;
@@ -192,26 +225,73 @@ class static_assoc
 };
 
 /************************************************
- * Declaration: class static_assoc<map_traits<K, T, C>, deny_duplicates, N>
+ * Declaration: class static_assoc_map_base<T, N>
  ************************************************/
 
-template <typename Key, typename T, typename Compare, std::size_t N>
-class static_assoc<map_traits<Key, T, Compare>, deny_duplicates, N>
-  : public static_assoc_base<map_traits<Key, T, Compare>, deny_duplicates, N> {
+// Map interface of the `static_assoc` specializations for maps without duplicates, shared by all
+// their storage layouts.
+template <typename ValueTraits, std::size_t N>
+class static_assoc_map_base
+  : public static_assoc_base<ValueTraits, deny_duplicates, N> {
  private:  // Private Type(s)
-    using base_t = static_assoc_base<map_traits<Key, T, Compare>, deny_duplicates, N>;
+    using base_t = static_assoc_base<ValueTraits, deny_duplicates, N>;
 
  public:  // Public Type(s)
     using mapped_type = typename base_t::mapped_type;
-    using key_type = typename base_t::key_type;;
+    using key_type = typename base_t::key_type;
+    using key_compare = typename base_t::key_compare;
+    using iterator = typename base_t::iterator;
+
+ private:  // Private Type(s)
+    template <typename K>
+    using enable_if_key_constructible_t = typename std::enable_if<
+            std::is_constructible<key_type, K&&>::value
+        >::type;
 
  public:  // Public Method(s)
     using base_t::base_t;
 
     mapped_type& operator[](key_type const& key);
     mapped_type& operator[](key_type&& key);
+    template <typename K, typename KeyCompare = key_compare,
+              typename = typename KeyCompare::is_transparent,
+              typename = enable_if_key_constructible_t<K>>
+    mapped_type& operator[](K&& key);
     mapped_type& at(key_type const& key);
+    template <typename K, typename KeyCompare = key_compare,
+              typename = typename KeyCompare::is_transparent>
+    mapped_type& at(K const& key);
     mapped_type const& at(key_type const& key) const;
+    template <typename K, typename KeyCompare = key_compare,
+              typename = typename KeyCompare::is_transparent>
+    mapped_type const& at(K const& key) const;
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(key_type const& key, Args&&... args);
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args);
+    template <typename K, typename... Args, typename KeyCompare = key_compare,
+              typename = typename KeyCompare::is_transparent,
+              typename = enable_if_key_constructible_t<K>>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args);
+    template <typename Obj>
+    std::pair<iterator, bool> insert_or_assign(key_type const& key, Obj&& obj);
+    template <typename Obj>
+    std::pair<iterator, bool> insert_or_assign(key_type&& key, Obj&& obj);
+
+ private:  // Private Method(s)
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> emplace_key(K&& key, Args&&... args);
+};
+
+/************************************************
+ * Declaration: class static_assoc<map_traits<K, T, C>, deny_duplicates, N>
+ ************************************************/
+
+template <typename Key, typename T, typename Compare, std::size_t N>
+class static_assoc<map_traits<Key, T, Compare>, deny_duplicates, N>
+  : public static_assoc_map_base<map_traits<Key, T, Compare>, N> {
+ public:  // Public Method(s)
+    using static_assoc_map_base<map_traits<Key, T, Compare>, N>::static_assoc_map_base;
 };
 
 /************************************************
@@ -234,10 +314,15 @@ template <typename T, template <typename, typename> class I, std::size_t N>
 template <typename InputIt>
 static_assoc_base<T, I, N>::static_assoc_base(InputIt first, InputIt last, key_compare const& comp)
   : static_assoc_base(comp) {
-    while (first != last) {
-        emplace_hint(cend(), *first);
-        ++first;
-    }
+    insert(first, last);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t N>
+template <typename InputIt>
+inline static_assoc_base<T, I, N>::static_assoc_base(
+        sorted_input_t, InputIt first, InputIt last, key_compare const& comp)
+  : static_assoc_base(comp) {
+    append(first, last);
 }
 
 template <typename T, template <typename, typename> class I, std::size_t N>
@@ -269,7 +354,7 @@ inline void static_assoc_base<T, I, N>::swap(static_assoc_base& other) {
 template <typename T, template <typename, typename> class I, std::size_t N>
 typename static_assoc_base<T, I, N>::insert_result_t
 static_assoc_base<T, I, N>::insert(value_type const& value) {
-    auto it = std::upper_bound(cbegin(), cend(), value, value_comp());
+    auto it = upper_bound(value_traits::get_key(value));
     return insertion_policy::try_insert(values_, value_comp(), it, value);
 }
 
@@ -308,6 +393,11 @@ static_assoc_base<T, I, N>::insert(const_iterator hint, V&& value) {
 template <typename T, template <typename, typename> class I, std::size_t N>
 template <typename InputIt>
 void static_assoc_base<T, I, N>::insert(InputIt first, InputIt last) {
+    if (empty() && is_sorted_input(first, last, value_comp())) {
+        append(first, last);
+        return;
+    }
+
     while (first != last) {
         insert(*first);
         ++first;
@@ -319,12 +409,85 @@ inline void static_assoc_base<T, I, N>::insert(std::initializer_list<value_type>
     insert(il.begin(), il.end());
 }
 
+// Inserts the values of [first, last) as as many calls to `insert` would, and returns their
+// results in input order. The batch may hold at most `N` values, and the node must have room for
+// those the insertion policy accepts; otherwise, `std::length_error` is thrown and the node is left
+// untouched.
+template <typename T, template <typename, typename> class I, std::size_t N>
+template <typename ForwardIt>
+static_vector<typename static_assoc_base<T, I, N>::insert_result_t, N>
+static_assoc_base<T, I, N>::insert_batch(ForwardIt first, ForwardIt last) {
+    auto count = static_cast<size_type>(std::distance(first, last));
+    if (count > N) {
+        throw std::length_error("batch larger than the node capacity");
+    }
+
+    // values of maps are not assignable, so sort the batch through indices into its iterators;
+    // the sort is stable to keep equivalent values in input order, as inserting them one by one
+    // would
+    static_vector<ForwardIt, N> batch;
+    for (; first != last; ++first) {
+        batch.push_back(first);
+    }
+
+    static_vector<size_type, N> order(count);
+    std::iota(order.begin(), order.end(), size_type(0));
+    std::stable_sort(order.begin(), order.end(), [this, &batch](size_type lhs, size_type rhs) {
+        return value_compare::operator()(*batch[lhs], *batch[rhs]);
+    });
+
+    // walk the sorted batch and the stored values together to find the offset at which each
+    // value goes and whether the insertion policy accepts it there
+    static_vector<value_type, N> accepted;
+    static_vector<size_type, N> offsets;
+    static_vector<size_type, N> positions(count);
+    static_vector<bool, N> inserted(count);
+
+    size_type offset = 0;
+    for (auto index : order) {
+        auto const& value = *batch[index];
+        while (offset < size() && !value_compare::operator()(value, values_[offset])) {
+            ++offset;
+        }
+
+        // an accepted batch value at the same offset is the one the value would follow
+        auto follows_batch = !offsets.empty() && offsets.back() == offset;
+        inserted[index] = follows_batch
+            ? insertion_policy::is_insertable_after(value_comp(), accepted.back(), value)
+            : insertion_policy::is_insertable(values_, value_comp(),
+                                              values_.cbegin() + offset, value);
+        if (inserted[index]) {
+            positions[index] = offset + offsets.size();
+            offsets.push_back(offset);
+            accepted.push_back(value);
+        } else if (follows_batch) {
+            positions[index] = offsets.back() + offsets.size() - 1;
+        } else {
+            positions[index] = offset - 1 + offsets.size();
+        }
+    }
+
+    if (size() + accepted.size() > capacity()) {
+        throw std::length_error("no room for the batch in the node");
+    }
+
+    values_.insert_at(offsets.cbegin(), std::make_move_iterator(accepted.begin()),
+                      std::make_move_iterator(accepted.end()));
+
+    static_vector<insert_result_t, N> results(count);
+    for (size_type index = 0; index < count; ++index) {
+        assign_result(results[index], begin() + positions[index], inserted[index]);
+    }
+
+    return results;
+}
+
 template <typename T, template <typename, typename> class I, std::size_t N>
 template <typename... Args>
 typename static_assoc_base<T, I, N>::insert_result_t
 static_assoc_base<T, I, N>::emplace(Args&&... args) {
     value_type value(std::forward<Args>(args)...);
-    auto it = std::upper_bound(cbegin(), cend(), value, value_comp());
+    auto it = upper_bound(value_traits::get_key(value));
     return insertion_policy::try_insert(values_, value_comp(), it, std::move(value));
 }
 
@@ -364,6 +527,15 @@ static_assoc_base<T, I, N>::erase(key_type const& key) {
     return range.second - range.first;
 }
 
+template <typename T, template <typename, typename> class I, std::size_t N>
+template <typename K, typename Compare, typename, typename>
+typename static_assoc_base<T, I, N>::size_type
+static_assoc_base<T, I, N>::erase(K const& key) {
+    auto range = equal_range(key);
+    erase(range.first, range.second);
+    return range.second - range.first;
+}
+
 template <typename T, template <typename, typename> class I, std::size_t N>
 inline void static_assoc_base<T, I, N>::clear() noexcept {
     values_.clear();
@@ -454,7 +626,7 @@ inline std::pair<
     typename static_assoc_base<T, I, N>::iterator
 >
 static_assoc_base<T, I, N>::equal_range(key_type const& key) {
-    return std::equal_range(begin(), end(), key, core_comp());
+    return {lower_bound(key), upper_bound(key)};
 }
 
 template <typename T, template <typename, typename> class I, std::size_t N>
@@ -464,7 +636,7 @@ inline std::pair<
     typename static_assoc_base<T, I, N>::iterator
 >
 static_assoc_base<T, I, N>::equal_range(K const& key) {
-    return std::equal_range(begin(), end(), key, core_comp());
+    return {lower_bound(key), upper_bound(key)};
 }
 
 template <typename T, template <typename, typename> class I, std::size_t N>
@@ -473,7 +645,7 @@ inline std::pair<
     typename static_assoc_base<T, I, N>::const_iterator
 >
 static_assoc_base<T, I, N>::equal_range(key_type const& key) const {
-    return std::equal_range(cbegin(), cend(), key, core_comp());
+    return {lower_bound(key), upper_bound(key)};
 }
 
 template <typename T, template <typename, typename> class I, std::size_t N>
@@ -483,59 +655,59 @@ inline std::pair<
     typename static_assoc_base<T, I, N>::const_iterator
 >
 static_assoc_base<T, I, N>::equal_range(K const& key) const {
-    return std::equal_range(cbegin(), cend(), key, core_comp());
+    return {lower_bound(key), upper_bound(key)};
 }
 
 template <typename T, template <typename, typename> class I, std::size_t N>
 inline typename static_assoc_base<T, I, N>::iterator
 static_assoc_base<T, I, N>::lower_bound(key_type const& key) {
-    return std::lower_bound(begin(), end(), key, core_comp());
+    return search_kernel_type::lower_bound(begin(), end(), key, core_comp());
 }
 
 template <typename T, template <typename, typename> class I, std::size_t N>
 template <typename K, typename Compare, typename>
 inline typename static_assoc_base<T, I, N>::iterator
 static_assoc_base<T, I, N>::lower_bound(K const& key) {
-    return std::lower_bound(begin(), end(), key, core_comp());
+    return search_kernel_type::lower_bound(begin(), end(), key, core_comp());
 }
 
 template <typename T, template <typename, typename> class I, std::size_t N>
 inline typename static_assoc_base<T, I, N>::const_iterator
 static_assoc_base<T, I, N>::lower_bound(key_type const& key) const {
-    return std::lower_bound(cbegin(), cend(), key, core_comp());
+    return search_kernel_type::lower_bound(cbegin(), cend(), key, core_comp());
 }
 
 template <typename T, template <typename, typename> class I, std::size_t N>
 template <typename K, typename Compare, typename>
 inline typename static_assoc_base<T, I, N>::const_iterator
 static_assoc_base<T, I, N>::lower_bound(K const& key) const {
-    return std::lower_bound(cbegin(), cend(), key, core_comp());
+    return search_kernel_type::lower_bound(cbegin(), cend(), key, core_comp());
 }
 
 template <typename T, template <typename, typename> class I, std::size_t N>
 inline typename static_assoc_base<T, I, N>::iterator
 static_assoc_base<T, I, N>::upper_bound(key_type const& key) {
-    return std::upper_bound(begin(), end(), key, core_comp());
+    return search_kernel_type::upper_bound(begin(), end(), key, core_comp());
 }
 
 template <typename T, template <typename, typename> class I, std::size_t N>
 template <typename K, typename Compare, typename>
 inline typename static_assoc_base<T, I, N>::iterator
 static_assoc_base<T, I, N>::upper_bound(K const& key) {
-    return std::upper_bound(begin(), end(), key, core_comp());
+    return search_kernel_type::upper_bound(begin(), end(), key, core_comp());
 }
 
 template <typename T, template <typename, typename> class I, std::size_t N>
 inline typename static_assoc_base<T, I, N>::const_iterator
 static_assoc_base<T, I, N>::upper_bound(key_type const& key) const {
-    return std::upper_bound(cbegin(), cend(), key, core_comp());
+    return search_kernel_type::upper_bound(cbegin(), cend(), key, core_comp());
 }
 
 template <typename T, template <typename, typename> class I, std::size_t N>
 template <typename K, typename Compare, typename>
 inline typename static_assoc_base<T, I, N>::const_iterator
 static_assoc_base<T, I, N>::upper_bound(K const& key) const {
-    return std::upper_bound(cbegin(), cend(), key, core_comp());
+    return search_kernel_type::upper_bound(cbegin(), cend(), key, core_comp());
 }
 
 template <typename T, template <typename, typename> class I, std::size_t N>
@@ -619,7 +791,7 @@ static_assoc_base<T, I, N>::key_comp() const {
 template <typename T, template <typename, typename> class I, std::size_t N>
 inline typename static_assoc_base<T, I, N>::value_compare
 static_assoc_base<T, I, N>::value_comp() const {
-    return value_compare(*this);
+    return static_cast<value_compare const&>(*this);
 }
 
 template <typename T, template <typename, typename> class I, std::size_t N>
@@ -628,44 +800,104 @@ static_assoc_base<T, I, N>::core_comp() const {
     return core_compare(*this);
 }
 
+template <typename T, template <typename, typename> class I, std::size_t N>
+inline typename static_assoc_base<T, I, N>::underlying_type&
+static_assoc_base<T, I, N>::values() noexcept {
+    return values_;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t N>
+inline typename static_assoc_base<T, I, N>::underlying_type const&
+static_assoc_base<T, I, N>::values() const noexcept {
+    return values_;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t N>
+template <typename V>
+inline bool static_assoc_base<T, I, N>::append(V&& value) {
+    // the value is known to be ordered after every stored one, so no search is needed
+    if (!insertion_policy::is_insertable(values_, value_comp(), values_.cend(), value)) {
+        return false;
+    }
+
+    values_.insert(values_.cend(), std::forward<V>(value));
+    return true;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t N>
+template <typename InputIt>
+void static_assoc_base<T, I, N>::append(InputIt first, InputIt last) {
+    while (first != last) {
+        append(*first);
+        ++first;
+    }
+}
+
+template <typename T, template <typename, typename> class I, std::size_t N>
+inline void static_assoc_base<T, I, N>::assign_result(
+        iterator& result, iterator it, bool) noexcept {
+    result = it;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t N>
+inline void static_assoc_base<T, I, N>::assign_result(
+        std::pair<iterator, bool>& result, iterator it, bool inserted) noexcept {
+    result = {it, inserted};
+}
+
 /************************************************
- * Implementation: class static_assoc<map_traits<K, T, C>, deny_duplicates, N>
+ * Implementation: class static_assoc_map_base<T, N>
  ************************************************/
 
-template <typename K, typename T, typename C, std::size_t N>
-typename static_assoc<map_traits<K, T, C>, deny_duplicates, N>::mapped_type&
-static_assoc<map_traits<K, T, C>, deny_duplicates, N>::operator[](key_type const& key) {
-    auto it = this->lower_bound(key);
-    if (this->core_comp()(key, *it)) {
-        it = this->emplace_hint(it, std::piecewise_construct,
-                                std::forward_as_tuple(key), std::tuple<>());
-    }
+template <typename T, std::size_t N>
+typename static_assoc_map_base<T, N>::mapped_type&
+static_assoc_map_base<T, N>::operator[](key_type const& key) {
+    return try_emplace(key).first->second;
+}
 
-    return it->second;
+template <typename T, std::size_t N>
+typename static_assoc_map_base<T, N>::mapped_type&
+static_assoc_map_base<T, N>::operator[](key_type&& key) {
+    return try_emplace(std::move(key)).first->second;
 }
 
-template <typename K, typename T, typename C, std::size_t N>
-typename static_assoc<map_traits<K, T, C>, deny_duplicates, N>::mapped_type&
-static_assoc<map_traits<K, T, C>, deny_duplicates, N>::operator[](key_type&& key) {
-    auto it = this->lower_bound(key);
-    if (this->core_comp()(key, *it)) {
-        it = this->emplace_hint(it, std::piecewise_construct,
-                                std::forward_as_tuple(std::move(key)), std::tuple<>());
+template <typename T, std::size_t N>
+template <typename Key, typename KeyCompare, typename, typename>
+typename static_assoc_map_base<T, N>::mapped_type&
+static_assoc_map_base<T, N>::operator[](Key&& key) {
+    return try_emplace(std::forward<Key>(key)).first->second;
+}
+
+template <typename T, std::size_t N>
+inline typename static_assoc_map_base<T, N>::mapped_type&
+static_assoc_map_base<T, N>::at(key_type const& key) {
+    return const_cast<mapped_type&>(
+        static_cast<static_assoc_map_base const*>(this)->at(key));
+}
+
+template <typename T, std::size_t N>
+typename static_assoc_map_base<T, N>::mapped_type const&
+static_assoc_map_base<T, N>::at(key_type const& key) const {
+    auto it = this->find(key);
+    if (it == this->cend()) {
+        throw std::out_of_range("key not found");
     }
 
     return it->second;
 }
 
-template <typename K, typename T, typename C, std::size_t N>
-inline typename static_assoc<map_traits<K, T, C>, deny_duplicates, N>::mapped_type&
-static_assoc<map_traits<K, T, C>, deny_duplicates, N>::at(key_type const& key) {
+template <typename T, std::size_t N>
+template <typename Key, typename KeyCompare, typename>
+inline typename static_assoc_map_base<T, N>::mapped_type&
+static_assoc_map_base<T, N>::at(Key const& key) {
     return const_cast<mapped_type&>(
-        static_cast<static_assoc const*>(this)->at(key));
+        static_cast<static_assoc_map_base const*>(this)->at(key));
 }
 
-template <typename K, typename T, typename C, std::size_t N>
-typename static_assoc<map_traits<K, T, C>, deny_duplicates, N>::mapped_type const&
-static_assoc<map_traits<K, T, C>, deny_duplicates, N>::at(key_type const& key) const {
+template <typename T, std::size_t N>
+template <typename Key, typename KeyCompare, typename>
+typename static_assoc_map_base<T, N>::mapped_type const&
+static_assoc_map_base<T, N>::at(Key const& key) const {
     auto it = this->find(key);
     if (it == this->cend()) {
         throw std::out_of_range("key not found");
@@ -674,6 +906,69 @@ static_assoc<map_traits<K, T, C>, deny_duplicates, N>::at(key_type const& key) c
     return it->second;
 }
 
+template <typename T, std::size_t N>
+template <typename... Args>
+inline std::pair<typename static_assoc_map_base<T, N>::iterator, bool>
+static_assoc_map_base<T, N>::try_emplace(key_type const& key, Args&&... args) {
+    return emplace_key(key, std::forward<Args>(args)...);
+}
+
+template <typename T, std::size_t N>
+template <typename... Args>
+inline std::pair<typename static_assoc_map_base<T, N>::iterator, bool>
+static_assoc_map_base<T, N>::try_emplace(key_type&& key, Args&&... args) {
+    return emplace_key(std::move(key), std::forward<Args>(args)...);
+}
+
+template <typename T, std::size_t N>
+template <typename Key, typename... Args, typename KeyCompare, typename, typename>
+inline std::pair<typename static_assoc_map_base<T, N>::iterator, bool>
+static_assoc_map_base<T, N>::try_emplace(Key&& key, Args&&... args) {
+    return emplace_key(std::forward<Key>(key), std::forward<Args>(args)...);
+}
+
+// `obj` is only moved from by `emplace_key` if `key` is missing, so it can still be assigned.
+template <typename T, std::size_t N>
+template <typename Obj>
+std::pair<typename static_assoc_map_base<T, N>::iterator, bool>
+static_assoc_map_base<T, N>::insert_or_assign(key_type const& key, Obj&& obj) {
+    auto result = emplace_key(key, std::forward<Obj>(obj));
+    if (!result.second) {
+        result.first->second = std::forward<Obj>(obj);
+    }
+
+    return result;
+}
+
+template <typename T, std::size_t N>
+template <typename Obj>
+std::pair<typename static_assoc_map_base<T, N>::iterator, bool>
+static_assoc_map_base<T, N>::insert_or_assign(key_type&& key, Obj&& obj) {
+    auto result = emplace_key(std::move(key), std::forward<Obj>(obj));
+    if (!result.second) {
+        result.first->second = std::forward<Obj>(obj);
+    }
+
+    return result;
+}
+
+// Searches with `key` as is, and only builds a value (and converts `key` to `key_type`) if it has
+// to be inserted, directly at the position found.
+template <typename T, std::size_t N>
+template <typename Key, typename... Args>
+std::pair<typename static_assoc_map_base<T, N>::iterator, bool>
+static_assoc_map_base<T, N>::emplace_key(Key&& key, Args&&... args) {
+    auto it = this->lower_bound(key);
+    if (it != this->end() && !this->core_comp()(key, *it)) {
+        return {it, false};
+    }
+
+    return {this->values().emplace(it, std::piecewise_construct,
+                                   std::forward_as_tuple(std::forward<Key>(key)),
+                                   std::forward_as_tuple(std::forward<Args>(args)...)),
+            true};
+}
+
 }  // namespace internal
 
 }  // namespace bptree
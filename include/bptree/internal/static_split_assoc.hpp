@@ -0,0 +1,40 @@
+/************************************************
+ *  static_split_assoc.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_STATIC_SPLIT_ASSOC_HPP_
+#define BPTREE_INTERNAL_STATIC_SPLIT_ASSOC_HPP_
+
+#include <cstddef>
+
+#include "./deny_duplicates.hpp"
+#include "./split_map_traits.hpp"
+#include "./static_assoc.hpp"
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: class static_assoc<split_map_traits<K, T, C>, deny_duplicates, N>
+ ************************************************/
+
+// Map over the split key/value layout, with the same interface as over `map_traits`.
+// `split_map_traits.hpp` includes this header, so that every container of `split_map_traits` sees
+// this specialization.
+template <typename Key, typename T, typename Compare, std::size_t N>
+class static_assoc<split_map_traits<Key, T, Compare>, deny_duplicates, N>
+  : public static_assoc_map_base<split_map_traits<Key, T, Compare>, N> {
+ public:  // Public Method(s)
+    using static_assoc_map_base<split_map_traits<Key, T, Compare>, N>::static_assoc_map_base;
+};
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_STATIC_SPLIT_ASSOC_HPP_
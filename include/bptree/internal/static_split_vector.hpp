@@ -0,0 +1,491 @@
+/************************************************
+ *  static_split_vector.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_STATIC_SPLIT_VECTOR_HPP_
+#define BPTREE_INTERNAL_STATIC_SPLIT_VECTOR_HPP_
+
+#include <cassert>
+#include <cstddef>
+
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "./static_vector.hpp"
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: class static_split_vector_iterator<K, T>
+ ************************************************/
+
+// Random access iterator over a `static_split_vector`. Dereferencing yields a proxy pair of
+// references into the key and mapped arrays rather than a reference to a stored pair.
+template <typename Key, typename T>
+class static_split_vector_iterator {
+ public:  // Public Type(s)
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::pair<Key const, std::remove_const_t<T>>;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::pair<Key const&, T&>;
+
+    class pointer {
+     public:  // Public Method(s)
+        explicit pointer(reference ref)
+          : ref_(ref)
+            { /* do nothing */ }
+
+        reference const* operator->() const noexcept
+            { return &ref_; }
+
+     private:  // Private Property(ies)
+        reference ref_;
+    };
+
+ public:  // Public Method(s)
+    static_split_vector_iterator()
+      : keys_(nullptr), mapped_(nullptr)
+        { /* do nothing */ }
+    static_split_vector_iterator(Key const* keys, T* mapped)
+      : keys_(keys), mapped_(mapped)
+        { /* do nothing */ }
+
+    reference operator*() const
+        { return reference(*keys_, *mapped_); }
+    pointer operator->() const
+        { return pointer(operator*()); }
+    reference operator[](difference_type n) const
+        { return reference(keys_[n], mapped_[n]); }
+
+    static_split_vector_iterator& operator++()
+        { ++keys_; ++mapped_; return *this; }
+    static_split_vector_iterator& operator--()
+        { --keys_; --mapped_; return *this; }
+    static_split_vector_iterator operator++(int)
+        { static_split_vector_iterator it(*this); ++*this; return it; }
+    static_split_vector_iterator operator--(int)
+        { static_split_vector_iterator it(*this); --*this; return it; }
+
+    static_split_vector_iterator& operator+=(difference_type n)
+        { keys_ += n; mapped_ += n; return *this; }
+    static_split_vector_iterator& operator-=(difference_type n)
+        { keys_ -= n; mapped_ -= n; return *this; }
+
+    difference_type operator-(static_split_vector_iterator const& other) const
+        { return keys_ - other.keys_; }
+    static_split_vector_iterator operator+(difference_type n) const
+        { return static_split_vector_iterator(keys_ + n, mapped_ + n); }
+    static_split_vector_iterator operator-(difference_type n) const
+        { return static_split_vector_iterator(keys_ - n, mapped_ - n); }
+    friend static_split_vector_iterator operator+(difference_type n,
+                                                  static_split_vector_iterator const& other)
+        { return other + n; }
+
+    bool operator==(static_split_vector_iterator const& other) const noexcept
+        { return keys_ == other.keys_; }
+    bool operator!=(static_split_vector_iterator const& other) const noexcept
+        { return keys_ != other.keys_; }
+    bool operator> (static_split_vector_iterator const& other) const noexcept
+        { return keys_ >  other.keys_; }
+    bool operator< (static_split_vector_iterator const& other) const noexcept
+        { return keys_ <  other.keys_; }
+    bool operator>=(static_split_vector_iterator const& other) const noexcept
+        { return keys_ >= other.keys_; }
+    bool operator<=(static_split_vector_iterator const& other) const noexcept
+        { return keys_ <= other.keys_; }
+
+    template <typename AnotherT>
+    operator static_split_vector_iterator<Key, AnotherT>() const noexcept
+        { return static_split_vector_iterator<Key, AnotherT>(keys_, mapped_); }
+
+    Key const* keys() const noexcept
+        { return keys_; }
+
+ private:  // Private Property(ies)
+    Key const* keys_;
+    T* mapped_;
+};
+
+/************************************************
+ * Declaration: class static_split_vector<K, T, N>
+ ************************************************/
+
+// Fixed-capacity sequence of key/mapped pairs stored as two parallel arrays, so that scanning
+// the keys does not pull the mapped values into the cache.
+template <typename Key, typename T, std::size_t N>
+class static_split_vector {
+ private:  // Private Type(s)
+    using key_vector = static_vector<Key, N>;
+    using mapped_vector = static_vector<T, N>;
+
+ public:  // Public Type(s)
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<key_type const, mapped_type>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using iterator = static_split_vector_iterator<key_type, mapped_type>;
+    using const_iterator = static_split_vector_iterator<key_type, mapped_type const>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    using reference = typename iterator::reference;
+    using const_reference = typename const_iterator::reference;
+    using pointer = typename iterator::pointer;
+    using const_pointer = typename const_iterator::pointer;
+
+ public:  // Public Method(s)
+    static_split_vector() = default;
+    static_split_vector(static_split_vector const&) = default;
+    static_split_vector(static_split_vector&&) = default;
+
+    static_split_vector& operator=(static_split_vector const&) = default;
+    static_split_vector& operator=(static_split_vector&&) = default;
+    void swap(static_split_vector& other);
+
+    iterator insert(const_iterator pos, value_type const& value);
+    iterator insert(const_iterator pos, value_type&& value);
+    template <typename OffsetIt, typename BidirIt>
+    void insert_at(OffsetIt offsets, BidirIt first, BidirIt last);
+    template <typename... KeyArgs, typename... MappedArgs>
+    iterator emplace(const_iterator pos, std::piecewise_construct_t,
+                     std::tuple<KeyArgs...> key_args, std::tuple<MappedArgs...> mapped_args);
+    iterator erase(const_iterator pos);
+    iterator erase(const_iterator first, const_iterator last);
+    void clear() noexcept;
+
+    reference operator[](size_type pos);
+    const_reference operator[](size_type pos) const;
+    key_type const* keys() const noexcept;
+
+    bool empty() const noexcept;
+    bool full() const noexcept;
+    size_type size() const noexcept;
+
+    iterator begin() noexcept;
+    const_iterator begin() const noexcept;
+    const_iterator cbegin() const noexcept;
+    iterator end() noexcept;
+    const_iterator end() const noexcept;
+    const_iterator cend() const noexcept;
+    reverse_iterator rbegin() noexcept;
+    const_reverse_iterator rbegin() const noexcept;
+    const_reverse_iterator crbegin() const noexcept;
+    reverse_iterator rend() noexcept;
+    const_reverse_iterator rend() const noexcept;
+    const_reverse_iterator crend() const noexcept;
+
+ public:  // Static Public Method(s)
+    static constexpr size_type max_size() noexcept;
+    static constexpr size_type capacity() noexcept;
+
+ private:  // Private Method(s)
+    template <typename V>
+    iterator insert_value(const_iterator pos, V&& value);
+    template <typename KeyTuple, typename MappedTuple, std::size_t... I, std::size_t... J>
+    iterator emplace_piecewise(const_iterator pos, KeyTuple&& key_args, MappedTuple&& mapped_args,
+                               std::index_sequence<I...>, std::index_sequence<J...>);
+
+ private:  // Private Property(ies)
+    key_vector keys_;
+    mapped_vector mapped_;
+};
+
+/************************************************
+ * Implementation: class static_split_vector<K, T, N>
+ ************************************************/
+
+template <typename K, typename T, std::size_t N>
+inline void static_split_vector<K, T, N>::swap(static_split_vector& other) {
+    keys_.swap(other.keys_);
+    mapped_.swap(other.mapped_);
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::iterator
+static_split_vector<K, T, N>::insert(const_iterator pos, value_type const& value) {
+    return insert_value(pos, value);
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::iterator
+static_split_vector<K, T, N>::insert(const_iterator pos, value_type&& value) {
+    return insert_value(pos, std::move(value));
+}
+
+template <typename K, typename T, std::size_t N>
+template <typename OffsetIt, typename BidirIt>
+void static_split_vector<K, T, N>::insert_at(OffsetIt offsets, BidirIt first, BidirIt last) {
+    static_vector<key_type, N> keys;
+    static_vector<mapped_type, N> mapped;
+    for (; first != last; ++first) {
+        auto&& value = *first;
+        keys.push_back(value.first);
+        mapped.push_back(std::forward<decltype(value)>(value).second);
+    }
+
+    keys_.insert_at(offsets, keys.begin(), keys.end());
+    mapped_.insert_at(offsets, std::make_move_iterator(mapped.begin()),
+                      std::make_move_iterator(mapped.end()));
+}
+
+// Constructs the key from `key_args` and the mapped value from `mapped_args`, each in its array.
+template <typename K, typename T, std::size_t N>
+template <typename... KeyArgs, typename... MappedArgs>
+inline typename static_split_vector<K, T, N>::iterator
+static_split_vector<K, T, N>::emplace(const_iterator pos, std::piecewise_construct_t,
+                                      std::tuple<KeyArgs...> key_args,
+                                      std::tuple<MappedArgs...> mapped_args) {
+    return emplace_piecewise(pos, std::move(key_args), std::move(mapped_args),
+                             std::index_sequence_for<KeyArgs...>(),
+                             std::index_sequence_for<MappedArgs...>());
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::iterator
+static_split_vector<K, T, N>::erase(const_iterator pos) {
+    return erase(pos, pos + 1);
+}
+
+template <typename K, typename T, std::size_t N>
+typename static_split_vector<K, T, N>::iterator
+static_split_vector<K, T, N>::erase(const_iterator first, const_iterator last) {
+    auto offset = first - cbegin();
+    auto count = last - first;
+    keys_.erase(keys_.cbegin() + offset, keys_.cbegin() + offset + count);
+    mapped_.erase(mapped_.cbegin() + offset, mapped_.cbegin() + offset + count);
+    return begin() + offset;
+}
+
+template <typename K, typename T, std::size_t N>
+inline void static_split_vector<K, T, N>::clear() noexcept {
+    keys_.clear();
+    mapped_.clear();
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::reference
+static_split_vector<K, T, N>::operator[](size_type pos) {
+    return reference(keys_[pos], mapped_[pos]);
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::const_reference
+static_split_vector<K, T, N>::operator[](size_type pos) const {
+    return const_reference(keys_[pos], mapped_[pos]);
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::key_type const*
+static_split_vector<K, T, N>::keys() const noexcept {
+    return keys_.data();
+}
+
+template <typename K, typename T, std::size_t N>
+inline bool static_split_vector<K, T, N>::empty() const noexcept {
+    return keys_.empty();
+}
+
+template <typename K, typename T, std::size_t N>
+inline bool static_split_vector<K, T, N>::full() const noexcept {
+    return keys_.full();
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::size_type
+static_split_vector<K, T, N>::size() const noexcept {
+    return keys_.size();
+}
+
+template <typename K, typename T, std::size_t N>
+inline constexpr typename static_split_vector<K, T, N>::size_type
+static_split_vector<K, T, N>::max_size() noexcept {
+    return N;
+}
+
+template <typename K, typename T, std::size_t N>
+inline constexpr typename static_split_vector<K, T, N>::size_type
+static_split_vector<K, T, N>::capacity() noexcept {
+    return max_size();
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::iterator
+static_split_vector<K, T, N>::begin() noexcept {
+    return iterator(keys_.data(), mapped_.data());
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::const_iterator
+static_split_vector<K, T, N>::begin() const noexcept {
+    return cbegin();
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::const_iterator
+static_split_vector<K, T, N>::cbegin() const noexcept {
+    return const_iterator(keys_.data(), mapped_.data());
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::iterator
+static_split_vector<K, T, N>::end() noexcept {
+    return begin() + size();
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::const_iterator
+static_split_vector<K, T, N>::end() const noexcept {
+    return cend();
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::const_iterator
+static_split_vector<K, T, N>::cend() const noexcept {
+    return cbegin() + size();
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::reverse_iterator
+static_split_vector<K, T, N>::rbegin() noexcept {
+    return reverse_iterator(end());
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::const_reverse_iterator
+static_split_vector<K, T, N>::rbegin() const noexcept {
+    return crbegin();
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::const_reverse_iterator
+static_split_vector<K, T, N>::crbegin() const noexcept {
+    return const_reverse_iterator(end());
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::reverse_iterator
+static_split_vector<K, T, N>::rend() noexcept {
+    return reverse_iterator(begin());
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::const_reverse_iterator
+static_split_vector<K, T, N>::rend() const noexcept {
+    return crend();
+}
+
+template <typename K, typename T, std::size_t N>
+inline typename static_split_vector<K, T, N>::const_reverse_iterator
+static_split_vector<K, T, N>::crend() const noexcept {
+    return const_reverse_iterator(begin());
+}
+
+template <typename K, typename T, std::size_t N>
+template <typename V>
+typename static_split_vector<K, T, N>::iterator
+static_split_vector<K, T, N>::insert_value(const_iterator pos, V&& value) {
+    assert(!full());
+
+    auto offset = pos - cbegin();
+    keys_.insert(keys_.cbegin() + offset, value.first);
+    try {
+        mapped_.insert(mapped_.cbegin() + offset, std::forward<V>(value).second);
+    } catch (...) {
+        keys_.erase(keys_.cbegin() + offset);
+        throw;
+    }
+
+    return begin() + offset;
+}
+
+template <typename K, typename T, std::size_t N>
+template <typename KeyTuple, typename MappedTuple, std::size_t... I, std::size_t... J>
+typename static_split_vector<K, T, N>::iterator
+static_split_vector<K, T, N>::emplace_piecewise(const_iterator pos, KeyTuple&& key_args,
+                                                MappedTuple&& mapped_args,
+                                                std::index_sequence<I...>,
+                                                std::index_sequence<J...>) {
+    assert(!full());
+
+    auto offset = pos - cbegin();
+    keys_.emplace(keys_.cbegin() + offset, std::get<I>(std::move(key_args))...);
+    try {
+        mapped_.emplace(mapped_.cbegin() + offset, std::get<J>(std::move(mapped_args))...);
+    } catch (...) {
+        keys_.erase(keys_.cbegin() + offset);
+        throw;
+    }
+
+    return begin() + offset;
+}
+
+/************************************************
+ * Implementation: comparison operators of static_split_vector<K, T, N>
+ ************************************************/
+
+template <typename K, typename T, std::size_t N>
+inline bool operator==(static_split_vector<K, T, N> const& x,
+                       static_split_vector<K, T, N> const& y) {
+    return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin());
+}
+
+template <typename K, typename T, std::size_t N>
+inline bool operator!=(static_split_vector<K, T, N> const& x,
+                       static_split_vector<K, T, N> const& y) {
+    return !(x == y);
+}
+
+template <typename K, typename T, std::size_t N>
+inline bool operator>(static_split_vector<K, T, N> const& x,
+                      static_split_vector<K, T, N> const& y) {
+    return y < x;
+}
+
+template <typename K, typename T, std::size_t N>
+inline bool operator<(static_split_vector<K, T, N> const& x,
+                      static_split_vector<K, T, N> const& y) {
+    return std::lexicographical_compare(x.begin(), x.end(), y.begin(), y.end());
+}
+
+template <typename K, typename T, std::size_t N>
+inline bool operator>=(static_split_vector<K, T, N> const& x,
+                       static_split_vector<K, T, N> const& y) {
+    return !(x < y);
+}
+
+template <typename K, typename T, std::size_t N>
+inline bool operator<=(static_split_vector<K, T, N> const& x,
+                       static_split_vector<K, T, N> const& y) {
+    return !(x > y);
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+/************************************************
+ * Implementation: std::swap(static_split_vector<K, T, N>&, static_split_vector<K, T, N>&)
+ ************************************************/
+
+namespace std {
+
+template <typename K, typename T, std::size_t N>
+void swap(bptree::internal::static_split_vector<K, T, N>& v1,
+          bptree::internal::static_split_vector<K, T, N>& v2) {
+    v1.swap(v2);
+}
+
+}  // namespace std
+
+#endif  // BPTREE_INTERNAL_STATIC_SPLIT_VECTOR_HPP_
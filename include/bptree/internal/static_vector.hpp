@@ -11,6 +11,7 @@
 
 #include <cassert>
 #include <cstddef>
+#include <cstring>
 
 #include <algorithm>
 #include <initializer_list>
@@ -20,6 +21,8 @@
 #include <type_traits>
 #include <utility>
 
+#include "./relocatable.hpp"
+
 namespace bptree {
 
 namespace internal {
@@ -160,6 +163,8 @@ class static_vector {
     >
     insert(const_iterator pos, ForwardIt first, ForwardIt last);
     iterator insert(const_iterator pos, std::initializer_list<value_type> il);
+    template <typename OffsetIt, typename BidirIt>
+    void insert_at(OffsetIt offsets, BidirIt first, BidirIt last);
     void push_back(value_type const& value);
     void push_back(value_type&& value);
     template <typename... Args>
@@ -203,10 +208,21 @@ class static_vector {
     static constexpr size_type max_size() noexcept;
     static constexpr size_type capacity() noexcept;
 
+ private:  // Private Type(s)
+    using relocatable = is_trivially_relocatable<value_type>;
+
  private:  // Private Method(s)
     template <typename... Args>
     iterator emplace_with_count(const_iterator pos, size_type count, Args&&... args);
     void reserve(const_iterator pos, size_type count);
+    void move_from(static_vector& other, std::true_type) noexcept;
+    void move_from(static_vector& other, std::false_type);
+    void swap_prefix(pointer first, pointer last, pointer d_first, std::true_type) noexcept;
+    void swap_prefix(pointer first, pointer last, pointer d_first, std::false_type);
+
+ private:  // Static Private Method(s)
+    static void relocate(pointer first, pointer last, pointer d_first, std::true_type) noexcept;
+    static void relocate(pointer first, pointer last, pointer d_first, std::false_type);
 
  private:  // Private Property(ies)
     size_type size_;
@@ -274,9 +290,8 @@ inline static_vector<T, N>::static_vector(static_vector const& other)
 
 template <typename T, std::size_t N>
 inline static_vector<T, N>::static_vector(static_vector&& other)
-  : static_vector(std::make_move_iterator(other.data()),
-                  std::make_move_iterator(other.data() + other.size())) {
-    other.clear();
+  : static_vector() {
+    move_from(other, relocatable());
 }
 
 template <typename T, std::size_t N>
@@ -301,9 +316,11 @@ inline static_vector<T, N>& static_vector<T, N>::operator=(static_vector const&
 
 template <typename T, std::size_t N>
 inline static_vector<T, N>& static_vector<T, N>::operator=(static_vector&& other) {
-    assign(std::make_move_iterator(other.data()),
-           std::make_move_iterator(other.data() + other.size()));
-    other.clear();
+    if (this != &other) {
+        clear();
+        move_from(other, relocatable());
+    }
+
     return *this;
 }
 
@@ -349,11 +366,8 @@ void static_vector<T, N>::swap(static_vector& other) {
         long_last = long_first + size();
     }
 
-    std::swap_ranges(short_first, short_last, long_first);
-    for (; long_mid != long_last; ++long_mid, ++short_last) {
-        ::new(short_last) value_type(std::move(*long_mid));
-        long_mid->~value_type();
-    }
+    swap_prefix(short_first, short_last, long_first, relocatable());
+    relocate(long_mid, long_last, short_last, relocatable());
 
     std::swap(size_, other.size_);
 }
@@ -426,6 +440,29 @@ static_vector<T, N>::insert(const_iterator pos, std::initializer_list<value_type
     return insert(pos, il.begin(), il.end());
 }
 
+template <typename T, std::size_t N>
+template <typename OffsetIt, typename BidirIt>
+void static_vector<T, N>::insert_at(OffsetIt offsets, BidirIt first, BidirIt last) {
+    auto count = static_cast<size_type>(std::distance(first, last));
+    assert(size() + count <= max_size());
+
+    // offsets are non-decreasing positions in the current sequence, so filling the vector from
+    // its back moves every stored value at most once
+    auto offset = std::next(offsets, count);
+    auto src = data() + size();
+    auto dest = src + count;
+    while (last != first) {
+        auto ptr = data() + *--offset;
+        dest -= src - ptr;
+        relocate(ptr, src, dest, relocatable());
+        src = ptr;
+
+        ::new(--dest) value_type(*--last);
+    }
+
+    size_ += count;
+}
+
 template <typename T, std::size_t N>
 inline void static_vector<T, N>::push_back(value_type const& value) {
     emplace_back(value);
@@ -471,18 +508,11 @@ static_vector<T, N>::erase(const_iterator first, const_iterator last) {
 
     auto d_ptr = data() + offset;
     auto s_ptr = d_ptr + count;
-    auto last_ptr = data() + size();
-    while (s_ptr != last_ptr) {
-        d_ptr->~value_type();
-        ::new(d_ptr) value_type(std::move(*s_ptr++));
-        ++d_ptr;
-    }
-
-    while (d_ptr != last_ptr) {
-        d_ptr->~value_type();
-        ++d_ptr;
+    for (auto ptr = d_ptr; ptr != s_ptr; ++ptr) {
+        ptr->~value_type();
     }
 
+    relocate(s_ptr, data() + size(), d_ptr, relocatable());
     size_ -= count;
 
     return iterator(data() + offset);
@@ -693,13 +723,64 @@ void static_vector<T, N>::reserve(const_iterator pos, size_type count) {
     assert(pos <= cend());
     assert(size() + count <= max_size());
 
-    auto offset = pos - cbegin();
-    auto ptr = data() + offset;
-    auto last = data() + size();
-    auto d_last = last + count;
-    while (ptr != last) {
-        ::new(--d_last) value_type(std::move(*(--last)));
-        last->~value_type();
+    auto ptr = data() + (pos - cbegin());
+    relocate(ptr, data() + size(), ptr + count, relocatable());
+}
+
+template <typename T, std::size_t N>
+inline void static_vector<T, N>::move_from(static_vector& other, std::true_type) noexcept {
+    std::memcpy(static_cast<void*>(data()), static_cast<void const*>(other.data()),
+                other.size() * sizeof(value_type));
+    size_ = other.size_;
+    other.size_ = 0;
+}
+
+template <typename T, std::size_t N>
+inline void static_vector<T, N>::move_from(static_vector& other, std::false_type) {
+    assign(std::make_move_iterator(other.data()),
+           std::make_move_iterator(other.data() + other.size()));
+    other.clear();
+}
+
+template <typename T, std::size_t N>
+inline void static_vector<T, N>::swap_prefix(
+        pointer first, pointer last, pointer d_first, std::true_type) noexcept {
+    std::aligned_storage_t<sizeof(T), alignof(T)> buffer[N];
+    auto bytes = (last - first) * sizeof(value_type);
+    std::memcpy(static_cast<void*>(buffer), static_cast<void const*>(first), bytes);
+    std::memcpy(static_cast<void*>(first), static_cast<void const*>(d_first), bytes);
+    std::memcpy(static_cast<void*>(d_first), static_cast<void const*>(buffer), bytes);
+}
+
+template <typename T, std::size_t N>
+inline void static_vector<T, N>::swap_prefix(
+        pointer first, pointer last, pointer d_first, std::false_type) {
+    std::swap_ranges(first, last, d_first);
+}
+
+// Moves [first, last) into uninitialized storage at `d_first`, which may overlap the source, and
+// destroys the source values.
+template <typename T, std::size_t N>
+inline void static_vector<T, N>::relocate(
+        pointer first, pointer last, pointer d_first, std::true_type) noexcept {
+    std::memmove(static_cast<void*>(d_first), static_cast<void const*>(first),
+                 (last - first) * sizeof(value_type));
+}
+
+template <typename T, std::size_t N>
+void static_vector<T, N>::relocate(
+        pointer first, pointer last, pointer d_first, std::false_type) {
+    if (d_first <= first) {
+        for (; first != last; ++first, ++d_first) {
+            ::new(d_first) value_type(std::move(*first));
+            first->~value_type();
+        }
+    } else {
+        auto d_last = d_first + (last - first);
+        while (first != last) {
+            ::new(--d_last) value_type(std::move(*--last));
+            last->~value_type();
+        }
     }
 }
 
@@ -0,0 +1,468 @@
+/************************************************
+ *  string_node.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_STRING_NODE_HPP_
+#define BPTREE_INTERNAL_STRING_NODE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <utility>
+
+#include "./search.hpp"
+#include "./set_traits.hpp"
+#include "./static_vector.hpp"
+#include "./tree_node.hpp"
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: class string_inner_node<C, N, R>
+ ************************************************/
+
+// Inner node for `std::string` keys in byte order. Rather than one `std::string` per entry, the
+// node keeps the prefix shared by all of its keys once, followed by the rest of each key, in a
+// single byte arena. Each entry also carries a head, the first 8 bytes of the rest of its key
+// packed into an integer, so that a search compares integers and only reads the arena to tell
+// apart keys whose heads tie.
+//
+// Keys are handed out by value, since they have to be put together from the arena.
+template <typename Compare, std::size_t N, bool Counted>
+class string_inner_node
+  : public tree_node<string_inner_node<Compare, N, Counted>> {
+ private:  // Private Type(s)
+    struct head_traits : set_traits<std::int64_t> {
+        using set_traits<std::int64_t>::core_compare;
+    };
+
+    using head_compare = typename head_traits::core_compare;
+    using search_kernel_type = search_kernel<head_traits, N>;
+
+    using child_type = child_ref<tree_node<string_inner_node>, Counted>;
+
+    struct slot {
+        std::uint32_t offset;   // position of the rest of the key in the arena
+        std::uint32_t length;   // length of the rest of the key
+        child_type child;
+    };
+
+ public:  // Public Type(s)
+    using node_type = tree_node<string_inner_node>;
+    using key_type = std::string;
+    using key_compare = Compare;
+    using size_type = std::size_t;
+
+ public:  // Public Method(s)
+    explicit string_inner_node(key_compare const& comp);
+
+    node_type* child(size_type pos) const;
+    size_type count(size_type pos) const;
+    void count(size_type pos, size_type count);
+    key_type key(size_type pos) const;
+    key_type first_key() const;
+    size_type index_of(node_type const* child) const;
+    template <typename K>
+    size_type lower_child(K const& key) const;
+    template <typename K>
+    size_type upper_child(K const& key) const;
+
+    void insert_child(size_type pos, key_type const& key, node_type* child);
+    void erase_child(size_type pos);
+    void replace_key(size_type pos, key_type const& key);
+
+    void split_into(string_inner_node& right);
+    void merge_from(string_inner_node& right, key_type const& sep);
+    void borrow_from_left(string_inner_node& left, key_type const& sep);
+    void borrow_from_right(string_inner_node& right, key_type const& sep);
+    void clear() noexcept;
+
+    bool empty() const noexcept;
+    bool full() const noexcept;
+    size_type size() const noexcept;
+    size_type prefix_size() const noexcept;
+
+ public:  // Static Public Method(s)
+    static constexpr size_type capacity() noexcept;
+    static constexpr size_type min_size() noexcept;
+
+ private:  // Private Method(s)
+    template <bool Upper>
+    size_type search(char const* data, size_type length) const;
+    int compare(slot const& entry, char const* data, size_type length) const;
+    void insert_entry(size_type pos, key_type const& key, child_type child);
+    size_type common_prefix_size() const;
+    void rebuild(size_type prefix_size);
+
+ private:  // Static Private Method(s)
+    static std::int64_t make_head(char const* data, size_type length) noexcept;
+    static size_type mismatch(char const* lhs, char const* rhs, size_type length) noexcept;
+    static std::pair<char const*, size_type> view(char const* key) noexcept;
+    template <typename K>
+    static auto view(K const& key) noexcept
+        -> decltype(std::pair<char const*, size_type>(key.data(), key.size()));
+
+ private:  // Private Property(ies)
+    static_vector<std::int64_t, N> heads_;
+    static_vector<slot, N> slots_;
+    std::string arena_;      // the shared prefix, then the rest of each key
+    size_type prefix_size_;
+    size_type garbage_;      // bytes of the arena left behind by erased keys
+};
+
+/************************************************
+ * Declaration: struct select_inner_node<std::string, C, N, R>
+ ************************************************/
+
+template <std::size_t N, bool Counted>
+struct select_inner_node<std::string, std::less<std::string>, N, Counted> {
+    using type = string_inner_node<std::less<std::string>, N, Counted>;
+};
+
+template <std::size_t N, bool Counted>
+struct select_inner_node<std::string, std::less<void>, N, Counted> {
+    using type = string_inner_node<std::less<void>, N, Counted>;
+};
+
+/************************************************
+ * Implementation: class string_inner_node<C, N, R>
+ ************************************************/
+
+template <typename C, std::size_t N, bool R>
+inline string_inner_node<C, N, R>::string_inner_node(key_compare const&)
+  : node_type(), prefix_size_(0), garbage_(0) {
+    // do nothing
+}
+
+template <typename C, std::size_t N, bool R>
+inline typename string_inner_node<C, N, R>::node_type*
+string_inner_node<C, N, R>::child(size_type pos) const {
+    return slots_[pos].child.node;
+}
+
+template <typename C, std::size_t N, bool R>
+inline typename string_inner_node<C, N, R>::size_type
+string_inner_node<C, N, R>::count(size_type pos) const {
+    return slots_[pos].child.count();
+}
+
+template <typename C, std::size_t N, bool R>
+inline void string_inner_node<C, N, R>::count(size_type pos, size_type count) {
+    slots_[pos].child.count(count);
+}
+
+template <typename C, std::size_t N, bool R>
+typename string_inner_node<C, N, R>::key_type
+string_inner_node<C, N, R>::key(size_type pos) const {
+    key_type key(arena_, 0, prefix_size_);
+    key.append(arena_, slots_[pos].offset, slots_[pos].length);
+    return key;
+}
+
+template <typename C, std::size_t N, bool R>
+inline typename string_inner_node<C, N, R>::key_type
+string_inner_node<C, N, R>::first_key() const {
+    return key(0);
+}
+
+template <typename C, std::size_t N, bool R>
+inline typename string_inner_node<C, N, R>::size_type
+string_inner_node<C, N, R>::index_of(node_type const* child) const {
+    auto first = slots_.cbegin();
+    auto it = std::find_if(first, slots_.cend(), [child](auto const& entry) {
+        return entry.child.node == child;
+    });
+
+    return it - first;
+}
+
+template <typename C, std::size_t N, bool R>
+template <typename K>
+inline typename string_inner_node<C, N, R>::size_type
+string_inner_node<C, N, R>::lower_child(K const& key) const {
+    auto bytes = view(key);
+    return search<false>(bytes.first, bytes.second);
+}
+
+template <typename C, std::size_t N, bool R>
+template <typename K>
+inline typename string_inner_node<C, N, R>::size_type
+string_inner_node<C, N, R>::upper_child(K const& key) const {
+    auto bytes = view(key);
+    return search<true>(bytes.first, bytes.second);
+}
+
+template <typename C, std::size_t N, bool R>
+inline void string_inner_node<C, N, R>::insert_child(size_type pos, key_type const& key,
+                                                     node_type* child) {
+    insert_entry(pos, key, child);
+}
+
+template <typename C, std::size_t N, bool R>
+void string_inner_node<C, N, R>::erase_child(size_type pos) {
+    garbage_ += slots_[pos].length;
+    heads_.erase(heads_.cbegin() + pos);
+    slots_.erase(slots_.cbegin() + pos);
+
+    if (slots_.empty()) {
+        clear();
+    } else if (garbage_ > arena_.size() / 2) {
+        rebuild(prefix_size_);
+    }
+}
+
+template <typename C, std::size_t N, bool R>
+inline void string_inner_node<C, N, R>::replace_key(size_type pos, key_type const& key) {
+    auto entry = slots_[pos].child;
+    erase_child(pos);
+    insert_entry(pos, key, entry);
+}
+
+// Both halves may share a longer prefix than the whole node did, so the arena of this node is
+// rebuilt around its own, while the right node finds its prefix as its keys come in.
+template <typename C, std::size_t N, bool R>
+void string_inner_node<C, N, R>::split_into(string_inner_node& right) {
+    auto mid = (size() + 1) / 2;
+    for (auto pos = mid; pos < size(); ++pos) {
+        right.insert_entry(right.size(), key(pos), slots_[pos].child);
+        garbage_ += slots_[pos].length;
+    }
+
+    heads_.erase(heads_.cbegin() + mid, heads_.cend());
+    slots_.erase(slots_.cbegin() + mid, slots_.cend());
+    rebuild(common_prefix_size());
+}
+
+template <typename C, std::size_t N, bool R>
+void string_inner_node<C, N, R>::merge_from(string_inner_node& right, key_type const& sep) {
+    insert_entry(size(), sep, right.slots_[0].child);
+    for (size_type pos = 1; pos < right.size(); ++pos) {
+        insert_entry(size(), right.key(pos), right.slots_[pos].child);
+    }
+
+    right.clear();
+}
+
+template <typename C, std::size_t N, bool R>
+void string_inner_node<C, N, R>::borrow_from_left(string_inner_node& left, key_type const& sep) {
+    auto last = left.size() - 1;
+    replace_key(0, sep);
+    insert_entry(0, left.key(last), left.slots_[last].child);
+    left.erase_child(last);
+}
+
+template <typename C, std::size_t N, bool R>
+void string_inner_node<C, N, R>::borrow_from_right(string_inner_node& right, key_type const& sep) {
+    insert_entry(size(), sep, right.slots_[0].child);
+    right.erase_child(0);
+}
+
+template <typename C, std::size_t N, bool R>
+inline void string_inner_node<C, N, R>::clear() noexcept {
+    heads_.clear();
+    slots_.clear();
+    arena_.clear();
+    prefix_size_ = 0;
+    garbage_ = 0;
+}
+
+template <typename C, std::size_t N, bool R>
+inline bool string_inner_node<C, N, R>::empty() const noexcept {
+    return slots_.empty();
+}
+
+template <typename C, std::size_t N, bool R>
+inline bool string_inner_node<C, N, R>::full() const noexcept {
+    return slots_.size() == N;
+}
+
+template <typename C, std::size_t N, bool R>
+inline typename string_inner_node<C, N, R>::size_type
+string_inner_node<C, N, R>::size() const noexcept {
+    return slots_.size();
+}
+
+template <typename C, std::size_t N, bool R>
+inline typename string_inner_node<C, N, R>::size_type
+string_inner_node<C, N, R>::prefix_size() const noexcept {
+    return prefix_size_;
+}
+
+template <typename C, std::size_t N, bool R>
+inline constexpr typename string_inner_node<C, N, R>::size_type
+string_inner_node<C, N, R>::capacity() noexcept {
+    return N;
+}
+
+template <typename C, std::size_t N, bool R>
+inline constexpr typename string_inner_node<C, N, R>::size_type
+string_inner_node<C, N, R>::min_size() noexcept {
+    return N / 2;
+}
+
+// Counts the separators (every key but the first) that are less than the key in `data`, or not
+// greater than it if `Upper`. A key outside of the shared prefix precedes or follows them all.
+template <typename C, std::size_t N, bool R>
+template <bool Upper>
+typename string_inner_node<C, N, R>::size_type
+string_inner_node<C, N, R>::search(char const* data, size_type length) const {
+    auto prefix_order = std::memcmp(data, arena_.data(), std::min(length, prefix_size_));
+    if (prefix_order < 0 || (prefix_order == 0 && length < prefix_size_)) {
+        return 0;
+    } else if (prefix_order > 0) {
+        return size() - 1;
+    }
+
+    data += prefix_size_;
+    length -= prefix_size_;
+
+    auto head = make_head(data, length);
+    auto first = heads_.data() + 1;
+    auto last = heads_.data() + heads_.size();
+    head_compare comp{std::less<std::int64_t>()};
+    auto lo = search_kernel_type::lower_bound(first, last, head, comp);
+    auto hi = search_kernel_type::upper_bound(lo, last, head, comp);
+
+    while (lo < hi) {
+        auto mid = lo + (hi - lo) / 2;
+        auto order = compare(slots_[mid - heads_.data()], data, length);
+        if (Upper ? order <= 0 : order < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo - first;
+}
+
+// Compares the rest of the key of `entry` with the bytes in `data`, like `std::memcmp`.
+template <typename C, std::size_t N, bool R>
+inline int string_inner_node<C, N, R>::compare(slot const& entry, char const* data,
+                                               size_type length) const {
+    auto order = std::memcmp(arena_.data() + entry.offset, data,
+                             std::min<size_type>(entry.length, length));
+    if (order != 0) {
+        return order;
+    }
+
+    return entry.length < length ? -1 : entry.length > length;
+}
+
+// Shortens the shared prefix first if `key` does not start with all of it.
+template <typename C, std::size_t N, bool R>
+void string_inner_node<C, N, R>::insert_entry(size_type pos, key_type const& key,
+                                              child_type child) {
+    if (slots_.empty()) {
+        arena_.assign(key);
+        prefix_size_ = key.size();
+        garbage_ = 0;
+    } else {
+        auto common = mismatch(arena_.data(), key.data(), std::min(prefix_size_, key.size()));
+        if (common < prefix_size_) {
+            rebuild(common);
+        }
+    }
+
+    auto offset = arena_.size();
+    auto length = key.size() - prefix_size_;
+    arena_.append(key, prefix_size_, length);
+    heads_.insert(heads_.cbegin() + pos, make_head(arena_.data() + offset, length));
+    slots_.insert(slots_.cbegin() + pos, slot{static_cast<std::uint32_t>(offset),
+                                              static_cast<std::uint32_t>(length), child});
+    child.node->parent(this);
+}
+
+template <typename C, std::size_t N, bool R>
+typename string_inner_node<C, N, R>::size_type
+string_inner_node<C, N, R>::common_prefix_size() const {
+    auto const& front = slots_[0];
+    size_type common = front.length;
+    for (auto const& entry : slots_) {
+        common = mismatch(arena_.data() + front.offset, arena_.data() + entry.offset,
+                          std::min<size_type>(common, entry.length));
+    }
+
+    return prefix_size_ + common;
+}
+
+// Lays the arena out anew with the first `prefix_size` bytes of the keys as the shared prefix,
+// which all keys must have in common, and drops the garbage.
+template <typename C, std::size_t N, bool R>
+void string_inner_node<C, N, R>::rebuild(size_type prefix_size) {
+    auto kept = std::min(prefix_size, prefix_size_);
+    auto skip = prefix_size - kept;
+
+    std::string arena;
+    arena.reserve(arena_.size() - garbage_ + (prefix_size_ - kept) * slots_.size());
+    arena.append(arena_, 0, kept);
+    arena.append(arena_, slots_[0].offset, skip);
+    for (size_type pos = 0; pos < slots_.size(); ++pos) {
+        auto& entry = slots_[pos];
+        auto offset = arena.size();
+        arena.append(arena_, kept, prefix_size_ - kept);
+        arena.append(arena_, entry.offset + skip, entry.length - skip);
+
+        entry.offset = static_cast<std::uint32_t>(offset);
+        entry.length = static_cast<std::uint32_t>(arena.size() - offset);
+        heads_[pos] = make_head(arena.data() + offset, entry.length);
+    }
+
+    arena_.swap(arena);
+    prefix_size_ = prefix_size;
+    garbage_ = 0;
+}
+
+// Packs the first 8 bytes (padded with zeros) in big-endian order, with the sign bit flipped so
+// that signed integers compare like the bytes. Keys with different heads compare like their
+// heads, and only keys with equal heads need a closer look.
+template <typename C, std::size_t N, bool R>
+inline std::int64_t string_inner_node<C, N, R>::make_head(char const* data,
+                                                          size_type length) noexcept {
+    std::uint64_t head = 0;
+    for (size_type i = 0; i < sizeof(head); ++i) {
+        head = head << 8 | (i < length ? static_cast<unsigned char>(data[i]) : 0u);
+    }
+
+    return static_cast<std::int64_t>(head ^ (std::uint64_t(1) << 63));
+}
+
+template <typename C, std::size_t N, bool R>
+inline typename string_inner_node<C, N, R>::size_type
+string_inner_node<C, N, R>::mismatch(char const* lhs, char const* rhs, size_type length) noexcept {
+    size_type pos = 0;
+    while (pos < length && lhs[pos] == rhs[pos]) {
+        ++pos;
+    }
+
+    return pos;
+}
+
+template <typename C, std::size_t N, bool R>
+inline std::pair<char const*, typename string_inner_node<C, N, R>::size_type>
+string_inner_node<C, N, R>::view(char const* key) noexcept {
+    return {key, std::strlen(key)};
+}
+
+template <typename C, std::size_t N, bool R>
+template <typename K>
+inline auto string_inner_node<C, N, R>::view(K const& key) noexcept
+        -> decltype(std::pair<char const*, size_type>(key.data(), key.size())) {
+    return {key.data(), key.size()};
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_STRING_NODE_HPP_
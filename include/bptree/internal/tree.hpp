@@ -0,0 +1,2289 @@
+/************************************************
+ *  tree.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_TREE_HPP_
+#define BPTREE_INTERNAL_TREE_HPP_
+
+#include <cstddef>
+
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "./deny_duplicates.hpp"
+#include "./fanout.hpp"
+#include "./frozen_tree.hpp"
+#include "./leaf_range.hpp"
+#include "./map_traits.hpp"
+#include "./node_pool.hpp"
+#include "./parallel.hpp"
+#include "./prefetch.hpp"
+#include "./sorted_input.hpp"
+#include "./string_node.hpp"
+#include "./tree_iterator.hpp"
+#include "./tree_node.hpp"
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: class tree_base<T, I, M, N, A, R>
+ ************************************************/
+
+template <typename ValueTraits, template <typename, typename> class InsertionPolicy,
+          std::size_t LeafN, std::size_t InnerN, typename Allocator, bool Ranked>
+class tree_base
+  : public ValueTraits,
+    private ValueTraits::value_compare {
+    static_assert(LeafN >= 2, "leaf nodes must be able to hold at least 2 values");
+    static_assert(InnerN >= 4, "inner nodes must be able to hold at least 4 children");
+
+ protected:  // Protected Type(s)
+    using inner_node_type = typename select_inner_node<
+        typename ValueTraits::key_type, typename ValueTraits::key_compare, InnerN, Ranked
+    >::type;
+    using leaf_node_type = leaf_node<ValueTraits, InsertionPolicy, LeafN, inner_node_type>;
+    using node_type = tree_node<inner_node_type>;
+
+ private:  // Private Type(s)
+    using value_traits = ValueTraits;
+    using core_compare = typename value_traits::core_compare;
+
+    using leaf_allocator_type =
+        typename std::allocator_traits<Allocator>::template rebind_alloc<leaf_node_type>;
+    using inner_allocator_type =
+        typename std::allocator_traits<Allocator>::template rebind_alloc<inner_node_type>;
+
+    template <typename V, typename T>
+    using enable_if_value_constructible_t = typename std::enable_if<
+            std::is_constructible<typename value_traits::value_type, V&&>::value,
+            T
+        >::type;
+
+ public:  // Public Type(s)
+    using key_type = typename value_traits::key_type;
+    using value_type = typename value_traits::value_type;
+    using key_compare = typename value_traits::key_compare;
+    using value_compare = typename value_traits::value_compare;
+    using allocator_type = Allocator;
+
+    using reference = value_type&;
+    using const_reference = value_type const&;
+    using pointer = value_type*;
+    using const_pointer = value_type const*;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using iterator = tree_iterator<leaf_node_type, value_type>;
+    using const_iterator = tree_iterator<leaf_node_type const, value_type const>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using range_type = leaf_range<iterator>;
+    using const_range_type = leaf_range<const_iterator>;
+    using frozen_type = frozen_tree<ValueTraits, block_fanout<key_type>()>;
+
+ private:  // Private Type(s)
+    using insertion_policy = InsertionPolicy<leaf_node_type, value_compare>;
+    using insert_result_t = typename InsertionPolicy<tree_base, value_compare>::insert_result_t;
+
+    // keeps heterogeneous keys from capturing iterators meant for `erase(const_iterator)`
+    template <typename K>
+    using enable_if_key_t = typename std::enable_if<
+            !std::is_convertible<K const&, const_iterator>::value
+        >::type;
+
+ public:  // Public Method(s)
+    tree_base();
+    explicit tree_base(key_compare comp, allocator_type const& alloc = allocator_type());
+    explicit tree_base(allocator_type const& alloc);
+    template <typename InputIt>
+    tree_base(InputIt first, InputIt last, key_compare const& comp = key_compare(),
+              allocator_type const& alloc = allocator_type());
+    template <typename InputIt>
+    tree_base(sorted_input_t, InputIt first, InputIt last,
+              key_compare const& comp = key_compare(),
+              allocator_type const& alloc = allocator_type());
+    tree_base(std::initializer_list<value_type> il, key_compare const& comp = key_compare(),
+              allocator_type const& alloc = allocator_type());
+    tree_base(tree_base const& other);
+    tree_base(tree_base&& other) noexcept;
+    ~tree_base();
+
+    tree_base& operator=(std::initializer_list<value_type> il);
+    tree_base& operator=(tree_base const& other);
+    tree_base& operator=(tree_base&& other);
+    void swap(tree_base& other);
+
+    insert_result_t insert(value_type const& value);
+    template <typename V>
+    enable_if_value_constructible_t<V, insert_result_t> insert(V&& value);
+    iterator insert(const_iterator hint, value_type const& value);
+    template <typename V>
+    enable_if_value_constructible_t<V, iterator> insert(const_iterator hint, V&& value);
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last);
+    void insert(std::initializer_list<value_type> il);
+    template <typename InputIt>
+    void bulk_load(InputIt first, InputIt last, double fill_factor = 1.0);
+    template <typename RandomIt>
+    void bulk_load_parallel(RandomIt first, RandomIt last, size_type threads = 0,
+                            double fill_factor = 1.0);
+    template <typename... Args>
+    insert_result_t emplace(Args&&... args);
+    template <typename... Args>
+    iterator emplace_hint(const_iterator hint, Args&&... args);
+    iterator erase(const_iterator pos);
+    iterator erase(const_iterator first, const_iterator last);
+    size_type erase(key_type const& key);
+    template <typename K, typename Compare = key_compare,
+              typename = typename Compare::is_transparent,
+              typename = enable_if_key_t<K>>
+    size_type erase(K const& key);
+    void clear() noexcept;
+
+    bool empty() const noexcept;
+    size_type size() const noexcept;
+    size_type height() const noexcept;
+
+    size_type count(key_type const& key) const;
+    template <typename K, typename Compare = key_compare,
+              typename = typename Compare::is_transparent>
+    size_type count(K const& key) const;
+    iterator find(key_type const& key);
+    template <typename K, typename Compare = key_compare,
+              typename = typename Compare::is_transparent>
+    iterator find(K const& key);
+    const_iterator find(key_type const& key) const;
+    template <typename K, typename Compare = key_compare,
+              typename = typename Compare::is_transparent>
+    const_iterator find(K const& key) const;
+    std::pair<iterator, iterator> equal_range(key_type const& key);
+    template <typename K, typename Compare = key_compare,
+              typename = typename Compare::is_transparent>
+    std::pair<iterator, iterator> equal_range(K const& key);
+    std::pair<const_iterator, const_iterator> equal_range(key_type const& key) const;
+    template <typename K, typename Compare = key_compare,
+              typename = typename Compare::is_transparent>
+    std::pair<const_iterator, const_iterator> equal_range(K const& key) const;
+    iterator lower_bound(key_type const& key);
+    template <typename K, typename Compare = key_compare,
+              typename = typename Compare::is_transparent>
+    iterator lower_bound(K const& key);
+    const_iterator lower_bound(key_type const& key) const;
+    template <typename K, typename Compare = key_compare,
+              typename = typename Compare::is_transparent>
+    const_iterator lower_bound(K const& key) const;
+    iterator upper_bound(key_type const& key);
+    template <typename K, typename Compare = key_compare,
+              typename = typename Compare::is_transparent>
+    iterator upper_bound(K const& key);
+    const_iterator upper_bound(key_type const& key) const;
+    template <typename K, typename Compare = key_compare,
+              typename = typename Compare::is_transparent>
+    const_iterator upper_bound(K const& key) const;
+    range_type range(key_type const& lo, key_type const& hi);
+    const_range_type range(key_type const& lo, key_type const& hi) const;
+    template <typename F>
+    void for_each_span(F f) const;
+    template <typename F>
+    void for_each_span(key_type const& lo, key_type const& hi, F f) const;
+    template <typename F>
+    void parallel_for_each(F f, size_type threads = 0) const;
+    template <typename F>
+    void parallel_for_each(key_type const& lo, key_type const& hi, F f,
+                           size_type threads = 0) const;
+    template <typename U, typename F, typename Combine>
+    U parallel_reduce(U init, F f, Combine combine, size_type threads = 0) const;
+    template <typename U, typename F, typename Combine>
+    U parallel_reduce(key_type const& lo, key_type const& hi, U init, F f, Combine combine,
+                      size_type threads = 0) const;
+    template <typename ForwardIt, typename OutputIt>
+    OutputIt find_many(ForwardIt first, ForwardIt last, OutputIt out) const;
+    frozen_type freeze() const;
+    iterator nth(size_type n);
+    const_iterator nth(size_type n) const;
+    size_type rank(key_type const& key) const;
+    template <typename K, typename Compare = key_compare,
+              typename = typename Compare::is_transparent>
+    size_type rank(K const& key) const;
+    size_type index_of(const_iterator pos) const;
+
+    iterator begin() noexcept;
+    const_iterator begin() const noexcept;
+    const_iterator cbegin() const noexcept;
+    iterator end() noexcept;
+    const_iterator end() const noexcept;
+    const_iterator cend() const noexcept;
+    reverse_iterator rbegin() noexcept;
+    const_reverse_iterator rbegin() const noexcept;
+    const_reverse_iterator crbegin() const noexcept;
+    reverse_iterator rend() noexcept;
+    const_reverse_iterator rend() const noexcept;
+    const_reverse_iterator crend() const noexcept;
+
+    key_compare key_comp() const;
+    value_compare value_comp() const;
+    allocator_type get_allocator() const;
+
+    friend bool operator==(tree_base const& x, tree_base const& y)
+        { return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin()); }
+    friend bool operator!=(tree_base const& x, tree_base const& y)
+        { return !(x == y); }
+    friend bool operator> (tree_base const& x, tree_base const& y)
+        { return y < x; }
+    friend bool operator< (tree_base const& x, tree_base const& y)
+        { return std::lexicographical_compare(x.begin(), x.end(), y.begin(), y.end()); }
+    friend bool operator>=(tree_base const& x, tree_base const& y)
+        { return !(x < y); }
+    friend bool operator<=(tree_base const& x, tree_base const& y)
+        { return !(y < x); }
+
+ public:  // Static Public Method(s)
+    static constexpr size_type max_size() noexcept;
+    static constexpr size_type leaf_capacity() noexcept;
+    static constexpr size_type inner_capacity() noexcept;
+
+ private:  // Private Static Property(ies)
+    static constexpr size_type find_group_size = 16;
+
+ protected:  // Protected Method(s)
+    core_compare core_comp() const;
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> emplace_unique(K const& key, Args&&... args);
+
+ private:  // Private Method(s)
+    template <typename K>
+    leaf_node_type* lower_leaf(K const& key) const;
+    template <typename K>
+    leaf_node_type* upper_leaf(K const& key) const;
+    template <typename K>
+    iterator find_value(K const& key);
+    leaf_node_type* first_leaf() const noexcept;
+    static void prefetch_child(node_type const* child, size_type level) noexcept;
+    iterator make_iterator(leaf_node_type* leaf, size_type pos) const;
+
+    template <typename V>
+    insert_result_t insert_value(V&& value);
+    iterator make_insert_result(leaf_node_type* leaf, typename leaf_node_type::iterator it);
+    std::pair<iterator, bool> make_insert_result(
+        leaf_node_type* leaf, std::pair<typename leaf_node_type::iterator, bool> result);
+    static iterator get_iterator(iterator it) noexcept;
+    static iterator get_iterator(std::pair<iterator, bool> result) noexcept;
+
+    template <typename K>
+    size_type rank_of(K const& key) const;
+    void add_to_counts(node_type* node, difference_type delta) noexcept;
+    template <typename Node>
+    void recount(Node* node) noexcept;
+    static size_type subtree_size(leaf_node_type const* leaf) noexcept;
+    static size_type subtree_size(inner_node_type const* node) noexcept;
+
+    template <typename Node>
+    Node* split(Node* node);
+    void replace_last_leaf(leaf_node_type* leaf, leaf_node_type* replacement) noexcept;
+    void replace_last_leaf(inner_node_type* node, inner_node_type* replacement) noexcept;
+    template <typename Node>
+    Node* rebalance(Node* node, size_type& pos);
+    void shrink(inner_node_type* node);
+
+    template <typename Node>
+    static size_type fill_size(double fill_factor) noexcept;
+    template <typename InputIt>
+    std::vector<node_type*> build_leaves(InputIt first, InputIt last, double fill_factor);
+    template <typename InputIt>
+    size_type append_leaves(InputIt first, InputIt last, size_type fill,
+                            std::vector<node_type*>& leaves);
+    void rebalance_leaves(std::vector<node_type*>& leaves);
+
+    std::vector<const_iterator> split_range(key_type const* lo, key_type const* hi,
+                                            size_type count) const;
+    template <typename F>
+    void parallel_for_each(key_type const* lo, key_type const* hi, F& f, size_type threads) const;
+    template <typename U, typename F, typename Combine>
+    U parallel_reduce(key_type const* lo, key_type const* hi, U init, F& f, Combine& combine,
+                      size_type threads) const;
+    void build_upper_levels(std::vector<node_type*> nodes, double fill_factor);
+    std::vector<node_type*> build_inner_level(std::vector<node_type*> const& children,
+                                              double fill_factor);
+
+    template <typename Node, typename... Args>
+    Node* create_node(Args&&... args);
+    template <typename Node>
+    void destroy_node(Node* node) noexcept;
+    void destroy(node_type* node, size_type level) noexcept;
+    void destroy_leaves(std::vector<node_type*> const& leaves) noexcept;
+    void destroy_all(std::true_type) noexcept;
+    void destroy_all(std::false_type) noexcept;
+    void destroy_values(node_type* node, size_type level) noexcept;
+    void renew_allocators();
+    node_type* clone(node_type const* node, size_type level, leaf_node_type*& last_leaf);
+
+    leaf_allocator_type& node_allocator(leaf_node_type*) noexcept;
+    inner_allocator_type& node_allocator(inner_node_type*) noexcept;
+
+ private:  // Private Property(ies)
+    node_type* root_;
+    leaf_node_type* last_leaf_;
+    size_type size_;
+    size_type height_;
+    leaf_allocator_type leaf_alloc_;
+    inner_allocator_type inner_alloc_;
+    bool shares_alloc_;  // whether the allocators went along with the nodes of a moved tree
+};
+
+/************************************************
+ * Declaration: class tree<T, I, M, N, A, R>
+ ************************************************/
+
+template <typename ValueTraits, template <typename, typename> class InsertionPolicy,
+          std::size_t LeafN, std::size_t InnerN,
+          typename Allocator = std::allocator<typename ValueTraits::value_type>,
+          bool Ranked = false>
+class tree
+  : public tree_base<ValueTraits, InsertionPolicy, LeafN, InnerN, Allocator, Ranked> {
+ public:  // Public Method(s)
+    using tree_base<ValueTraits, InsertionPolicy, LeafN, InnerN, Allocator, Ranked>::tree_base;
+};
+
+/************************************************
+ * Declaration: class tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>
+ ************************************************/
+
+template <typename Key, typename T, typename Compare, std::size_t LeafN, std::size_t InnerN,
+          typename Allocator, bool Ranked>
+class tree<map_traits<Key, T, Compare>, deny_duplicates, LeafN, InnerN, Allocator, Ranked>
+  : public tree_base<map_traits<Key, T, Compare>, deny_duplicates, LeafN, InnerN, Allocator,
+                     Ranked> {
+ private:  // Private Type(s)
+    using base_t = tree_base<map_traits<Key, T, Compare>, deny_duplicates, LeafN, InnerN,
+                             Allocator, Ranked>;
+
+ public:  // Public Type(s)
+    using mapped_type = typename base_t::mapped_type;
+    using key_type = typename base_t::key_type;
+    using key_compare = typename base_t::key_compare;
+    using iterator = typename base_t::iterator;
+
+ private:  // Private Type(s)
+    template <typename K>
+    using enable_if_key_constructible_t = typename std::enable_if<
+            std::is_constructible<key_type, K&&>::value
+        >::type;
+
+ public:  // Public Method(s)
+    using base_t::base_t;
+
+    mapped_type& operator[](key_type const& key);
+    mapped_type& operator[](key_type&& key);
+    template <typename K, typename KeyCompare = key_compare,
+              typename = typename KeyCompare::is_transparent,
+              typename = enable_if_key_constructible_t<K>>
+    mapped_type& operator[](K&& key);
+    mapped_type& at(key_type const& key);
+    template <typename K, typename KeyCompare = key_compare,
+              typename = typename KeyCompare::is_transparent>
+    mapped_type& at(K const& key);
+    mapped_type const& at(key_type const& key) const;
+    template <typename K, typename KeyCompare = key_compare,
+              typename = typename KeyCompare::is_transparent>
+    mapped_type const& at(K const& key) const;
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(key_type const& key, Args&&... args);
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args);
+    template <typename K, typename... Args, typename KeyCompare = key_compare,
+              typename = typename KeyCompare::is_transparent,
+              typename = enable_if_key_constructible_t<K>>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args);
+    template <typename Obj>
+    std::pair<iterator, bool> insert_or_assign(key_type const& key, Obj&& obj);
+    template <typename Obj>
+    std::pair<iterator, bool> insert_or_assign(key_type&& key, Obj&& obj);
+
+ private:  // Private Method(s)
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> emplace_key(K&& key, Args&&... args);
+};
+
+/************************************************
+ * Declaration: build_parallel<Tree>(first, last, threads)
+ ************************************************/
+
+template <typename Tree, typename RandomIt>
+Tree build_parallel(RandomIt first, RandomIt last, std::size_t threads = 0);
+
+/************************************************
+ * Implementation: class tree_base<T, I, M, N, A, R>
+ ************************************************/
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline tree_base<T, I, M, N, A, R>::tree_base()
+  : tree_base(key_compare()) {
+    // do nothing
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline tree_base<T, I, M, N, A, R>::tree_base(key_compare comp, allocator_type const& alloc)
+  : value_compare(comp), root_(nullptr), last_leaf_(nullptr), size_(0), height_(0),
+    leaf_alloc_(alloc), inner_alloc_(alloc), shares_alloc_(false) {
+    // do nothing
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline tree_base<T, I, M, N, A, R>::tree_base(allocator_type const& alloc)
+  : tree_base(key_compare(), alloc) {
+    // do nothing
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename InputIt>
+inline tree_base<T, I, M, N, A, R>::tree_base(
+        InputIt first, InputIt last, key_compare const& comp, allocator_type const& alloc)
+  : tree_base(comp, alloc) {
+    insert(first, last);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename InputIt>
+inline tree_base<T, I, M, N, A, R>::tree_base(
+        sorted_input_t, InputIt first, InputIt last,
+        key_compare const& comp, allocator_type const& alloc)
+  : tree_base(comp, alloc) {
+    bulk_load(first, last);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline tree_base<T, I, M, N, A, R>::tree_base(
+        std::initializer_list<value_type> il, key_compare const& comp, allocator_type const& alloc)
+  : tree_base(il.begin(), il.end(), comp, alloc) {
+    // do nothing
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline tree_base<T, I, M, N, A, R>::tree_base(tree_base const& other)
+  : value_compare(static_cast<value_compare const&>(other)),
+    root_(nullptr), last_leaf_(nullptr), size_(other.size_), height_(other.height_),
+    leaf_alloc_(std::allocator_traits<leaf_allocator_type>::
+                select_on_container_copy_construction(other.leaf_alloc_)),
+    inner_alloc_(leaf_alloc_), shares_alloc_(false) {
+    if (other.root_) {
+        root_ = clone(other.root_, other.height_, last_leaf_);
+    }
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline tree_base<T, I, M, N, A, R>::tree_base(tree_base&& other) noexcept
+  : value_compare(static_cast<value_compare&&>(other)),
+    root_(other.root_), last_leaf_(other.last_leaf_), size_(other.size_), height_(other.height_),
+    leaf_alloc_(other.leaf_alloc_), inner_alloc_(other.inner_alloc_),
+    shares_alloc_(other.shares_alloc_) {
+    other.root_ = nullptr;
+    other.last_leaf_ = nullptr;
+    other.size_ = 0;
+    other.height_ = 0;
+
+    // the nodes went along with the allocator, which may release them all at once, so `other`
+    // must not keep sharing it; it gets an allocator of its own when it creates a node again,
+    // since doing so may allocate
+    other.shares_alloc_ = has_bulk_release<leaf_allocator_type>::value;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline tree_base<T, I, M, N, A, R>::~tree_base() {
+    clear();
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline tree_base<T, I, M, N, A, R>&
+tree_base<T, I, M, N, A, R>::operator=(std::initializer_list<value_type> il) {
+    clear();
+    insert(il);
+    return *this;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline tree_base<T, I, M, N, A, R>& tree_base<T, I, M, N, A, R>::operator=(tree_base const& other) {
+    if (this != &other) {
+        tree_base(other).swap(*this);
+    }
+
+    return *this;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline tree_base<T, I, M, N, A, R>& tree_base<T, I, M, N, A, R>::operator=(tree_base&& other) {
+    if (this != &other) {
+        tree_base(std::move(other)).swap(*this);
+    }
+
+    return *this;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline void tree_base<T, I, M, N, A, R>::swap(tree_base& other) {
+    using std::swap;
+    swap(static_cast<value_compare&>(*this), static_cast<value_compare&>(other));
+    swap(root_, other.root_);
+    swap(last_leaf_, other.last_leaf_);
+    swap(size_, other.size_);
+    swap(height_, other.height_);
+    swap(leaf_alloc_, other.leaf_alloc_);
+    swap(inner_alloc_, other.inner_alloc_);
+    swap(shares_alloc_, other.shares_alloc_);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::insert_result_t
+tree_base<T, I, M, N, A, R>::insert(value_type const& value) {
+    return insert_value(value);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename V>
+inline tree_base<T, I, M, N, A, R>::enable_if_value_constructible_t<
+    V, typename tree_base<T, I, M, N, A, R>::insert_result_t
+>
+tree_base<T, I, M, N, A, R>::insert(V&& value) {
+    return emplace(std::forward<V>(value));
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::insert(const_iterator hint, value_type const& value) {
+    return emplace_hint(hint, value);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename V>
+inline tree_base<T, I, M, N, A, R>::enable_if_value_constructible_t<
+    V, typename tree_base<T, I, M, N, A, R>::iterator
+>
+tree_base<T, I, M, N, A, R>::insert(const_iterator hint, V&& value) {
+    return emplace_hint(hint, std::forward<V>(value));
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename InputIt>
+void tree_base<T, I, M, N, A, R>::insert(InputIt first, InputIt last) {
+    if (empty() && is_sorted_input(first, last, value_comp())) {
+        bulk_load(first, last);
+        return;
+    }
+
+    while (first != last) {
+        insert(*first);
+        ++first;
+    }
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline void tree_base<T, I, M, N, A, R>::insert(std::initializer_list<value_type> il) {
+    insert(il.begin(), il.end());
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename InputIt>
+void tree_base<T, I, M, N, A, R>::bulk_load(InputIt first, InputIt last, double fill_factor) {
+    clear();
+
+    // build the tree bottom-up, one level at a time, instead of descending from the root for
+    // every value
+    build_upper_levels(build_leaves(first, last, fill_factor), fill_factor);
+}
+
+// Sorts `[first, last)` in place (stably, so that the first of equivalent values is kept by trees
+// that deny duplicates), then has each thread fill the leaves of a contiguous chunk of it. The
+// leaves must be allocated concurrently, so allocators that release in bulk, such as
+// `pool_allocator`, which do not synchronize, fill them on the calling thread. The inner levels,
+// which hold about one key per leaf, are built on the calling thread as well.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename RandomIt>
+void tree_base<T, I, M, N, A, R>::bulk_load_parallel(RandomIt first, RandomIt last,
+                                                     size_type threads, double fill_factor) {
+    clear();
+
+    if (threads == 0) {
+        threads = default_thread_count();
+    }
+
+    parallel_stable_sort(first, last, value_comp(), threads);
+
+    // give each thread enough values to fill a few dozen leaves, and never split a run of
+    // equivalent values across chunks
+    auto size = static_cast<size_type>(last - first);
+    if (has_bulk_release<leaf_allocator_type>::value) {
+        threads = 1;
+    }
+
+    threads = std::max(size_type(1),
+                       std::min(threads, size / (64 * leaf_node_type::capacity())));
+
+    std::vector<RandomIt> bounds(1, first);
+    for (size_type i = 1; i < threads; ++i) {
+        auto bound = std::max(bounds.back(), first + size * i / threads);
+        while (bound != first && bound != last && !value_comp()(*(bound - 1), *bound)) {
+            ++bound;
+        }
+
+        bounds.push_back(bound);
+    }
+
+    bounds.push_back(last);
+
+    auto fill = fill_size<leaf_node_type>(fill_factor);
+    std::vector<std::vector<node_type*>> chunks(threads);
+    std::vector<size_type> sizes(threads);
+    std::vector<node_type*> leaves;
+    try {
+        parallel_invoke(threads, [&](size_type i) {
+            sizes[i] = append_leaves(bounds[i], bounds[i + 1], fill, chunks[i]);
+        });
+
+        size_type count = 0;
+        for (auto const& chunk : chunks) {
+            count += chunk.size();
+        }
+
+        leaves.reserve(count);
+    } catch (...) {
+        for (auto const& chunk : chunks) {
+            destroy_leaves(chunk);
+        }
+
+        throw;
+    }
+
+    // link the chunks together, then even out the leaves at their seams
+    for (size_type i = 0; i < threads; ++i) {
+        if (chunks[i].empty()) {
+            continue;
+        }
+
+        if (!leaves.empty()) {
+            static_cast<leaf_node_type*>(leaves.back())->join(
+                *static_cast<leaf_node_type*>(chunks[i].front()));
+        }
+
+        leaves.insert(leaves.end(), chunks[i].begin(), chunks[i].end());
+        size_ += sizes[i];
+    }
+
+    rebalance_leaves(leaves);
+    build_upper_levels(std::move(leaves), fill_factor);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename... Args>
+inline typename tree_base<T, I, M, N, A, R>::insert_result_t
+tree_base<T, I, M, N, A, R>::emplace(Args&&... args) {
+    return insert_value(value_type(std::forward<Args>(args)...));
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename... Args>
+typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::emplace_hint(const_iterator, Args&&... args) {
+    return get_iterator(insert_value(value_type(std::forward<Args>(args)...)));
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::erase(const_iterator pos) {
+    auto leaf = const_cast<leaf_node_type*>(pos.leaf());
+    auto offset = pos.position();
+    leaf->erase(leaf->cbegin() + offset);
+    --size_;
+    add_to_counts(leaf, -1);
+
+    if (leaf->parent() == nullptr) {
+        if (leaf->empty()) {
+            destroy_node(leaf);
+            root_ = nullptr;
+            last_leaf_ = nullptr;
+            return end();
+        }
+    } else if (leaf->size() < leaf_node_type::min_size()) {
+        leaf = rebalance(leaf, offset);
+    }
+
+    return make_iterator(leaf, offset);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::erase(const_iterator first, const_iterator last) {
+    // rebalancing may move values between leaves and thereby invalidate `last`,
+    // so count the values to be erased beforehand
+    auto count = std::distance(first, last);
+    iterator it(const_cast<leaf_node_type*>(first.leaf()), first.position());
+    for (; count > 0; --count) {
+        it = erase(it);
+    }
+
+    return it;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+typename tree_base<T, I, M, N, A, R>::size_type
+tree_base<T, I, M, N, A, R>::erase(key_type const& key) {
+    auto range = equal_range(key);
+    auto count = std::distance(range.first, range.second);
+    erase(range.first, range.second);
+    return count;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename K, typename Compare, typename, typename>
+typename tree_base<T, I, M, N, A, R>::size_type
+tree_base<T, I, M, N, A, R>::erase(K const& key) {
+    auto range = equal_range(key);
+    auto count = std::distance(range.first, range.second);
+    erase(range.first, range.second);
+    return count;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline void tree_base<T, I, M, N, A, R>::clear() noexcept {
+    if (root_) {
+        destroy_all(has_bulk_release<leaf_allocator_type>());
+    }
+
+    root_ = nullptr;
+    last_leaf_ = nullptr;
+    size_ = 0;
+    height_ = 0;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline bool tree_base<T, I, M, N, A, R>::empty() const noexcept {
+    return size() == 0;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::size_type
+tree_base<T, I, M, N, A, R>::size() const noexcept {
+    return size_;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::size_type
+tree_base<T, I, M, N, A, R>::height() const noexcept {
+    return root_ ? height_ + 1 : 0;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline constexpr typename tree_base<T, I, M, N, A, R>::size_type
+tree_base<T, I, M, N, A, R>::max_size() noexcept {
+    return std::numeric_limits<difference_type>::max();
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline constexpr typename tree_base<T, I, M, N, A, R>::size_type
+tree_base<T, I, M, N, A, R>::leaf_capacity() noexcept {
+    return M;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline constexpr typename tree_base<T, I, M, N, A, R>::size_type
+tree_base<T, I, M, N, A, R>::inner_capacity() noexcept {
+    return N;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::size_type
+tree_base<T, I, M, N, A, R>::count(key_type const& key) const {
+    auto range = equal_range(key);
+    return std::distance(range.first, range.second);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename K, typename Compare, typename>
+inline typename tree_base<T, I, M, N, A, R>::size_type
+tree_base<T, I, M, N, A, R>::count(K const& key) const {
+    auto range = equal_range(key);
+    return std::distance(range.first, range.second);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::find(key_type const& key) {
+    return find_value(key);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename K, typename Compare, typename>
+typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::find(K const& key) {
+    return find_value(key);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::const_iterator
+tree_base<T, I, M, N, A, R>::find(key_type const& key) const {
+    return const_cast<tree_base*>(this)->find(key);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename K, typename Compare, typename>
+inline typename tree_base<T, I, M, N, A, R>::const_iterator
+tree_base<T, I, M, N, A, R>::find(K const& key) const {
+    return const_cast<tree_base*>(this)->find(key);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline std::pair<
+    typename tree_base<T, I, M, N, A, R>::iterator,
+    typename tree_base<T, I, M, N, A, R>::iterator
+>
+tree_base<T, I, M, N, A, R>::equal_range(key_type const& key) {
+    return {lower_bound(key), upper_bound(key)};
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename K, typename Compare, typename>
+inline std::pair<
+    typename tree_base<T, I, M, N, A, R>::iterator,
+    typename tree_base<T, I, M, N, A, R>::iterator
+>
+tree_base<T, I, M, N, A, R>::equal_range(K const& key) {
+    return {lower_bound(key), upper_bound(key)};
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline std::pair<
+    typename tree_base<T, I, M, N, A, R>::const_iterator,
+    typename tree_base<T, I, M, N, A, R>::const_iterator
+>
+tree_base<T, I, M, N, A, R>::equal_range(key_type const& key) const {
+    return {lower_bound(key), upper_bound(key)};
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename K, typename Compare, typename>
+inline std::pair<
+    typename tree_base<T, I, M, N, A, R>::const_iterator,
+    typename tree_base<T, I, M, N, A, R>::const_iterator
+>
+tree_base<T, I, M, N, A, R>::equal_range(K const& key) const {
+    return {lower_bound(key), upper_bound(key)};
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::lower_bound(key_type const& key) {
+    if (!root_) {
+        return end();
+    }
+
+    auto leaf = lower_leaf(key);
+    return make_iterator(leaf, leaf->lower_bound(key) - leaf->begin());
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename K, typename Compare, typename>
+typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::lower_bound(K const& key) {
+    if (!root_) {
+        return end();
+    }
+
+    auto leaf = lower_leaf(key);
+    return make_iterator(leaf, leaf->lower_bound(key) - leaf->begin());
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::const_iterator
+tree_base<T, I, M, N, A, R>::lower_bound(key_type const& key) const {
+    return const_cast<tree_base*>(this)->lower_bound(key);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename K, typename Compare, typename>
+inline typename tree_base<T, I, M, N, A, R>::const_iterator
+tree_base<T, I, M, N, A, R>::lower_bound(K const& key) const {
+    return const_cast<tree_base*>(this)->lower_bound(key);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::upper_bound(key_type const& key) {
+    if (!root_) {
+        return end();
+    }
+
+    auto leaf = upper_leaf(key);
+    return make_iterator(leaf, leaf->upper_bound(key) - leaf->begin());
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename K, typename Compare, typename>
+typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::upper_bound(K const& key) {
+    if (!root_) {
+        return end();
+    }
+
+    auto leaf = upper_leaf(key);
+    return make_iterator(leaf, leaf->upper_bound(key) - leaf->begin());
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::const_iterator
+tree_base<T, I, M, N, A, R>::upper_bound(key_type const& key) const {
+    return const_cast<tree_base*>(this)->upper_bound(key);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename K, typename Compare, typename>
+inline typename tree_base<T, I, M, N, A, R>::const_iterator
+tree_base<T, I, M, N, A, R>::upper_bound(K const& key) const {
+    return const_cast<tree_base*>(this)->upper_bound(key);
+}
+
+// The values with keys in [lo, hi), as one span per leaf.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+typename tree_base<T, I, M, N, A, R>::range_type
+tree_base<T, I, M, N, A, R>::range(key_type const& lo, key_type const& hi) {
+    auto first = lower_bound(lo);
+    auto last = key_comp()(lo, hi) ? lower_bound(hi) : first;
+    return range_type(first, last);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+typename tree_base<T, I, M, N, A, R>::const_range_type
+tree_base<T, I, M, N, A, R>::range(key_type const& lo, key_type const& hi) const {
+    auto first = lower_bound(lo);
+    auto last = key_comp()(lo, hi) ? lower_bound(hi) : first;
+    return const_range_type(first, last);
+}
+
+// Calls `f(data, size)` with the values of each leaf in turn. The loop over a span runs over a
+// plain array, which the compiler is free to vectorize.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename F>
+inline void tree_base<T, I, M, N, A, R>::for_each_span(F f) const {
+    for (auto span : const_range_type(cbegin(), cend())) {
+        f(span.data(), span.size());
+    }
+}
+
+// Same as above, for the values with keys in [lo, hi).
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename F>
+inline void tree_base<T, I, M, N, A, R>::for_each_span(key_type const& lo, key_type const& hi,
+                                                    F f) const {
+    for (auto span : range(lo, hi)) {
+        f(span.data(), span.size());
+    }
+}
+
+// Calls `f(value)` for every value, from `threads` threads at once (by default, one per hardware
+// thread) and in no particular order. The leaves are handed out in runs that each cover a subtree,
+// as threads become free.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename F>
+inline void tree_base<T, I, M, N, A, R>::parallel_for_each(F f, size_type threads) const {
+    parallel_for_each(static_cast<key_type const*>(nullptr), nullptr, f, threads);
+}
+
+// Same as above, for the values with keys in [lo, hi).
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename F>
+inline void tree_base<T, I, M, N, A, R>::parallel_for_each(key_type const& lo, key_type const& hi,
+                                                        F f, size_type threads) const {
+    if (key_comp()(lo, hi)) {
+        parallel_for_each(&lo, &hi, f, threads);
+    }
+}
+
+// Folds every value into an accumulator with `acc = f(acc, value)` on `threads` threads, and
+// combines the results with `combine(x, y)`. Each run of leaves is folded from a copy of `init`,
+// which must thus be an identity of `combine`; the results are combined in key order, so that
+// `combine` only needs to be associative.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename U, typename F, typename Combine>
+inline U tree_base<T, I, M, N, A, R>::parallel_reduce(U init, F f, Combine combine,
+                                                    size_type threads) const {
+    return parallel_reduce(static_cast<key_type const*>(nullptr), nullptr, std::move(init), f,
+                           combine, threads);
+}
+
+// Same as above, for the values with keys in [lo, hi).
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename U, typename F, typename Combine>
+inline U tree_base<T, I, M, N, A, R>::parallel_reduce(key_type const& lo, key_type const& hi,
+                                                    U init, F f, Combine combine,
+                                                    size_type threads) const {
+    if (!key_comp()(lo, hi)) {
+        return init;
+    }
+
+    return parallel_reduce(&lo, &hi, std::move(init), f, combine, threads);
+}
+
+// Writes the result of `find` for each key in [first, last) to `out`. The keys are looked up in
+// groups, which descend the tree together one level at a time: the nodes that the members of a
+// group need next are all prefetched before any of them is searched, so that their cache misses
+// overlap instead of following one another.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename ForwardIt, typename OutputIt>
+OutputIt tree_base<T, I, M, N, A, R>::find_many(ForwardIt first, ForwardIt last,
+                                             OutputIt out) const {
+    auto const end = cend();
+    ForwardIt keys[find_group_size];
+    node_type* nodes[find_group_size];
+    while (first != last) {
+        size_type n = 0;
+        for (; n < find_group_size && first != last; ++n, ++first) {
+            keys[n] = first;
+        }
+
+        if (!root_) {
+            for (size_type i = 0; i < n; ++i) {
+                *out++ = end;
+            }
+
+            continue;
+        }
+
+        std::fill(nodes, nodes + n, root_);
+        for (auto level = height_; level > 0; --level) {
+            for (size_type i = 0; i < n; ++i) {
+                auto inner = static_cast<inner_node_type*>(nodes[i]);
+                nodes[i] = inner->child(inner->lower_child(*keys[i]));
+                prefetch_child(nodes[i], level);
+            }
+        }
+
+        for (size_type i = 0; i < n; ++i) {
+            auto leaf = static_cast<leaf_node_type*>(nodes[i]);
+            const_iterator it = make_iterator(leaf, leaf->lower_bound(*keys[i]) - leaf->begin());
+            *out++ = it != end && !core_comp()(*keys[i], *it) ? it : end;
+        }
+    }
+
+    return out;
+}
+
+// Returns an immutable copy of the tree laid out for fast lookups.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::frozen_type
+tree_base<T, I, M, N, A, R>::freeze() const {
+    return frozen_type(cbegin(), cend(), key_comp());
+}
+
+// Returns an iterator to the `n`-th value (counting from 0), or `end()` if there are not that
+// many values.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::nth(size_type n) {
+    static_assert(R, "nth() requires a ranked tree");
+    if (n >= size_) {
+        return end();
+    }
+
+    auto node = root_;
+    for (auto level = height_; level > 0; --level) {
+        auto inner = static_cast<inner_node_type*>(node);
+        size_type pos = 0;
+        for (; n >= inner->count(pos); ++pos) {
+            n -= inner->count(pos);
+        }
+
+        node = inner->child(pos);
+    }
+
+    return iterator(static_cast<leaf_node_type*>(node), n);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::const_iterator
+tree_base<T, I, M, N, A, R>::nth(size_type n) const {
+    return const_cast<tree_base*>(this)->nth(n);
+}
+
+// Returns the number of values whose key is less than `key`.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::size_type
+tree_base<T, I, M, N, A, R>::rank(key_type const& key) const {
+    return rank_of(key);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename K, typename Compare, typename>
+inline typename tree_base<T, I, M, N, A, R>::size_type
+tree_base<T, I, M, N, A, R>::rank(K const& key) const {
+    return rank_of(key);
+}
+
+// Returns the position of `pos` in the tree, so that `index_of(last) - index_of(first)` is the
+// distance between two iterators, and `nth(index_of(pos)) == pos`.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+typename tree_base<T, I, M, N, A, R>::size_type
+tree_base<T, I, M, N, A, R>::index_of(const_iterator pos) const {
+    static_assert(R, "index_of() requires a ranked tree");
+    node_type const* node = pos.leaf();
+    if (!node) {
+        return 0;
+    }
+
+    auto index = pos.position();
+    for (auto parent = node->parent(); parent; node = parent, parent = parent->parent()) {
+        for (size_type i = 0, last = parent->index_of(node); i < last; ++i) {
+            index += parent->count(i);
+        }
+    }
+
+    return index;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::begin() noexcept {
+    return iterator(first_leaf(), 0);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::const_iterator
+tree_base<T, I, M, N, A, R>::begin() const noexcept {
+    return cbegin();
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::const_iterator
+tree_base<T, I, M, N, A, R>::cbegin() const noexcept {
+    return const_iterator(first_leaf(), 0);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::end() noexcept {
+    return iterator(last_leaf_, last_leaf_ ? last_leaf_->size() : 0);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::const_iterator
+tree_base<T, I, M, N, A, R>::end() const noexcept {
+    return cend();
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::const_iterator
+tree_base<T, I, M, N, A, R>::cend() const noexcept {
+    return const_iterator(last_leaf_, last_leaf_ ? last_leaf_->size() : 0);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::reverse_iterator
+tree_base<T, I, M, N, A, R>::rbegin() noexcept {
+    return reverse_iterator(end());
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::const_reverse_iterator
+tree_base<T, I, M, N, A, R>::rbegin() const noexcept {
+    return crbegin();
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::const_reverse_iterator
+tree_base<T, I, M, N, A, R>::crbegin() const noexcept {
+    return const_reverse_iterator(cend());
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::reverse_iterator
+tree_base<T, I, M, N, A, R>::rend() noexcept {
+    return reverse_iterator(begin());
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::const_reverse_iterator
+tree_base<T, I, M, N, A, R>::rend() const noexcept {
+    return crend();
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::const_reverse_iterator
+tree_base<T, I, M, N, A, R>::crend() const noexcept {
+    return const_reverse_iterator(cbegin());
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::key_compare
+tree_base<T, I, M, N, A, R>::key_comp() const {
+    return key_compare(*this);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::value_compare
+tree_base<T, I, M, N, A, R>::value_comp() const {
+    return static_cast<value_compare const&>(*this);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::allocator_type
+tree_base<T, I, M, N, A, R>::get_allocator() const {
+    return allocator_type(leaf_alloc_);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::core_compare
+tree_base<T, I, M, N, A, R>::core_comp() const {
+    return core_compare(*this);
+}
+
+// Descends once to the leaf where `key` belongs, and returns the value with an equivalent key if
+// the leaf holds one. Otherwise, constructs a value from `args` in place, splitting the leaf first
+// if it is full, as `insert_value()` does. `key` is not read once the value is built, so that
+// `args` may move from it. Only meant for trees that deny duplicates.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename K, typename... Args>
+std::pair<typename tree_base<T, I, M, N, A, R>::iterator, bool>
+tree_base<T, I, M, N, A, R>::emplace_unique(K const& key, Args&&... args) {
+    if (!root_) {
+        last_leaf_ = create_node<leaf_node_type>(key_comp());
+        root_ = last_leaf_;
+    }
+
+    auto leaf = upper_leaf(key);
+    auto it = leaf->lower_bound(key);
+    auto pos = static_cast<size_type>(it - leaf->begin());
+    if (it != leaf->end() && !core_comp()(key, *it)) {
+        return {iterator(leaf, pos), false};
+    }
+
+    // the values before `pos` are ordered before `key`, and the others after it
+    if (leaf->full()) {
+        auto right = split(leaf);
+        if (pos > leaf->size()) {
+            pos -= leaf->size();
+            leaf = right;
+        }
+    }
+
+    return {make_insert_result(leaf, leaf->emplace_at(pos, std::forward<Args>(args)...)), true};
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename K>
+typename tree_base<T, I, M, N, A, R>::leaf_node_type*
+tree_base<T, I, M, N, A, R>::lower_leaf(K const& key) const {
+    auto node = root_;
+    for (auto level = height_; level > 0; --level) {
+        auto inner = static_cast<inner_node_type*>(node);
+        node = inner->child(inner->lower_child(key));
+        prefetch_child(node, level);
+    }
+
+    return static_cast<leaf_node_type*>(node);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename K>
+typename tree_base<T, I, M, N, A, R>::leaf_node_type*
+tree_base<T, I, M, N, A, R>::upper_leaf(K const& key) const {
+    auto node = root_;
+    for (auto level = height_; level > 0; --level) {
+        auto inner = static_cast<inner_node_type*>(node);
+        node = inner->child(inner->upper_child(key));
+        prefetch_child(node, level);
+    }
+
+    return static_cast<leaf_node_type*>(node);
+}
+
+// Descends once to the leaf where `key` belongs, and tells a miss from that leaf: the first value
+// not less than `key` is either in it or, failing that, first in the next leaf.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename K>
+typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::find_value(K const& key) {
+    if (!root_) {
+        return end();
+    }
+
+    auto leaf = lower_leaf(key);
+    auto it = leaf->lower_bound(key);
+    if (it == leaf->end()) {
+        leaf = leaf->next_leaf();
+        if (!leaf) {
+            return end();
+        }
+
+        it = leaf->begin();
+    }
+
+    return core_comp()(key, *it) ? end() : iterator(leaf, it - leaf->begin());
+}
+
+// Prefetches `child`, found at `level` and thus a leaf if `level` is 1, before it is searched.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline void tree_base<T, I, M, N, A, R>::prefetch_child(node_type const* child,
+                                                        size_type level) noexcept {
+    if (level == 1) {
+        prefetch(static_cast<leaf_node_type const*>(child));
+    } else {
+        prefetch(static_cast<inner_node_type const*>(child));
+    }
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+typename tree_base<T, I, M, N, A, R>::leaf_node_type*
+tree_base<T, I, M, N, A, R>::first_leaf() const noexcept {
+    auto node = root_;
+    for (auto level = height_; level > 0; --level) {
+        node = static_cast<inner_node_type*>(node)->child(0);
+    }
+
+    return static_cast<leaf_node_type*>(node);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::make_iterator(leaf_node_type* leaf, size_type pos) const {
+    if (pos == leaf->size()) {
+        auto next = leaf->next_leaf();
+        if (next) {
+            return iterator(next, 0);
+        }
+    }
+
+    return iterator(leaf, pos);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename V>
+typename tree_base<T, I, M, N, A, R>::insert_result_t
+tree_base<T, I, M, N, A, R>::insert_value(V&& value) {
+    if (!root_) {
+        last_leaf_ = create_node<leaf_node_type>(key_comp());
+        root_ = last_leaf_;
+    }
+
+    auto const& key = value_traits::get_key(value);
+    auto leaf = upper_leaf(key);
+    if (leaf->full() && insertion_policy::is_insertable(
+            *leaf, value_comp(), leaf->upper_bound(key), value)) {
+        auto right = split(leaf);
+        if (!value_compare::operator()(value, *right->cbegin())) {
+            leaf = right;
+        }
+    }
+
+    return make_insert_result(leaf, leaf->insert(std::forward<V>(value)));
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::make_insert_result(
+        leaf_node_type* leaf, typename leaf_node_type::iterator it) {
+    ++size_;
+    add_to_counts(leaf, 1);
+    return iterator(leaf, it - leaf->begin());
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline std::pair<typename tree_base<T, I, M, N, A, R>::iterator, bool>
+tree_base<T, I, M, N, A, R>::make_insert_result(
+        leaf_node_type* leaf, std::pair<typename leaf_node_type::iterator, bool> result) {
+    if (result.second) {
+        ++size_;
+        add_to_counts(leaf, 1);
+    }
+
+    return {iterator(leaf, result.first - leaf->begin()), result.second};
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::get_iterator(iterator it) noexcept {
+    return it;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::iterator
+tree_base<T, I, M, N, A, R>::get_iterator(std::pair<iterator, bool> result) noexcept {
+    return result.first;
+}
+
+// Descends like `lower_leaf()`, adding up the counts of the children passed over on the way.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename K>
+typename tree_base<T, I, M, N, A, R>::size_type
+tree_base<T, I, M, N, A, R>::rank_of(K const& key) const {
+    static_assert(R, "rank() requires a ranked tree");
+    if (!root_) {
+        return 0;
+    }
+
+    size_type index = 0;
+    auto node = root_;
+    for (auto level = height_; level > 0; --level) {
+        auto inner = static_cast<inner_node_type*>(node);
+        auto pos = inner->lower_child(key);
+        for (size_type i = 0; i < pos; ++i) {
+            index += inner->count(i);
+        }
+
+        node = inner->child(pos);
+        prefetch_child(node, level);
+    }
+
+    auto leaf = static_cast<leaf_node_type*>(node);
+    return index + (leaf->lower_bound(key) - leaf->begin());
+}
+
+// Adds `delta` to the count of every ancestor of `node`, after values were inserted into or
+// erased from `node`. Does nothing unless the tree is ranked, and so do `recount()` and the
+// counts of inner nodes.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+void tree_base<T, I, M, N, A, R>::add_to_counts(node_type* node,
+                                                difference_type delta) noexcept {
+    if (!R) {
+        return;
+    }
+
+    for (auto parent = node->parent(); parent; node = parent, parent = parent->parent()) {
+        auto pos = parent->index_of(node);
+        parent->count(pos, parent->count(pos) + delta);
+    }
+}
+
+// Sets the count of `node` in its parent anew, after values were moved into or out of `node`.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename Node>
+inline void tree_base<T, I, M, N, A, R>::recount(Node* node) noexcept {
+    if (R) {
+        auto parent = node->parent();
+        parent->count(parent->index_of(node), subtree_size(node));
+    }
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::size_type
+tree_base<T, I, M, N, A, R>::subtree_size(leaf_node_type const* leaf) noexcept {
+    return leaf->size();
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::size_type
+tree_base<T, I, M, N, A, R>::subtree_size(inner_node_type const* node) noexcept {
+    size_type size = 0;
+    for (size_type pos = 0; pos < node->size(); ++pos) {
+        size += node->count(pos);
+    }
+
+    return size;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename Node>
+Node* tree_base<T, I, M, N, A, R>::split(Node* node) {
+    auto parent = node->parent();
+    if (!parent) {
+        parent = create_node<inner_node_type>(key_comp());
+        parent->insert_child(0, node->first_key(), node);
+        recount(node);
+        root_ = parent;
+        ++height_;
+    } else if (parent->full()) {
+        split(parent);
+        parent = node->parent();
+    }
+
+    auto right = create_node<Node>(key_comp());
+    node->split_into(*right);
+    parent->insert_child(parent->index_of(node) + 1, right->first_key(), right);
+    replace_last_leaf(node, right);
+    recount(node);
+    recount(right);
+    return right;
+}
+
+// Makes `replacement` the last leaf if `leaf` was, after `leaf` was split into it or merged into
+// it. Inner nodes never are, hence the overload that does nothing.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline void tree_base<T, I, M, N, A, R>::replace_last_leaf(
+        leaf_node_type* leaf, leaf_node_type* replacement) noexcept {
+    if (leaf == last_leaf_) {
+        last_leaf_ = replacement;
+    }
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline void tree_base<T, I, M, N, A, R>::replace_last_leaf(inner_node_type*,
+                                                           inner_node_type*) noexcept {
+    // do nothing
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename Node>
+Node* tree_base<T, I, M, N, A, R>::rebalance(Node* node, size_type& pos) {
+    auto parent = node->parent();
+    auto idx = parent->index_of(node);
+    if (idx > 0) {
+        auto left = static_cast<Node*>(parent->child(idx - 1));
+        if (left->size() > Node::min_size()) {
+            node->borrow_from_left(*left, parent->key(idx));
+            parent->replace_key(idx, node->first_key());
+            recount(left);
+            recount(node);
+            ++pos;
+            return node;
+        }
+    }
+
+    if (idx + 1 < parent->size()) {
+        auto right = static_cast<Node*>(parent->child(idx + 1));
+        if (right->size() > Node::min_size()) {
+            node->borrow_from_right(*right, parent->key(idx + 1));
+            parent->replace_key(idx + 1, right->first_key());
+            recount(node);
+            recount(right);
+            return node;
+        }
+    }
+
+    if (idx > 0) {
+        auto left = static_cast<Node*>(parent->child(idx - 1));
+        pos += left->size();
+        left->merge_from(*node, parent->key(idx));
+        parent->erase_child(idx);
+        replace_last_leaf(node, left);
+        destroy_node(node);
+        node = left;
+    } else {
+        auto right = static_cast<Node*>(parent->child(idx + 1));
+        node->merge_from(*right, parent->key(idx + 1));
+        parent->erase_child(idx + 1);
+        replace_last_leaf(right, node);
+        destroy_node(right);
+    }
+
+    recount(node);
+
+    shrink(parent);
+    return node;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+void tree_base<T, I, M, N, A, R>::shrink(inner_node_type* node) {
+    if (node->parent() == nullptr) {
+        if (node->size() == 1) {
+            root_ = node->child(0);
+            root_->parent(nullptr);
+            destroy_node(node);
+            --height_;
+        }
+    } else if (node->size() < inner_node_type::min_size()) {
+        size_type pos = 0;
+        rebalance(node, pos);
+    }
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename Node>
+inline typename tree_base<T, I, M, N, A, R>::size_type
+tree_base<T, I, M, N, A, R>::fill_size(double fill_factor) noexcept {
+    auto capacity = Node::capacity();
+    auto size = static_cast<size_type>(capacity * fill_factor);
+    return std::max(std::max(Node::min_size(), size_type(1)), std::min(capacity, size));
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename InputIt>
+std::vector<typename tree_base<T, I, M, N, A, R>::node_type*>
+tree_base<T, I, M, N, A, R>::build_leaves(InputIt first, InputIt last, double fill_factor) {
+    std::vector<node_type*> leaves;
+    try {
+        size_ += append_leaves(first, last, fill_size<leaf_node_type>(fill_factor), leaves);
+    } catch (...) {
+        destroy_leaves(leaves);
+        size_ = 0;
+        throw;
+    }
+
+    rebalance_leaves(leaves);
+    return leaves;
+}
+
+// Fills new leaves, linked to each other, with `fill` values each and appends them to `leaves`,
+// which holds them even if an exception is thrown. Returns the number of values appended.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename InputIt>
+typename tree_base<T, I, M, N, A, R>::size_type
+tree_base<T, I, M, N, A, R>::append_leaves(InputIt first, InputIt last, size_type fill,
+                                           std::vector<node_type*>& leaves) {
+    size_type count = 0;
+    leaf_node_type* leaf = nullptr;
+    for (; first != last; ++first) {
+        if (!leaf || (leaf->size() >= fill && insertion_policy::is_insertable(
+                *leaf, value_comp(), leaf->cend(), *first))) {
+            leaves.push_back(nullptr);
+            auto prev = leaf;
+            leaf = create_node<leaf_node_type>(key_comp());
+            leaves.back() = leaf;
+            if (prev) {
+                leaf->link_after(*prev);
+            }
+        }
+
+        count += leaf->append(*first);
+    }
+
+    return count;
+}
+
+// Brings every leaf up to the minimum size: an underfull leaf is refilled from its right sibling,
+// or merged with it if they do not hold enough values for two leaves, and the last leaf does the
+// same with its left sibling. Only the last leaf filled by each `append_leaves` may be underfull.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+void tree_base<T, I, M, N, A, R>::rebalance_leaves(std::vector<node_type*>& leaves) {
+    auto min_size = leaf_node_type::min_size();
+    for (size_type i = 0; i + 1 < leaves.size();) {
+        auto leaf = static_cast<leaf_node_type*>(leaves[i]);
+        if (leaf->size() >= min_size) {
+            ++i;
+            continue;
+        }
+
+        auto right = static_cast<leaf_node_type*>(leaves[i + 1]);
+        if (leaf->size() + right->size() >= 2 * min_size) {
+            while (leaf->size() < min_size) {
+                leaf->borrow_from_right(*right, right->first_key());
+            }
+        } else {
+            leaf->merge_from(*right, right->first_key());
+            destroy_node(right);
+            leaves.erase(leaves.begin() + (i + 1));
+        }
+    }
+
+    auto leaf = leaves.empty() ? nullptr : static_cast<leaf_node_type*>(leaves.back());
+    if (leaves.size() > 1 && leaf->size() < min_size) {
+        auto left = static_cast<leaf_node_type*>(leaves[leaves.size() - 2]);
+        if (left->size() + leaf->size() >= 2 * min_size) {
+            while (leaf->size() < min_size) {
+                leaf->borrow_from_left(*left, leaf->first_key());
+            }
+        } else {
+            left->merge_from(*leaf, leaf->first_key());
+            destroy_node(leaf);
+            leaves.pop_back();
+        }
+    }
+}
+
+// Builds the inner levels above `nodes`, the leaves of the tree, and makes the topmost one the
+// root; `nodes` always owns the topmost level built so far.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+void tree_base<T, I, M, N, A, R>::build_upper_levels(std::vector<node_type*> nodes,
+                                                     double fill_factor) {
+    last_leaf_ = nodes.empty() ? nullptr : static_cast<leaf_node_type*>(nodes.back());
+    try {
+        for (; nodes.size() > 1; ++height_) {
+            nodes = build_inner_level(nodes, fill_factor);
+        }
+    } catch (...) {
+        for (auto node : nodes) {
+            destroy(node, height_);
+        }
+
+        last_leaf_ = nullptr;
+        size_ = 0;
+        height_ = 0;
+        throw;
+    }
+
+    root_ = nodes.empty() ? nullptr : nodes.front();
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+std::vector<typename tree_base<T, I, M, N, A, R>::node_type*>
+tree_base<T, I, M, N, A, R>::build_inner_level(std::vector<node_type*> const& children,
+                                               double fill_factor) {
+    // spread the children evenly over as many nodes as the fill factor asks for, within the
+    // bounds imposed by the capacity and the minimum size of inner nodes
+    auto count = children.size();
+    auto capacity = inner_node_type::capacity();
+    auto fill = fill_size<inner_node_type>(fill_factor);
+    auto num_nodes = std::max((count + fill / 2) / fill, (count + capacity - 1) / capacity);
+    num_nodes = std::max(size_type(1),
+                         std::min(num_nodes, count / inner_node_type::min_size()));
+
+    std::vector<node_type*> nodes;
+    nodes.reserve(num_nodes);
+    try {
+        auto child = children.begin();
+        for (size_type i = 0; i < num_nodes; ++i) {
+            auto node = create_node<inner_node_type>(key_comp());
+            nodes.push_back(node);
+
+            auto size = count / num_nodes + (i < count % num_nodes);
+            for (size_type pos = 0; pos < size; ++pos, ++child) {
+                auto first_key = height_ == 0
+                    ? static_cast<leaf_node_type*>(*child)->first_key()
+                    : static_cast<inner_node_type*>(*child)->first_key();
+                node->insert_child(pos, first_key, *child);
+                node->count(pos, height_ == 0
+                    ? subtree_size(static_cast<leaf_node_type*>(*child))
+                    : subtree_size(static_cast<inner_node_type*>(*child)));
+            }
+        }
+    } catch (...) {
+        // detach the children again, since they are still owned by `children`
+        for (auto node : nodes) {
+            static_cast<inner_node_type*>(node)->clear();
+            destroy_node(static_cast<inner_node_type*>(node));
+        }
+
+        throw;
+    }
+
+    return nodes;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename Node, typename... Args>
+Node* tree_base<T, I, M, N, A, R>::create_node(Args&&... args) {
+    if (shares_alloc_) {
+        renew_allocators();
+    }
+
+    auto& alloc = node_allocator(static_cast<Node*>(nullptr));
+    using traits = std::allocator_traits<typename std::decay<decltype(alloc)>::type>;
+
+    auto node = traits::allocate(alloc, 1);
+    try {
+        traits::construct(alloc, node, std::forward<Args>(args)...);
+    } catch (...) {
+        traits::deallocate(alloc, node, 1);
+        throw;
+    }
+
+    return node;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename Node>
+inline void tree_base<T, I, M, N, A, R>::destroy_node(Node* node) noexcept {
+    auto& alloc = node_allocator(node);
+    using traits = std::allocator_traits<typename std::decay<decltype(alloc)>::type>;
+
+    traits::destroy(alloc, node);
+    traits::deallocate(alloc, node, 1);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+void tree_base<T, I, M, N, A, R>::destroy(node_type* node, size_type level) noexcept {
+    if (level == 0) {
+        destroy_node(static_cast<leaf_node_type*>(node));
+        return;
+    }
+
+    auto inner = static_cast<inner_node_type*>(node);
+    for (size_type pos = 0; pos < inner->size(); ++pos) {
+        destroy(inner->child(pos), level - 1);
+    }
+
+    destroy_node(inner);
+}
+
+// Cuts the values with keys in [lo, hi) (or all of them, for null bounds) into about `count`
+// consecutive runs, and returns their bounds. The runs start at the first leaf of the subtrees
+// that cover the range on the highest level that has enough of them, so that each run is made of
+// whole leaves, except for the first and last ones.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+std::vector<typename tree_base<T, I, M, N, A, R>::const_iterator>
+tree_base<T, I, M, N, A, R>::split_range(key_type const* lo, key_type const* hi,
+                                         size_type count) const {
+    std::vector<const_iterator> bounds(1, lo ? lower_bound(*lo) : cbegin());
+    auto last = hi ? lower_bound(*hi) : cend();
+    if (!root_) {
+        bounds.push_back(last);
+        return bounds;
+    }
+
+    std::vector<node_type*> nodes(1, root_);
+    auto level = height_;
+    for (; level > 0 && nodes.size() < count; --level) {
+        std::vector<node_type*> children;
+        for (size_type i = 0; i < nodes.size(); ++i) {
+            auto inner = static_cast<inner_node_type*>(nodes[i]);
+            auto first_pos = i == 0 && lo ? inner->lower_child(*lo) : 0;
+            auto last_pos = i + 1 == nodes.size() && hi
+                ? inner->lower_child(*hi)
+                : inner->size() - 1;
+            for (auto pos = first_pos; pos <= last_pos; ++pos) {
+                children.push_back(inner->child(pos));
+            }
+        }
+
+        nodes.swap(children);
+    }
+
+    for (size_type i = 1; i < nodes.size(); ++i) {
+        auto node = nodes[i];
+        for (auto l = level; l > 0; --l) {
+            node = static_cast<inner_node_type*>(node)->child(0);
+        }
+
+        bounds.push_back(const_iterator(static_cast<leaf_node_type*>(node), 0));
+    }
+
+    bounds.push_back(last);
+    return bounds;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename F>
+void tree_base<T, I, M, N, A, R>::parallel_for_each(key_type const* lo, key_type const* hi, F& f,
+                                                    size_type threads) const {
+    if (threads == 0) {
+        threads = default_thread_count();
+    }
+
+    // a few runs per thread, so that those done early can take over from the others
+    auto bounds = split_range(lo, hi, 8 * threads);
+    parallel_for(bounds.size() - 1, [&](size_type i) {
+        for (auto span : const_range_type(bounds[i], bounds[i + 1])) {
+            for (auto const& value : span) {
+                f(value);
+            }
+        }
+    }, threads);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+template <typename U, typename F, typename Combine>
+U tree_base<T, I, M, N, A, R>::parallel_reduce(key_type const* lo, key_type const* hi, U init,
+                                               F& f, Combine& combine, size_type threads) const {
+    if (threads == 0) {
+        threads = default_thread_count();
+    }
+
+    auto bounds = split_range(lo, hi, 8 * threads);
+    std::vector<U> results(bounds.size() - 1, init);
+    parallel_for(results.size(), [&](size_type i) {
+        auto acc = std::move(results[i]);
+        for (auto span : const_range_type(bounds[i], bounds[i + 1])) {
+            for (auto const& value : span) {
+                acc = f(std::move(acc), value);
+            }
+        }
+
+        results[i] = std::move(acc);
+    }, threads);
+
+    for (auto& result : results) {
+        init = combine(std::move(init), std::move(result));
+    }
+
+    return init;
+}
+
+// Destroys leaves that are not part of the tree yet. `append_leaves` may leave a null slot behind
+// when it fails to create a leaf.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+void tree_base<T, I, M, N, A, R>::destroy_leaves(std::vector<node_type*> const& leaves) noexcept {
+    for (auto node : leaves) {
+        if (node) {
+            destroy_node(static_cast<leaf_node_type*>(node));
+        }
+    }
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline void tree_base<T, I, M, N, A, R>::destroy_all(std::false_type) noexcept {
+    destroy(root_, height_);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline void tree_base<T, I, M, N, A, R>::destroy_all(std::true_type) noexcept {
+    // the allocator takes back every node at once, so only the values need to be destroyed,
+    // which is a no-op (and skips walking the tree) when they are trivially destructible
+    if (!std::is_trivially_destructible<value_type>::value ||
+            !std::is_trivially_destructible<key_type>::value) {
+        destroy_values(root_, height_);
+    }
+
+    // the inner allocator is a rebound copy of the leaf one, sharing its resource, so releasing
+    // through either of them releases both
+    leaf_alloc_.release();
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+void tree_base<T, I, M, N, A, R>::destroy_values(node_type* node, size_type level) noexcept {
+    if (level == 0) {
+        static_cast<leaf_node_type*>(node)->~leaf_node_type();
+        return;
+    }
+
+    auto inner = static_cast<inner_node_type*>(node);
+    for (size_type pos = 0; pos < inner->size(); ++pos) {
+        destroy_values(inner->child(pos), level - 1);
+    }
+
+    inner->~inner_node_type();
+}
+
+// Replaces allocators left shared with the tree that the nodes were moved to by fresh ones.
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+void tree_base<T, I, M, N, A, R>::renew_allocators() {
+    leaf_allocator_type leaf_alloc = std::allocator_traits<leaf_allocator_type>::
+        select_on_container_copy_construction(leaf_alloc_);
+    inner_alloc_ = inner_allocator_type(leaf_alloc);
+    leaf_alloc_ = leaf_alloc;
+    shares_alloc_ = false;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+typename tree_base<T, I, M, N, A, R>::node_type*
+tree_base<T, I, M, N, A, R>::clone(node_type const* node, size_type level,
+                                   leaf_node_type*& last_leaf) {
+    if (level == 0) {
+        auto leaf = create_node<leaf_node_type>(*static_cast<leaf_node_type const*>(node));
+        leaf->parent(nullptr);
+        if (last_leaf) {
+            leaf->link_after(*last_leaf);
+        }
+
+        last_leaf = leaf;
+        return leaf;
+    }
+
+    auto other = static_cast<inner_node_type const*>(node);
+    auto inner = create_node<inner_node_type>(key_comp());
+    try {
+        for (size_type pos = 0; pos < other->size(); ++pos) {
+            auto child = clone(other->child(pos), level - 1, last_leaf);
+            inner->insert_child(pos, other->key(pos), child);
+            inner->count(pos, other->count(pos));
+        }
+    } catch (...) {
+        destroy(inner, level);
+        throw;
+    }
+
+    return inner;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::leaf_allocator_type&
+tree_base<T, I, M, N, A, R>::node_allocator(leaf_node_type*) noexcept {
+    return leaf_alloc_;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+inline typename tree_base<T, I, M, N, A, R>::inner_allocator_type&
+tree_base<T, I, M, N, A, R>::node_allocator(inner_node_type*) noexcept {
+    return inner_alloc_;
+}
+
+/************************************************
+ * Implementation: class tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>
+ ************************************************/
+
+template <typename K, typename T, typename C, std::size_t M, std::size_t N, typename A,
+          bool R>
+typename tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::mapped_type&
+tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::operator[](key_type const& key) {
+    return try_emplace(key).first->second;
+}
+
+template <typename K, typename T, typename C, std::size_t M, std::size_t N, typename A,
+          bool R>
+typename tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::mapped_type&
+tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::operator[](key_type&& key) {
+    return try_emplace(std::move(key)).first->second;
+}
+
+template <typename K, typename T, typename C, std::size_t M, std::size_t N, typename A,
+          bool R>
+template <typename Key, typename KeyCompare, typename, typename>
+typename tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::mapped_type&
+tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::operator[](Key&& key) {
+    return try_emplace(std::forward<Key>(key)).first->second;
+}
+
+template <typename K, typename T, typename C, std::size_t M, std::size_t N, typename A,
+          bool R>
+inline typename tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::mapped_type&
+tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::at(key_type const& key) {
+    return const_cast<mapped_type&>(
+        static_cast<tree const*>(this)->at(key));
+}
+
+template <typename K, typename T, typename C, std::size_t M, std::size_t N, typename A,
+          bool R>
+typename tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::mapped_type const&
+tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::at(key_type const& key) const {
+    auto it = this->find(key);
+    if (it == this->cend()) {
+        throw std::out_of_range("key not found");
+    }
+
+    return it->second;
+}
+
+template <typename K, typename T, typename C, std::size_t M, std::size_t N, typename A,
+          bool R>
+template <typename Key, typename KeyCompare, typename>
+inline typename tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::mapped_type&
+tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::at(Key const& key) {
+    return const_cast<mapped_type&>(
+        static_cast<tree const*>(this)->at(key));
+}
+
+template <typename K, typename T, typename C, std::size_t M, std::size_t N, typename A,
+          bool R>
+template <typename Key, typename KeyCompare, typename>
+typename tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::mapped_type const&
+tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::at(Key const& key) const {
+    auto it = this->find(key);
+    if (it == this->cend()) {
+        throw std::out_of_range("key not found");
+    }
+
+    return it->second;
+}
+
+template <typename K, typename T, typename C, std::size_t M, std::size_t N, typename A,
+          bool R>
+template <typename... Args>
+inline std::pair<typename tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::iterator, bool>
+tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::try_emplace(
+        key_type const& key, Args&&... args) {
+    return emplace_key(key, std::forward<Args>(args)...);
+}
+
+template <typename K, typename T, typename C, std::size_t M, std::size_t N, typename A,
+          bool R>
+template <typename... Args>
+inline std::pair<typename tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::iterator, bool>
+tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::try_emplace(
+        key_type&& key, Args&&... args) {
+    return emplace_key(std::move(key), std::forward<Args>(args)...);
+}
+
+template <typename K, typename T, typename C, std::size_t M, std::size_t N, typename A,
+          bool R>
+template <typename Key, typename... Args, typename KeyCompare, typename, typename>
+inline std::pair<typename tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::iterator, bool>
+tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::try_emplace(Key&& key, Args&&... args) {
+    return emplace_key(std::forward<Key>(key), std::forward<Args>(args)...);
+}
+
+// `obj` is only moved from by `emplace_key` if `key` is missing, so it can still be assigned.
+template <typename K, typename T, typename C, std::size_t M, std::size_t N, typename A,
+          bool R>
+template <typename Obj>
+std::pair<typename tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::iterator, bool>
+tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::insert_or_assign(
+        key_type const& key, Obj&& obj) {
+    auto result = emplace_key(key, std::forward<Obj>(obj));
+    if (!result.second) {
+        result.first->second = std::forward<Obj>(obj);
+    }
+
+    return result;
+}
+
+template <typename K, typename T, typename C, std::size_t M, std::size_t N, typename A,
+          bool R>
+template <typename Obj>
+std::pair<typename tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::iterator, bool>
+tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::insert_or_assign(
+        key_type&& key, Obj&& obj) {
+    auto result = emplace_key(std::move(key), std::forward<Obj>(obj));
+    if (!result.second) {
+        result.first->second = std::forward<Obj>(obj);
+    }
+
+    return result;
+}
+
+// Searches with `key` as is, and only builds a value (and converts `key` to `key_type`) if it has
+// to be inserted, in place in the leaf found by the search.
+template <typename K, typename T, typename C, std::size_t M, std::size_t N, typename A,
+          bool R>
+template <typename Key, typename... Args>
+inline std::pair<typename tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::iterator, bool>
+tree<map_traits<K, T, C>, deny_duplicates, M, N, A, R>::emplace_key(Key&& key, Args&&... args) {
+    return this->emplace_unique(key, std::piecewise_construct,
+                                std::forward_as_tuple(std::forward<Key>(key)),
+                                std::forward_as_tuple(std::forward<Args>(args)...));
+}
+
+/************************************************
+ * Implementation: build_parallel<Tree>(first, last, threads)
+ ************************************************/
+
+// Builds a tree from the unsorted values in `[first, last)`, which end up sorted, on `threads`
+// threads (by default, one per hardware thread). See `tree_base::bulk_load_parallel`.
+template <typename Tree, typename RandomIt>
+Tree build_parallel(RandomIt first, RandomIt last, std::size_t threads) {
+    Tree tree;
+    tree.bulk_load_parallel(first, last, threads);
+    return tree;
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+/************************************************
+ * Implementation: std::swap(tree<T, I, M, N, A, R>&, tree<T, I, M, N, A, R>&)
+ ************************************************/
+
+namespace std {
+
+template <typename T, template <typename, typename> class I, std::size_t M, std::size_t N,
+          typename A, bool R>
+void swap(bptree::internal::tree<T, I, M, N, A, R>& t1,
+          bptree::internal::tree<T, I, M, N, A, R>& t2) {
+    t1.swap(t2);
+}
+
+}  // namespace std
+
+#endif  // BPTREE_INTERNAL_TREE_HPP_
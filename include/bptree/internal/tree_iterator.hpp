@@ -0,0 +1,117 @@
+/************************************************
+ *  tree_iterator.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_TREE_ITERATOR_HPP_
+#define BPTREE_INTERNAL_TREE_ITERATOR_HPP_
+
+#include <cstddef>
+
+#include <iterator>
+#include <type_traits>
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: class tree_iterator<L, V>
+ ************************************************/
+
+// Holds a pointer to the current value besides its leaf, so that stepping within a leaf is a
+// pointer increment; crossing to a sibling leaf follows the leaf chain.
+template <typename Leaf, typename Value>
+class tree_iterator {
+ public:  // Public Type(s)
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = std::remove_const_t<Value>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Value*;
+    using reference = Value&;
+    using size_type = std::size_t;
+
+ public:  // Public Method(s)
+    tree_iterator()
+      : leaf_(nullptr), ptr_(nullptr)
+        { /* do nothing */ }
+    tree_iterator(Leaf* leaf, size_type pos)
+      : leaf_(leaf), ptr_(leaf ? first_of(leaf) + pos : nullptr)
+        { /* do nothing */ }
+
+    reference operator*() const
+        { return *ptr_; }
+    pointer operator->() const
+        { return ptr_; }
+
+    tree_iterator& operator++()
+        { increment(); return *this; }
+    tree_iterator& operator--()
+        { decrement(); return *this; }
+    tree_iterator operator++(int)
+        { tree_iterator it(*this); increment(); return it; }
+    tree_iterator operator--(int)
+        { tree_iterator it(*this); decrement(); return it; }
+
+    bool operator==(tree_iterator const& other) const noexcept
+        { return ptr_ == other.ptr_; }
+    bool operator!=(tree_iterator const& other) const noexcept
+        { return !(*this == other); }
+
+    template <typename AnotherLeaf, typename AnotherValue>
+    operator tree_iterator<AnotherLeaf, AnotherValue>() const noexcept
+        { return tree_iterator<AnotherLeaf, AnotherValue>(leaf_, position()); }
+
+    Leaf* leaf() const noexcept
+        { return leaf_; }
+    size_type position() const noexcept
+        { return leaf_ ? ptr_ - first_of(leaf_) : 0; }
+
+ private:  // Private Method(s)
+    void increment();
+    void decrement();
+
+ private:  // Static Private Method(s)
+    static pointer first_of(Leaf* leaf) noexcept
+        { return leaf->begin().operator->(); }
+    static pointer last_of(Leaf* leaf) noexcept
+        { return leaf->end().operator->(); }
+
+ private:  // Private Property(ies)
+    Leaf* leaf_;
+    pointer ptr_;
+};
+
+/************************************************
+ * Implementation: class tree_iterator<L, V>
+ ************************************************/
+
+template <typename L, typename V>
+inline void tree_iterator<L, V>::increment() {
+    if (++ptr_ == last_of(leaf_)) {
+        auto next = leaf_->next_leaf();
+        if (next) {
+            leaf_ = next;
+            ptr_ = first_of(next);
+        }
+    }
+}
+
+template <typename L, typename V>
+inline void tree_iterator<L, V>::decrement() {
+    if (ptr_ == first_of(leaf_)) {
+        leaf_ = leaf_->prev_leaf();
+        ptr_ = last_of(leaf_);
+    }
+
+    --ptr_;
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_TREE_ITERATOR_HPP_
@@ -0,0 +1,488 @@
+/************************************************
+ *  tree_node.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_TREE_NODE_HPP_
+#define BPTREE_INTERNAL_TREE_NODE_HPP_
+
+#include <cstddef>
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "./allow_duplicates.hpp"
+#include "./map_traits.hpp"
+#include "./search.hpp"
+#include "./static_assoc.hpp"
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: class tree_node<I>
+ ************************************************/
+
+template <typename Inner>
+class tree_node {
+ public:  // Public Method(s)
+    tree_node() noexcept;
+
+    Inner* parent() const noexcept;
+    void parent(Inner* parent) noexcept;
+
+ private:  // Private Property(ies)
+    Inner* parent_;
+};
+
+/************************************************
+ * Declaration: struct child_ref<T, C>
+ ************************************************/
+
+// Reference from an inner node to a child. Ranked trees also keep the number of values in the
+// subtree of the child next to it; in other trees, counts read as zero and are not stored.
+template <typename Node, bool Counted>
+struct child_ref {
+    child_ref(Node* node) noexcept
+      : node(node)
+        { /* do nothing */ }
+
+    std::size_t count() const noexcept
+        { return 0; }
+    void count(std::size_t) noexcept
+        { /* do nothing */ }
+
+    Node* node;
+};
+
+template <typename Node>
+struct child_ref<Node, true> {
+    child_ref(Node* node) noexcept
+      : node(node), size(0)
+        { /* do nothing */ }
+
+    std::size_t count() const noexcept
+        { return size; }
+    void count(std::size_t count) noexcept
+        { size = count; }
+
+    Node* node;
+    std::size_t size;
+};
+
+/************************************************
+ * Declaration: class inner_node<K, C, N, R>
+ ************************************************/
+
+// Each entry of an inner node pairs a child with a separator key that bounds the keys of that
+// child from below. The separator of the first entry is never consulted, since the separator of
+// the node itself (stored in its parent) already serves that purpose.
+template <typename Key, typename Compare, std::size_t N, bool Counted>
+class inner_node
+  : public tree_node<inner_node<Key, Compare, N, Counted>>,
+    public static_assoc<
+        map_traits<Key, child_ref<tree_node<inner_node<Key, Compare, N, Counted>>, Counted>,
+                   Compare>,
+        allow_duplicates, N
+    > {
+ private:  // Private Type(s)
+    using child_type = child_ref<tree_node<inner_node>, Counted>;
+    using base_t = static_assoc<map_traits<Key, child_type, Compare>, allow_duplicates, N>;
+    using search_kernel_type = search_kernel<map_traits<Key, child_type, Compare>, N>;
+
+ public:  // Public Type(s)
+    using node_type = tree_node<inner_node>;
+    using key_type = typename base_t::key_type;
+    using value_type = typename base_t::value_type;
+    using key_compare = typename base_t::key_compare;
+    using size_type = typename base_t::size_type;
+
+ public:  // Public Method(s)
+    explicit inner_node(key_compare const& comp);
+
+    node_type* child(size_type pos) const;
+    size_type count(size_type pos) const;
+    void count(size_type pos, size_type count);
+    key_type const& key(size_type pos) const;
+    key_type const& first_key() const;
+    size_type index_of(node_type const* child) const;
+    template <typename K>
+    size_type lower_child(K const& key) const;
+    template <typename K>
+    size_type upper_child(K const& key) const;
+
+    void insert_child(size_type pos, key_type const& key, node_type* child);
+    void erase_child(size_type pos);
+    void replace_key(size_type pos, key_type const& key);
+
+    void split_into(inner_node& right);
+    void merge_from(inner_node& right, key_type const& sep);
+    void borrow_from_left(inner_node& left, key_type const& sep);
+    void borrow_from_right(inner_node& right, key_type const& sep);
+
+ public:  // Static Public Method(s)
+    static constexpr size_type min_size() noexcept;
+};
+
+/************************************************
+ * Declaration: struct select_inner_node<K, C, N, R>
+ ************************************************/
+
+// Picks the inner node of a tree. Keys with a more compact layout specialize it (see
+// `string_node.hpp`).
+template <typename Key, typename Compare, std::size_t N, bool Counted>
+struct select_inner_node {
+    using type = inner_node<Key, Compare, N, Counted>;
+};
+
+/************************************************
+ * Declaration: class leaf_node<T, I, N, P>
+ ************************************************/
+
+// Leaves are chained to their siblings in key order, so that iterators step from one leaf to the
+// next in constant time instead of climbing back up the tree.
+
+template <typename ValueTraits, template <typename, typename> class InsertionPolicy,
+          std::size_t N, typename Inner>
+class leaf_node
+  : public tree_node<Inner>,
+    public static_assoc<ValueTraits, InsertionPolicy, N> {
+ private:  // Private Type(s)
+    using base_t = static_assoc<ValueTraits, InsertionPolicy, N>;
+
+ public:  // Public Type(s)
+    using node_type = tree_node<Inner>;
+    using key_type = typename base_t::key_type;
+    using value_type = typename base_t::value_type;
+    using key_compare = typename base_t::key_compare;
+    using size_type = typename base_t::size_type;
+
+ public:  // Public Method(s)
+    explicit leaf_node(key_compare const& comp);
+    leaf_node(leaf_node const& other);
+
+    using base_t::append;
+    template <typename... Args>
+    typename base_t::iterator emplace_at(size_type pos, Args&&... args);
+
+    key_type const& first_key() const;
+    leaf_node* next_leaf() const noexcept;
+    leaf_node* prev_leaf() const noexcept;
+    void link_after(leaf_node& left) noexcept;
+    void join(leaf_node& right) noexcept;
+    void unlink() noexcept;
+
+    void split_into(leaf_node& right);
+    void merge_from(leaf_node& right, key_type const& sep);
+    void borrow_from_left(leaf_node& left, key_type const& sep);
+    void borrow_from_right(leaf_node& right, key_type const& sep);
+
+ public:  // Static Public Method(s)
+    static constexpr size_type min_size() noexcept;
+
+ private:  // Private Property(ies)
+    leaf_node* next_;
+    leaf_node* prev_;
+};
+
+/************************************************
+ * Implementation: class tree_node<I>
+ ************************************************/
+
+template <typename I>
+inline tree_node<I>::tree_node() noexcept
+  : parent_(nullptr) {
+    // do nothing
+}
+
+template <typename I>
+inline I* tree_node<I>::parent() const noexcept {
+    return parent_;
+}
+
+template <typename I>
+inline void tree_node<I>::parent(I* parent) noexcept {
+    parent_ = parent;
+}
+
+/************************************************
+ * Implementation: class inner_node<K, C, N, R>
+ ************************************************/
+
+template <typename K, typename C, std::size_t N, bool R>
+inline inner_node<K, C, N, R>::inner_node(key_compare const& comp)
+  : node_type(), base_t(comp) {
+    // do nothing
+}
+
+template <typename K, typename C, std::size_t N, bool R>
+inline typename inner_node<K, C, N, R>::node_type*
+inner_node<K, C, N, R>::child(size_type pos) const {
+    return this->values()[pos].second.node;
+}
+
+template <typename K, typename C, std::size_t N, bool R>
+inline typename inner_node<K, C, N, R>::size_type
+inner_node<K, C, N, R>::count(size_type pos) const {
+    return this->values()[pos].second.count();
+}
+
+template <typename K, typename C, std::size_t N, bool R>
+inline void inner_node<K, C, N, R>::count(size_type pos, size_type count) {
+    this->values()[pos].second.count(count);
+}
+
+template <typename K, typename C, std::size_t N, bool R>
+inline typename inner_node<K, C, N, R>::key_type const&
+inner_node<K, C, N, R>::key(size_type pos) const {
+    return this->values()[pos].first;
+}
+
+template <typename K, typename C, std::size_t N, bool R>
+inline typename inner_node<K, C, N, R>::key_type const&
+inner_node<K, C, N, R>::first_key() const {
+    return key(0);
+}
+
+template <typename K, typename C, std::size_t N, bool R>
+inline typename inner_node<K, C, N, R>::size_type
+inner_node<K, C, N, R>::index_of(node_type const* child) const {
+    auto first = this->cbegin();
+    auto it = std::find_if(first, this->cend(), [child](auto const& entry) {
+        return entry.second.node == child;
+    });
+
+    return it - first;
+}
+
+template <typename K, typename C, std::size_t N, bool R>
+template <typename Key>
+inline typename inner_node<K, C, N, R>::size_type
+inner_node<K, C, N, R>::lower_child(Key const& key) const {
+    auto first = this->cbegin() + 1;
+    auto it = search_kernel_type::lower_bound(first, this->cend(), key, this->core_comp());
+    return it - first;
+}
+
+template <typename K, typename C, std::size_t N, bool R>
+template <typename Key>
+inline typename inner_node<K, C, N, R>::size_type
+inner_node<K, C, N, R>::upper_child(Key const& key) const {
+    auto first = this->cbegin() + 1;
+    auto it = search_kernel_type::upper_bound(first, this->cend(), key, this->core_comp());
+    return it - first;
+}
+
+template <typename K, typename C, std::size_t N, bool R>
+inline void inner_node<K, C, N, R>::insert_child(size_type pos, key_type const& key,
+                                                 node_type* child) {
+    auto& values = this->values();
+    values.emplace(values.cbegin() + pos, key, child);
+    child->parent(this);
+}
+
+template <typename K, typename C, std::size_t N, bool R>
+inline void inner_node<K, C, N, R>::erase_child(size_type pos) {
+    auto& values = this->values();
+    values.erase(values.cbegin() + pos);
+}
+
+template <typename K, typename C, std::size_t N, bool R>
+inline void inner_node<K, C, N, R>::replace_key(size_type pos, key_type const& key) {
+    auto ptr = this->values().data() + pos;
+    auto child = ptr->second;
+    ptr->~value_type();
+    ::new(ptr) value_type(key, child);
+}
+
+template <typename K, typename C, std::size_t N, bool R>
+void inner_node<K, C, N, R>::split_into(inner_node& right) {
+    auto& values = this->values();
+    auto mid = values.data() + (values.size() + 1) / 2;
+    auto last = values.data() + values.size();
+
+    auto& right_values = right.values();
+    right_values.insert(right_values.cend(),
+                        std::make_move_iterator(mid), std::make_move_iterator(last));
+    values.erase(values.cbegin() + (mid - values.data()), values.cend());
+
+    for (auto& entry : right_values) {
+        entry.second.node->parent(&right);
+    }
+}
+
+template <typename K, typename C, std::size_t N, bool R>
+void inner_node<K, C, N, R>::merge_from(inner_node& right, key_type const& sep) {
+    auto& values = this->values();
+    auto& right_values = right.values();
+    auto offset = values.size();
+
+    values.emplace_back(sep, right_values.front().second);
+    values.insert(values.cend(),
+                  std::make_move_iterator(right_values.data() + 1),
+                  std::make_move_iterator(right_values.data() + right_values.size()));
+    right_values.clear();
+
+    for (auto it = values.begin() + offset; it != values.end(); ++it) {
+        it->second.node->parent(this);
+    }
+}
+
+template <typename K, typename C, std::size_t N, bool R>
+void inner_node<K, C, N, R>::borrow_from_left(inner_node& left, key_type const& sep) {
+    auto& values = this->values();
+    auto& left_values = left.values();
+
+    replace_key(0, sep);
+    values.emplace(values.cbegin(), std::move(left_values.back()));
+    left_values.pop_back();
+    values.front().second.node->parent(this);
+}
+
+template <typename K, typename C, std::size_t N, bool R>
+void inner_node<K, C, N, R>::borrow_from_right(inner_node& right, key_type const& sep) {
+    auto& values = this->values();
+    auto& right_values = right.values();
+
+    values.emplace_back(sep, right_values.front().second);
+    right_values.erase(right_values.cbegin());
+    values.back().second.node->parent(this);
+}
+
+template <typename K, typename C, std::size_t N, bool R>
+inline constexpr typename inner_node<K, C, N, R>::size_type
+inner_node<K, C, N, R>::min_size() noexcept {
+    return N / 2;
+}
+
+/************************************************
+ * Implementation: class leaf_node<T, I, N, P>
+ ************************************************/
+
+template <typename T, template <typename, typename> class I, std::size_t N, typename P>
+inline leaf_node<T, I, N, P>::leaf_node(key_compare const& comp)
+  : node_type(), base_t(comp), next_(nullptr), prev_(nullptr) {
+    // do nothing
+}
+
+// The copy is not linked to any sibling: it is up to the caller to put it in a chain.
+template <typename T, template <typename, typename> class I, std::size_t N, typename P>
+inline leaf_node<T, I, N, P>::leaf_node(leaf_node const& other)
+  : node_type(other), base_t(static_cast<base_t const&>(other)),
+    next_(nullptr), prev_(nullptr) {
+    // do nothing
+}
+
+// Constructs a value from `args` at `pos`, which the caller knows to keep the values ordered.
+template <typename T, template <typename, typename> class I, std::size_t N, typename P>
+template <typename... Args>
+inline typename leaf_node<T, I, N, P>::base_t::iterator
+leaf_node<T, I, N, P>::emplace_at(size_type pos, Args&&... args) {
+    auto& values = this->values();
+    return values.emplace(values.cbegin() + pos, std::forward<Args>(args)...);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t N, typename P>
+inline typename leaf_node<T, I, N, P>::key_type const&
+leaf_node<T, I, N, P>::first_key() const {
+    return T::get_key(this->values().front());
+}
+
+template <typename T, template <typename, typename> class I, std::size_t N, typename P>
+inline leaf_node<T, I, N, P>* leaf_node<T, I, N, P>::next_leaf() const noexcept {
+    return next_;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t N, typename P>
+inline leaf_node<T, I, N, P>* leaf_node<T, I, N, P>::prev_leaf() const noexcept {
+    return prev_;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t N, typename P>
+inline void leaf_node<T, I, N, P>::link_after(leaf_node& left) noexcept {
+    prev_ = &left;
+    next_ = left.next_;
+    if (next_) {
+        next_->prev_ = this;
+    }
+
+    left.next_ = this;
+}
+
+// Links the chain that ends with this leaf to the chain that starts with `right`.
+template <typename T, template <typename, typename> class I, std::size_t N, typename P>
+inline void leaf_node<T, I, N, P>::join(leaf_node& right) noexcept {
+    next_ = &right;
+    right.prev_ = this;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t N, typename P>
+inline void leaf_node<T, I, N, P>::unlink() noexcept {
+    if (prev_) {
+        prev_->next_ = next_;
+    }
+
+    if (next_) {
+        next_->prev_ = prev_;
+    }
+
+    next_ = nullptr;
+    prev_ = nullptr;
+}
+
+template <typename T, template <typename, typename> class I, std::size_t N, typename P>
+void leaf_node<T, I, N, P>::split_into(leaf_node& right) {
+    auto& values = this->values();
+    auto mid = values.data() + (values.size() + 1) / 2;
+    auto last = values.data() + values.size();
+
+    auto& right_values = right.values();
+    right_values.insert(right_values.cend(),
+                        std::make_move_iterator(mid), std::make_move_iterator(last));
+    values.erase(values.cbegin() + (mid - values.data()), values.cend());
+    right.link_after(*this);
+}
+
+template <typename T, template <typename, typename> class I, std::size_t N, typename P>
+void leaf_node<T, I, N, P>::merge_from(leaf_node& right, key_type const&) {
+    auto& values = this->values();
+    auto& right_values = right.values();
+    values.insert(values.cend(),
+                  std::make_move_iterator(right_values.data()),
+                  std::make_move_iterator(right_values.data() + right_values.size()));
+    right_values.clear();
+    right.unlink();
+}
+
+template <typename T, template <typename, typename> class I, std::size_t N, typename P>
+void leaf_node<T, I, N, P>::borrow_from_left(leaf_node& left, key_type const&) {
+    auto& values = this->values();
+    auto& left_values = left.values();
+    values.emplace(values.cbegin(), std::move(left_values.back()));
+    left_values.pop_back();
+}
+
+template <typename T, template <typename, typename> class I, std::size_t N, typename P>
+void leaf_node<T, I, N, P>::borrow_from_right(leaf_node& right, key_type const&) {
+    auto& values = this->values();
+    auto& right_values = right.values();
+    values.emplace_back(std::move(right_values.front()));
+    right_values.erase(right_values.cbegin());
+}
+
+template <typename T, template <typename, typename> class I, std::size_t N, typename P>
+inline constexpr typename leaf_node<T, I, N, P>::size_type
+leaf_node<T, I, N, P>::min_size() noexcept {
+    return N / 2;
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_TREE_NODE_HPP_
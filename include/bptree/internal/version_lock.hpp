@@ -0,0 +1,134 @@
+/************************************************
+ *  version_lock.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_INTERNAL_VERSION_LOCK_HPP_
+#define BPTREE_INTERNAL_VERSION_LOCK_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <thread>
+
+namespace bptree {
+
+namespace internal {
+
+/************************************************
+ * Declaration: class version_lock
+ ************************************************/
+
+// Lock for optimistic lock coupling: writers lock exclusively, while readers take no lock at all
+// and instead validate, after reading the protected data, that the version they started from is
+// still current. Every write unlock bumps the version, and a node removed from the tree is marked
+// obsolete so that readers that still reach it restart.
+//
+// The version word holds the obsolete flag in bit 0, the lock flag in bit 1 and a counter above.
+class version_lock {
+ public:  // Public Type(s)
+    using version_type = std::uint64_t;
+
+ public:  // Public Method(s)
+    version_lock() noexcept;
+    version_lock(version_lock const&) = delete;
+
+    version_lock& operator=(version_lock const&) = delete;
+
+    bool read_lock(version_type& version) const noexcept;
+    bool validate(version_type version) const noexcept;
+    bool upgrade(version_type& version) noexcept;
+    bool write_lock() noexcept;
+    void write_unlock() noexcept;
+    void write_unlock_obsolete() noexcept;
+
+    bool locked() const noexcept;
+    bool obsolete() const noexcept;
+
+ public:  // Static Public Property(ies)
+    static constexpr version_type obsolete_bit = 0b01;
+    static constexpr version_type lock_bit = 0b10;
+
+ private:  // Private Property(ies)
+    std::atomic<version_type> version_;
+};
+
+/************************************************
+ * Implementation: class version_lock
+ ************************************************/
+
+inline version_lock::version_lock() noexcept
+  : version_(0) {
+    // do nothing
+}
+
+// Waits until no writer holds the lock and returns the version to validate against. Fails if the
+// node has been made obsolete.
+inline bool version_lock::read_lock(version_type& version) const noexcept {
+    std::size_t spins = 0;
+    version = version_.load(std::memory_order_acquire);
+    while (version & lock_bit) {
+        if (++spins % 64 == 0) {
+            std::this_thread::yield();
+        }
+
+        version = version_.load(std::memory_order_acquire);
+    }
+
+    return !(version & obsolete_bit);
+}
+
+// Whether nothing has been written since `version` was read. The data read before must not be
+// acted upon unless this succeeds.
+inline bool version_lock::validate(version_type version) const noexcept {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+}
+
+// Turns a read lock into a write lock, provided that nothing has been written in between.
+inline bool version_lock::upgrade(version_type& version) noexcept {
+    if (!version_.compare_exchange_strong(version, version + lock_bit,
+                                          std::memory_order_acquire)) {
+        return false;
+    }
+
+    version += lock_bit;
+    return true;
+}
+
+inline bool version_lock::write_lock() noexcept {
+    version_type version;
+    do {
+        if (!read_lock(version)) {
+            return false;
+        }
+    } while (!upgrade(version));
+
+    return true;
+}
+
+inline void version_lock::write_unlock() noexcept {
+    version_.fetch_add(lock_bit, std::memory_order_release);
+}
+
+inline void version_lock::write_unlock_obsolete() noexcept {
+    version_.fetch_add(lock_bit | obsolete_bit, std::memory_order_release);
+}
+
+inline bool version_lock::locked() const noexcept {
+    return version_.load(std::memory_order_relaxed) & lock_bit;
+}
+
+inline bool version_lock::obsolete() const noexcept {
+    return version_.load(std::memory_order_relaxed) & obsolete_bit;
+}
+
+}  // namespace internal
+
+}  // namespace bptree
+
+#endif  // BPTREE_INTERNAL_VERSION_LOCK_HPP_
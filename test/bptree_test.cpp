@@ -0,0 +1,776 @@
+/************************************************
+ *  bptree_test.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#include <cstddef>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <iterator>
+#include <map>
+#include <numeric>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <bptree/bptree.hpp>
+
+std::size_t constexpr leaf_size = 4;
+std::size_t constexpr inner_size = 4;
+std::size_t constexpr num_test_values = 2000;
+
+using test_map = bptree::map<int, int, std::less<int>, leaf_size, inner_size>;
+using test_multimap = bptree::multimap<int, int, std::less<int>, leaf_size, inner_size>;
+using test_set = bptree::set<int, std::less<int>, leaf_size, inner_size>;
+using test_multiset = bptree::multiset<int, std::less<int>, leaf_size, inner_size>;
+
+std::vector<int> shuffled_keys(std::size_t n, int max_key, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> dist(0, max_key);
+    std::vector<int> keys(n);
+    std::generate(keys.begin(), keys.end(), [&]() { return dist(gen); });
+    return keys;
+}
+
+template <typename Tree, typename Expected>
+void assert_tree_values(Tree const& tree, Expected const& expected) {
+    EXPECT_EQ(expected.size(), tree.size());
+    EXPECT_EQ(expected.empty(), tree.empty());
+    EXPECT_EQ(expected.size(), static_cast<std::size_t>(std::distance(tree.begin(), tree.end())));
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), tree.begin()));
+    EXPECT_TRUE(std::equal(expected.rbegin(), expected.rend(), tree.rbegin()));
+}
+
+TEST(BPTreeTest, NodeFanout) {
+    using value_type = std::pair<int const, int>;
+
+    EXPECT_EQ(28, bptree::leaf_fanout<value_type>(256));
+    EXPECT_EQ(508, bptree::leaf_fanout<value_type>(4096));
+    EXPECT_EQ(15, bptree::inner_fanout<int>(256));
+    EXPECT_EQ(255, bptree::inner_fanout<int>(4096));
+
+    // nodes too small for their values still get the minimum fanout
+    using large_type = std::array<char, 1024>;
+    EXPECT_EQ(2, bptree::leaf_fanout<large_type>(256));
+    EXPECT_EQ(4, bptree::inner_fanout<large_type>(256));
+
+    using default_map = bptree::map<int, int>;
+    EXPECT_EQ(bptree::leaf_fanout<value_type>(bptree::default_node_size),
+              default_map::leaf_capacity());
+    EXPECT_EQ(bptree::inner_fanout<int>(bptree::default_node_size),
+              default_map::inner_capacity());
+
+    // the nodes themselves, headers and leaf links included, fit in the target size
+    using default_inner = bptree::internal::inner_node<
+        int, std::less<int>, default_map::inner_capacity(), false
+    >;
+    using default_leaf = bptree::internal::leaf_node<
+        bptree::internal::map_traits<int, int>, bptree::internal::deny_duplicates,
+        default_map::leaf_capacity(), default_inner
+    >;
+    EXPECT_LE(sizeof(default_leaf), bptree::default_node_size);
+    EXPECT_LE(sizeof(default_inner), bptree::default_node_size);
+}
+
+TEST(BPTreeTest, PageSizedNodes) {
+    std::size_t constexpr page_size = 4096;
+    using page_map = bptree::map<
+        int, int, std::less<int>,
+        bptree::leaf_fanout<std::pair<int const, int>>(page_size),
+        bptree::inner_fanout<int>(page_size)
+    >;
+
+    page_map map;
+    std::map<int, int> expected;
+    for (auto key : shuffled_keys(num_test_values, num_test_values, 10)) {
+        map.emplace(key, key);
+        expected.emplace(key, key);
+    }
+
+    assert_tree_values(map, expected);
+    EXPECT_EQ(2, map.height());
+}
+
+TEST(BPTreeTest, EmptyTree) {
+    test_map map;
+
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(0, map.size());
+    EXPECT_EQ(0, map.height());
+    EXPECT_EQ(map.begin(), map.end());
+    EXPECT_EQ(map.end(), map.find(0));
+    EXPECT_EQ(map.end(), map.lower_bound(0));
+    EXPECT_EQ(map.end(), map.upper_bound(0));
+    EXPECT_EQ(0, map.count(0));
+    EXPECT_EQ(0, map.erase(0));
+}
+
+TEST(BPTreeTest, InsertIntoMap) {
+    test_map map;
+    std::map<int, int> expected;
+    for (auto key : shuffled_keys(num_test_values, num_test_values / 2, 1)) {
+        auto result = map.insert({key, -key});
+        auto expected_result = expected.insert({key, -key});
+
+        EXPECT_EQ(expected_result.second, result.second);
+        EXPECT_EQ(*expected_result.first, *result.first);
+    }
+
+    assert_tree_values(map, expected);
+    EXPECT_GT(map.height(), 2);
+}
+
+TEST(BPTreeTest, InsertIntoMultiMap) {
+    test_multimap map;
+    std::multimap<int, int> expected;
+    int count = 0;
+    for (auto key : shuffled_keys(num_test_values, 50, 2)) {
+        auto it = map.emplace(key, count);
+        expected.emplace(key, count);
+        ++count;
+
+        EXPECT_EQ(key, it->first);
+        EXPECT_EQ(count - 1, it->second);
+    }
+
+    assert_tree_values(map, expected);
+}
+
+TEST(BPTreeTest, InsertIntoSetAndMultiSet) {
+    auto keys = shuffled_keys(num_test_values, 100, 3);
+
+    test_set set(keys.begin(), keys.end());
+    assert_tree_values(set, std::set<int>(keys.begin(), keys.end()));
+
+    test_multiset multiset(keys.begin(), keys.end());
+    assert_tree_values(multiset, std::multiset<int>(keys.begin(), keys.end()));
+}
+
+TEST(BPTreeTest, LookupInMultiMap) {
+    auto keys = shuffled_keys(num_test_values, 200, 4);
+
+    test_multiset set(keys.begin(), keys.end());
+    std::multiset<int> expected(keys.begin(), keys.end());
+    for (int key = -1; key <= 201; ++key) {
+        std::ostringstream ss;
+        ss << "key = " << key;
+        SCOPED_TRACE(ss.str());
+
+        EXPECT_EQ(expected.count(key), set.count(key));
+        EXPECT_EQ(std::distance(expected.begin(), expected.lower_bound(key)),
+                  std::distance(set.begin(), set.lower_bound(key)));
+        EXPECT_EQ(std::distance(expected.begin(), expected.upper_bound(key)),
+                  std::distance(set.begin(), set.upper_bound(key)));
+        EXPECT_EQ(expected.find(key) == expected.end(), set.find(key) == set.end());
+    }
+}
+
+TEST(BPTreeTest, EraseFromMap) {
+    auto keys = shuffled_keys(num_test_values, num_test_values, 5);
+
+    test_map map;
+    std::map<int, int> expected;
+    for (auto key : keys) {
+        map[key] = key;
+        expected[key] = key;
+    }
+
+    for (auto key : shuffled_keys(num_test_values, num_test_values, 6)) {
+        EXPECT_EQ(expected.erase(key), map.erase(key));
+    }
+
+    assert_tree_values(map, expected);
+
+    for (auto key : keys) {
+        map.erase(key);
+    }
+
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(0, map.height());
+    EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(BPTreeTest, EraseFromMultiMap) {
+    auto keys = shuffled_keys(num_test_values, 100, 7);
+
+    test_multiset set(keys.begin(), keys.end());
+    std::multiset<int> expected(keys.begin(), keys.end());
+    for (int key = 0; key <= 100; key += 3) {
+        EXPECT_EQ(expected.erase(key), set.erase(key));
+    }
+
+    assert_tree_values(set, expected);
+}
+
+TEST(BPTreeTest, EraseWithIterator) {
+    auto keys = shuffled_keys(num_test_values, num_test_values, 8);
+
+    test_set set(keys.begin(), keys.end());
+    std::set<int> expected(keys.begin(), keys.end());
+
+    // erase every other value while iterating
+    auto it = set.begin();
+    auto expected_it = expected.begin();
+    while (it != set.end()) {
+        it = set.erase(it);
+        expected_it = expected.erase(expected_it);
+        if (it != set.end()) {
+            EXPECT_EQ(*expected_it, *it);
+            ++it;
+            ++expected_it;
+        }
+    }
+
+    assert_tree_values(set, expected);
+
+    // erase a range in the middle
+    auto first = std::next(set.begin(), set.size() / 4);
+    auto last = std::next(first, set.size() / 2);
+    auto expected_first = std::next(expected.begin(), expected.size() / 4);
+    auto expected_last = std::next(expected_first, expected.size() / 2);
+    it = set.erase(first, last);
+    expected_it = expected.erase(expected_first, expected_last);
+
+    EXPECT_EQ(*expected_it, *it);
+    assert_tree_values(set, expected);
+}
+
+TEST(BPTreeTest, AccessMapWithIndex) {
+    test_map map;
+    for (int key = 0; key < 100; ++key) {
+        map[key] = key * 2;
+    }
+
+    for (int key = 0; key < 100; ++key) {
+        EXPECT_EQ(key * 2, map.at(key));
+        EXPECT_EQ(key * 2, map[key]);
+    }
+
+    EXPECT_THROW(map.at(-1), std::out_of_range);
+    EXPECT_EQ(0, map[100]);
+    EXPECT_EQ(101, map.size());
+}
+
+TEST(BPTreeTest, TryEmplaceAndInsertOrAssign) {
+    bptree::map<int, std::string> map;
+    for (int key = 0; key < 1000; key += 2) {
+        EXPECT_TRUE(map.try_emplace(key, 3, 'x').second);
+    }
+
+    std::string value = "moved";
+    for (int key = 0; key < 1000; key += 2) {
+        auto result = map.try_emplace(key, std::move(value));
+        EXPECT_FALSE(result.second);
+        EXPECT_EQ("xxx", result.first->second);
+    }
+
+    EXPECT_EQ("moved", value);
+    EXPECT_TRUE(map.try_emplace(1, std::move(value)).second);
+    EXPECT_EQ("moved", map.at(1));
+
+    EXPECT_FALSE(map.insert_or_assign(2, "y").second);
+    EXPECT_EQ("y", map.at(2));
+    EXPECT_TRUE(map.insert_or_assign(3, "z").second);
+    EXPECT_EQ("z", map.at(3));
+    EXPECT_EQ(502u, map.size());
+
+    // keys in random order are constructed in place through leaf splits, and end up in order
+    std::vector<int> keys(num_test_values);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+
+    test_map small;
+    bptree::ranked_map<int, int, std::less<int>, leaf_size, inner_size> ranked;
+    for (auto key : keys) {
+        auto result = small.try_emplace(key, -key);
+        EXPECT_TRUE(result.second);
+        EXPECT_EQ(key, result.first->first);
+        EXPECT_TRUE(ranked.try_emplace(key, -key).second);
+        EXPECT_FALSE(small.try_emplace(key, 0).second);
+    }
+
+    int expected = 0;
+    for (auto const& value : small) {
+        EXPECT_EQ(expected, value.first);
+        EXPECT_EQ(-expected, value.second);
+        ++expected;
+    }
+
+    EXPECT_EQ(static_cast<int>(num_test_values), expected);
+    for (std::size_t k = 0; k < num_test_values; k += 97) {
+        EXPECT_EQ(static_cast<int>(k), ranked.nth(k)->first);
+    }
+}
+
+TEST(BPTreeTest, TransparentKeys) {
+    bptree::map<std::string, int, std::less<>> map;
+    for (int key = 0; key < 100; ++key) {
+        map[std::to_string(key).c_str()] = key;
+    }
+
+    EXPECT_EQ(100u, map.size());
+    EXPECT_EQ(42, map.at("42"));
+    EXPECT_THROW(map.at("100"), std::out_of_range);
+
+    map.at("42") = -1;
+    EXPECT_EQ(-1, map["42"]);
+    EXPECT_FALSE(map.try_emplace("42", 0).second);
+    EXPECT_EQ(1u, map.erase("42"));
+    EXPECT_EQ(0u, map.erase("42"));
+    EXPECT_EQ(99u, map.size());
+    EXPECT_EQ("1", map.erase(map.cbegin())->first);
+}
+
+TEST(BPTreeTest, CopyAndMove) {
+    auto keys = shuffled_keys(num_test_values, num_test_values, 9);
+    test_multiset set(keys.begin(), keys.end());
+    std::multiset<int> expected(keys.begin(), keys.end());
+
+    test_multiset copied(set);
+    assert_tree_values(copied, expected);
+    EXPECT_TRUE(copied == set);
+
+    copied.erase(copied.begin());
+    EXPECT_FALSE(copied == set);
+    EXPECT_TRUE(set < copied);
+    assert_tree_values(set, expected);
+
+    test_multiset moved(std::move(set));
+    assert_tree_values(moved, expected);
+    EXPECT_TRUE(set.empty());
+
+    set = moved;
+    assert_tree_values(set, expected);
+
+    copied = std::move(moved);
+    assert_tree_values(copied, expected);
+
+    copied.clear();
+    EXPECT_TRUE(copied.empty());
+    EXPECT_EQ(copied.begin(), copied.end());
+}
+
+TEST(BPTreeTest, CopyAndMoveMap) {
+    test_map map;
+    std::map<int, int> expected;
+    for (auto key : shuffled_keys(num_test_values, num_test_values, 9)) {
+        map.emplace(key, key * 2);
+        expected.emplace(key, key * 2);
+    }
+
+    test_map copied(map);
+    assert_tree_values(copied, expected);
+    assert_tree_values(map, expected);
+
+    test_map moved(std::move(copied));
+    assert_tree_values(moved, expected);
+    EXPECT_TRUE(copied.empty());
+}
+
+TEST(BPTreeTest, PoolAllocatedMap) {
+    using pool_map = bptree::map<
+        int, int, std::less<int>, leaf_size, inner_size,
+        bptree::pool_allocator<std::pair<int const, int>>
+    >;
+
+    pool_map map;
+    std::map<int, int> expected;
+    for (auto key : shuffled_keys(num_test_values, num_test_values / 2, 11)) {
+        map.emplace(key, key);
+        expected.emplace(key, key);
+    }
+
+    for (auto key : shuffled_keys(num_test_values, num_test_values / 2, 12)) {
+        EXPECT_EQ(expected.erase(key), map.erase(key));
+    }
+
+    assert_tree_values(map, expected);
+
+    pool_map copied(map);
+    EXPECT_TRUE(copied.get_allocator() != map.get_allocator());
+    assert_tree_values(copied, expected);
+
+    // clearing a tree releases the whole pool, but leaves the copy untouched
+    map.clear();
+    assert_tree_values(map, std::map<int, int>());
+    assert_tree_values(copied, expected);
+
+    static_assert(std::is_nothrow_move_constructible<pool_map>::value,
+                  "moving a tree must not allocate a pool for the moved-from tree");
+    map = std::move(copied);
+    assert_tree_values(map, expected);
+
+    // a moved-from tree gets a pool of its own once it needs one
+    copied.emplace(1, 1);
+    EXPECT_TRUE(copied.get_allocator() != map.get_allocator());
+    copied.clear();
+    assert_tree_values(map, expected);
+
+    for (auto key : shuffled_keys(num_test_values, num_test_values / 2, 13)) {
+        map.emplace(key, key);
+        expected.emplace(key, key);
+    }
+
+    assert_tree_values(map, expected);
+}
+
+TEST(BPTreeTest, PoolAllocatedStrings) {
+    using pool_set = bptree::set<
+        std::string, std::less<std::string>, leaf_size, inner_size,
+        bptree::pool_allocator<std::string>
+    >;
+
+    pool_set set;
+    std::set<std::string> expected;
+    for (auto key : shuffled_keys(num_test_values, num_test_values, 14)) {
+        // long enough to be allocated on the heap
+        auto value = std::string(32, 'x') + std::to_string(key);
+        set.insert(value);
+        expected.insert(value);
+    }
+
+    assert_tree_values(set, expected);
+    set.clear();
+    EXPECT_TRUE(set.empty());
+
+    set.insert(expected.begin(), expected.end());
+    assert_tree_values(set, expected);
+}
+
+TEST(BPTreeTest, BulkLoadSortedValues) {
+    for (std::size_t n : {0, 1, 3, 5, 17, 100, 2000}) {
+        for (double fill_factor : {0.0, 0.5, 0.7, 1.0}) {
+            std::ostringstream ss;
+            ss << "n = " << n << "\tfill factor = " << fill_factor;
+            SCOPED_TRACE(ss.str());
+
+            std::map<int, int> expected;
+            for (int key = 0; key < static_cast<int>(n); ++key) {
+                expected.emplace(key * 2, key);
+            }
+
+            test_map map;
+            map.bulk_load(expected.begin(), expected.end(), fill_factor);
+            assert_tree_values(map, expected);
+
+            // the loaded tree must keep working as an ordinary one
+            for (int key = -1; key <= static_cast<int>(n) * 2; key += 3) {
+                EXPECT_EQ(expected.count(key), map.count(key));
+                map[key] = -key;
+                expected[key] = -key;
+            }
+
+            assert_tree_values(map, expected);
+
+            for (auto key : shuffled_keys(n, static_cast<int>(n) * 2, 11)) {
+                EXPECT_EQ(expected.erase(key), map.erase(key));
+            }
+
+            assert_tree_values(map, expected);
+        }
+    }
+}
+
+TEST(BPTreeTest, BulkLoadHeight) {
+    std::vector<int> keys(num_test_values);
+    std::iota(keys.begin(), keys.end(), 0);
+
+    // 2000 values in leaves of 4 and inner nodes of 4: 500 -> 125 -> 32 -> 8 -> 2 -> 1 nodes
+    test_set set(bptree::sorted_input, keys.begin(), keys.end());
+    assert_tree_values(set, keys);
+    EXPECT_EQ(6, set.height());
+
+    // half-filled nodes need one more level
+    set.bulk_load(keys.begin(), keys.end(), 0.5);
+    assert_tree_values(set, keys);
+    EXPECT_EQ(10, set.height());
+}
+
+TEST(BPTreeTest, BulkLoadWithDuplicates) {
+    std::vector<std::pair<int, int>> values;
+    for (int i = 0; i < static_cast<int>(num_test_values); ++i) {
+        values.emplace_back(i / 3, i);
+    }
+
+    // sorted ranges passed to the range constructor are bulk-loaded as well
+    test_map map(values.begin(), values.end());
+    test_multimap multimap(values.begin(), values.end());
+
+    std::map<int, int> expected_map(values.begin(), values.end());
+    std::multimap<int, int> expected_multimap(values.begin(), values.end());
+    assert_tree_values(map, expected_map);
+    assert_tree_values(multimap, expected_multimap);
+}
+
+TEST(BPTreeTest, BuildParallel) {
+    // enough values for every thread to sort and fill a chunk of its own
+    auto keys = shuffled_keys(100000, 40000, 17);
+    std::vector<std::pair<int, int>> values;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        values.emplace_back(keys[i], static_cast<int>(i));
+    }
+
+    // the first of equivalent values wins, as with `insert`
+    std::map<int, int> expected_map;
+    std::multimap<int, int> expected_multimap;
+    for (auto const& value : values) {
+        expected_map.insert(value);
+        expected_multimap.insert(value);
+    }
+
+    for (std::size_t threads : {1, 3, 4, 16}) {
+        auto input = values;
+        auto map = bptree::build_parallel<test_map>(input.begin(), input.end(), threads);
+        assert_tree_values(map, expected_map);
+        EXPECT_TRUE(std::is_sorted(input.begin(), input.end()));
+
+        input = values;
+        auto multimap = bptree::build_parallel<test_multimap>(input.begin(), input.end(),
+                                                              threads);
+        assert_tree_values(multimap, expected_multimap);
+
+        // the built tree must keep working as an ordinary one
+        for (auto key : shuffled_keys(5000, 40000, 19)) {
+            EXPECT_EQ(expected_map.count(key), map.erase(key));
+            expected_map.erase(key);
+        }
+
+        assert_tree_values(map, expected_map);
+        expected_map.clear();
+        for (auto const& value : values) {
+            expected_map.insert(value);
+        }
+    }
+
+    // small inputs, and underfull leaves at the seams of the chunks
+    for (std::size_t n : {0, 1, 5, 1000, 2049}) {
+        std::vector<int> input(n);
+        std::iota(input.rbegin(), input.rend(), 0);
+        test_set set;
+        set.bulk_load_parallel(input.begin(), input.end(), 4, 0.3);
+        assert_tree_values(set, std::set<int>(input.begin(), input.end()));
+    }
+}
+
+TEST(BPTreeTest, RangeOfLeafSpans) {
+    test_multimap map;
+    std::multimap<int, int> expected;
+    for (auto key : shuffled_keys(num_test_values, num_test_values / 2, 13)) {
+        map.emplace(key, key * 2);
+        expected.emplace(key, key * 2);
+    }
+
+    auto check_range = [&](int lo, int hi) {
+        std::vector<std::pair<int, int>> values;
+        for (auto span : map.range(lo, hi)) {
+            EXPECT_FALSE(span.empty());
+            EXPECT_LE(span.size(), leaf_size);
+            for (auto& value : span) {
+                values.emplace_back(value);
+            }
+        }
+
+        auto first = expected.lower_bound(lo);
+        auto last = lo < hi ? expected.lower_bound(hi) : first;
+        EXPECT_EQ((std::vector<std::pair<int, int>>(first, last)), values);
+    };
+
+    check_range(100, 500);
+    check_range(0, static_cast<int>(num_test_values));
+    check_range(-10, 0);
+    check_range(300, 300);
+    check_range(500, 100);
+    check_range(950, 2000);
+
+    // spans of a mutable range may be written through
+    for (auto span : map.range(0, 100)) {
+        for (auto& value : span) {
+            value.second = -1;
+        }
+    }
+
+    test_multimap const& const_map = map;
+    for (auto span : const_map.range(0, 100)) {
+        for (auto const& value : span) {
+            EXPECT_EQ(-1, value.second);
+        }
+    }
+
+    test_map empty;
+    auto range = empty.range(0, 100);
+    EXPECT_TRUE(range.empty());
+    EXPECT_EQ(range.begin(), range.end());
+}
+
+// end() is kept on the last leaf as it is split, merged into its left sibling, and merged with
+// its right sibling into the leaf before it.
+TEST(BPTreeTest, EndFollowsLastLeaf) {
+    test_set set;
+    std::set<int> expected;
+    auto check_end = [&]() {
+        ASSERT_EQ(expected.size(), set.size());
+        if (expected.empty()) {
+            EXPECT_EQ(set.begin(), set.end());
+            return;
+        }
+
+        EXPECT_EQ(*expected.rbegin(), *std::prev(set.end()));
+        EXPECT_EQ(set.end(), std::next(set.find(*expected.rbegin())));
+        EXPECT_EQ(set.cend(), std::next(set.cbegin(), set.size()));
+    };
+
+    for (int key = 0; key < 200; ++key) {
+        set.insert(key);
+        expected.insert(key);
+        check_end();
+    }
+
+    for (int key = 199; key >= 100; --key) {
+        EXPECT_EQ(expected.erase(key), set.erase(key));
+        check_end();
+    }
+
+    for (int key = 0; key < 100; ++key) {
+        EXPECT_EQ(expected.erase(key), set.erase(key));
+        check_end();
+    }
+
+    for (int key = 0; key < 50; ++key) {
+        expected.insert(key);
+    }
+
+    set.bulk_load(expected.begin(), expected.end());
+    check_end();
+}
+
+TEST(BPTreeTest, ForEachSpan) {
+    test_map map;
+    std::map<int, int> expected;
+    for (auto key : shuffled_keys(num_test_values, num_test_values, 17)) {
+        map.emplace(key, key * 3);
+        expected.emplace(key, key * 3);
+    }
+
+    auto sum_spans = [&](int lo, int hi) {
+        long sum = 0;
+        map.for_each_span(lo, hi, [&](std::pair<int const, int> const* data, std::size_t size) {
+            EXPECT_GT(size, 0u);
+            for (std::size_t i = 0; i < size; ++i) {
+                sum += data[i].second;
+            }
+        });
+
+        return sum;
+    };
+
+    auto sum_expected = [&](int lo, int hi) {
+        long sum = 0;
+        for (auto it = expected.lower_bound(lo); it != expected.end() && it->first < hi; ++it) {
+            sum += it->second;
+        }
+
+        return sum;
+    };
+
+    EXPECT_EQ(sum_expected(0, 500), sum_spans(0, 500));
+    EXPECT_EQ(sum_expected(123, 1789), sum_spans(123, 1789));
+    EXPECT_EQ(0, sum_spans(700, 700));
+    EXPECT_EQ(0, sum_spans(900, 100));
+
+    std::size_t count = 0;
+    map.for_each_span([&](std::pair<int const, int> const*, std::size_t size) { count += size; });
+    EXPECT_EQ(map.size(), count);
+}
+
+TEST(BPTreeTest, ParallelForEachAndReduce) {
+    test_map map;
+    std::map<int, int> expected;
+    for (auto key : shuffled_keys(num_test_values * 10, num_test_values * 20, 23)) {
+        map.emplace(key, key % 7);
+        expected.emplace(key, key % 7);
+    }
+
+    auto add = [](long x, long y) { return x + y; };
+    auto add_value = [](long acc, std::pair<int const, int> const& value) {
+        return acc + value.second;
+    };
+
+    for (std::size_t threads : {1, 2, 5}) {
+        for (auto bounds : {std::make_pair(0, 40000), std::make_pair(123, 17890),
+                            std::make_pair(5000, 5001), std::make_pair(900, 100)}) {
+            auto lo = bounds.first;
+            auto hi = bounds.second;
+            long sum = 0;
+            for (auto it = expected.lower_bound(lo); it != expected.end() && it->first < hi;
+                    ++it) {
+                sum += it->second;
+            }
+
+            EXPECT_EQ(sum, map.parallel_reduce(lo, hi, 0L, add_value, add, threads));
+
+            std::atomic<long> count(0);
+            map.parallel_for_each(lo, hi, [&](std::pair<int const, int> const& value) {
+                EXPECT_LE(lo, value.first);
+                EXPECT_GT(hi, value.first);
+                ++count;
+            }, threads);
+            EXPECT_EQ(lo < hi ? std::distance(expected.lower_bound(lo), expected.lower_bound(hi))
+                              : 0, count);
+        }
+
+        // the results are combined in key order
+        auto keys = map.parallel_reduce(
+            std::vector<int>(),
+            [](std::vector<int> acc, std::pair<int const, int> const& value) {
+                acc.push_back(value.first);
+                return acc;
+            },
+            [](std::vector<int> x, std::vector<int> const& y) {
+                x.insert(x.end(), y.begin(), y.end());
+                return x;
+            },
+            threads);
+        EXPECT_TRUE(std::equal(keys.begin(), keys.end(), expected.begin(), expected.end(),
+                               [](int key, std::pair<int const, int> const& value) {
+                                   return key == value.first;
+                               }));
+    }
+
+    test_map empty;
+    EXPECT_EQ(0L, empty.parallel_reduce(0L, add_value, add));
+    empty.parallel_for_each([](std::pair<int const, int> const&) { FAIL(); });
+}
+
+TEST(BPTreeTest, FindMany) {
+    test_map map;
+    for (auto key : shuffled_keys(num_test_values, num_test_values, 19)) {
+        map.emplace(key, key * 5);
+    }
+
+    // more keys than fit in a group, so that the last group is partial
+    auto keys = shuffled_keys(101, num_test_values + 100, 23);
+    std::vector<test_map::const_iterator> found;
+    map.find_many(keys.begin(), keys.end(), std::back_inserter(found));
+    ASSERT_EQ(keys.size(), found.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        EXPECT_EQ(static_cast<test_map const&>(map).find(keys[i]), found[i]);
+    }
+
+    test_set empty;
+    std::vector<test_set::const_iterator> none;
+    empty.find_many(keys.begin(), keys.end(), std::back_inserter(none));
+    EXPECT_EQ(keys.size(), static_cast<std::size_t>(std::count(none.begin(), none.end(),
+                                                               empty.cend())));
+}
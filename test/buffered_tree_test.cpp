@@ -0,0 +1,135 @@
+/************************************************
+ *  buffered_tree_test.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#include <cstddef>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <bptree/bptree.hpp>
+
+#include "./map_test_util.hpp"
+
+// Small nodes and buffers, so that the trees below flush and split often.
+using small_map = bptree::buffered_map<int, int, std::less<int>, 4, 4, 3>;
+using small_set = bptree::buffered_set<int, std::less<int>, 4, 4, 3>;
+
+TEST(BufferedTreeTest, MatchStdMap) {
+    small_map map;
+    std::map<int, int> expected;
+
+    random_writes(42, 500, random_write_count, [&](int i, int key, bool erase) {
+        if (erase) {
+            expected.erase(key);
+            map.erase(key);
+        } else {
+            expected.emplace(key, i);
+            map.insert({key, i});
+        }
+
+        // lookups are compared before flushing, since that is when the buffers have to be
+        // merged in
+        if (i % 1000 == 999) {
+            expect_same_lookups(map, expected, 500);
+        }
+    });
+
+    EXPECT_LT(0u, map.pending());
+    EXPECT_LT(2u, map.height());
+    expect_same_contents(map, expected, 500);
+    EXPECT_EQ(0u, map.pending());
+}
+
+// Writes to the same key pile up in a single buffer, where they have to be combined in order.
+TEST(BufferedTreeTest, CombineWritesToSameKey) {
+    small_map map;
+    for (int key = 0; key < 100; ++key) {
+        map.insert({key, key});
+    }
+
+    map.flush();
+    map.insert({7, -1});
+    EXPECT_TRUE(map.find(7, [](std::pair<int const, int> const& v) { EXPECT_EQ(7, v.second); }));
+
+    map.erase(7);
+    EXPECT_FALSE(map.contains(7));
+
+    map.insert({7, -2});
+    map.insert({7, -3});
+    EXPECT_TRUE(map.find(7, [](std::pair<int const, int> const& v) { EXPECT_EQ(-2, v.second); }));
+
+    map.insert({200, 1});
+    map.insert({200, 2});
+    map.erase(200);
+    map.erase(201);
+    EXPECT_FALSE(map.contains(200));
+
+    EXPECT_EQ(100u, map.size());
+    EXPECT_TRUE(map.find(7, [](std::pair<int const, int> const& v) { EXPECT_EQ(-2, v.second); }));
+    EXPECT_FALSE(map.contains(200));
+}
+
+TEST(BufferedTreeTest, SequentialSet) {
+    small_set set;
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(1u, set.height());
+
+    for (int key = 0; key < 5000; ++key) {
+        set.insert(key);
+    }
+
+    for (int key = 0; key < 5000; key += 2) {
+        set.erase(key);
+    }
+
+    for (int key = 0; key < 5000; ++key) {
+        EXPECT_EQ(key % 2 != 0, set.contains(key));
+    }
+
+    EXPECT_EQ(2500u, set.size());
+    int expected = 1;
+    set.for_each([&](int key) {
+        EXPECT_EQ(expected, key);
+        expected += 2;
+    });
+
+    EXPECT_EQ(5001, expected);
+}
+
+TEST(BufferedTreeTest, NonTrivialValues) {
+    bptree::buffered_map<std::string, std::string, std::less<std::string>, 4, 4, 3> map;
+    for (int i = 0; i < 300; ++i) {
+        map.insert({std::to_string(i), std::string(i % 50, 'x')});
+        if (i % 4 == 0) {
+            map.erase(std::to_string(i / 2));
+        }
+    }
+
+    std::map<std::string, std::string> expected;
+    for (int i = 0; i < 300; ++i) {
+        expected.emplace(std::to_string(i), std::string(i % 50, 'x'));
+        if (i % 4 == 0) {
+            expected.erase(std::to_string(i / 2));
+        }
+    }
+
+    for (auto const& value : expected) {
+        std::string found;
+        EXPECT_TRUE(map.find(value.first, [&](std::pair<std::string const, std::string> const& v) {
+            found = v.second;
+        }));
+        EXPECT_EQ(value.second, found);
+    }
+
+    EXPECT_EQ(expected.size(), map.size());
+}
@@ -0,0 +1,224 @@
+/************************************************
+ *  concurrent_tree_test.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#include <cstddef>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <bptree/bptree.hpp>
+
+#include "./map_test_util.hpp"
+
+// Small nodes, so that the trees below split often and grow a few levels deep.
+using small_map = bptree::concurrent_map<int, int, std::less<int>, 4, 4>;
+using small_set = bptree::concurrent_set<int, std::less<int>, 4, 4>;
+
+TEST(ConcurrentTreeTest, MatchStdMap) {
+    small_map map;
+    std::map<int, int> expected;
+    random_writes(42, 1000, random_write_count, [&](int i, int key, bool erase) {
+        expect_same_write(map, expected, key, i, erase);
+    });
+
+    EXPECT_EQ(expected.size(), map.size());
+    expect_same_lookups(map, expected, 1000);
+}
+
+TEST(ConcurrentTreeTest, DisjointInserts) {
+    constexpr int thread_count = 8;
+    constexpr int per_thread = 5000;
+
+    small_set set;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&set, t] {
+            for (int i = 0; i < per_thread; ++i) {
+                EXPECT_TRUE(set.insert(i * thread_count + t));
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(static_cast<std::size_t>(thread_count * per_thread), set.size());
+    for (int key = 0; key < thread_count * per_thread; ++key) {
+        EXPECT_TRUE(set.contains(key));
+    }
+}
+
+TEST(ConcurrentTreeTest, OverlappingInsertsCountOnce) {
+    constexpr int thread_count = 8;
+    constexpr int key_count = 10000;
+
+    small_set set;
+    std::atomic<int> inserted(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&set, &inserted, t] {
+            std::vector<int> keys(key_count);
+            std::iota(keys.begin(), keys.end(), 0);
+            std::shuffle(keys.begin(), keys.end(), std::mt19937(t));
+            for (auto key : keys) {
+                if (set.insert(key)) {
+                    ++inserted;
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(key_count, inserted.load());
+    EXPECT_EQ(static_cast<std::size_t>(key_count), set.size());
+}
+
+// Writers insert and erase their own keys while readers look up keys that never change, so every
+// lookup has a definite expected answer.
+TEST(ConcurrentTreeTest, ReadWhileWriting) {
+    constexpr int writer_count = 4;
+    constexpr int reader_count = 4;
+    constexpr int stable_count = 2000;
+    constexpr int per_writer = 5000;
+
+    small_map map;
+    for (int key = 0; key < stable_count; ++key) {
+        map.insert({key * 2, key});
+    }
+
+    std::atomic<bool> done(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < writer_count; ++t) {
+        threads.emplace_back([&map, t] {
+            for (int i = 0; i < per_writer; ++i) {
+                auto key = (i * writer_count + t) * 2 + 1;
+                EXPECT_TRUE(map.insert({key, -key}));
+                if (i % 2 == 0) {
+                    EXPECT_EQ(1u, map.erase(key));
+                }
+            }
+        });
+    }
+
+    for (int t = 0; t < reader_count; ++t) {
+        threads.emplace_back([&map, &done, t] {
+            std::mt19937 gen(t);
+            std::uniform_int_distribution<int> dist(0, stable_count - 1);
+            while (!done.load()) {
+                auto key = dist(gen);
+                int value = -1;
+                EXPECT_TRUE(map.find(key * 2, [&](std::pair<int const, int> const& v) {
+                    value = v.second;
+                }));
+                EXPECT_EQ(key, value);
+
+                // every writer has at most one insert that it has not erased yet
+                auto size = map.size();
+                EXPECT_LE(static_cast<std::size_t>(stable_count), size);
+                EXPECT_GE(static_cast<std::size_t>(stable_count + writer_count * per_writer / 2 +
+                                                   writer_count), size);
+            }
+        });
+    }
+
+    for (int t = 0; t < writer_count; ++t) {
+        threads[t].join();
+    }
+
+    done = true;
+    for (int t = writer_count; t < writer_count + reader_count; ++t) {
+        threads[t].join();
+    }
+
+    EXPECT_EQ(static_cast<std::size_t>(stable_count + writer_count * per_writer / 2), map.size());
+    for (int t = 0; t < writer_count; ++t) {
+        for (int i = 0; i < per_writer; ++i) {
+            auto key = (i * writer_count + t) * 2 + 1;
+            EXPECT_EQ(i % 2 != 0, map.contains(key));
+        }
+    }
+}
+
+// Writers fill and then empty whole blocks of keys, so that leaves keep being emptied, unlinked and
+// retired, while readers look up keys that never change.
+TEST(ConcurrentTreeTest, ReadWhileLeavesEmpty) {
+    constexpr int writer_count = 4;
+    constexpr int reader_count = 4;
+    constexpr int stable_count = 1000;
+    constexpr int block_size = 200;
+    constexpr int rounds = 50;
+
+    small_map map;
+    for (int key = 0; key < stable_count; ++key) {
+        map.insert({key, key});
+    }
+
+    std::atomic<bool> done(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < writer_count; ++t) {
+        threads.emplace_back([&map, t] {
+            auto first = stable_count + t * block_size;
+            for (int round = 0; round < rounds; ++round) {
+                for (int key = first; key < first + block_size; ++key) {
+                    EXPECT_TRUE(map.insert({key, -key}));
+                }
+
+                for (int key = first; key < first + block_size; ++key) {
+                    EXPECT_EQ(1u, map.erase(key));
+                }
+            }
+        });
+    }
+
+    for (int t = 0; t < reader_count; ++t) {
+        threads.emplace_back([&map, &done, t] {
+            std::mt19937 gen(t);
+            std::uniform_int_distribution<int> dist(0, stable_count + writer_count * block_size);
+            while (!done.load()) {
+                auto key = dist(gen);
+                int value = -1;
+                auto found = map.find(key, [&](std::pair<int const, int> const& v) {
+                    value = v.second;
+                });
+
+                if (key < stable_count) {
+                    EXPECT_TRUE(found);
+                    EXPECT_EQ(key, value);
+                } else if (found) {
+                    EXPECT_EQ(-key, value);
+                }
+            }
+        });
+    }
+
+    for (int t = 0; t < writer_count; ++t) {
+        threads[t].join();
+    }
+
+    done = true;
+    for (int t = writer_count; t < writer_count + reader_count; ++t) {
+        threads[t].join();
+    }
+
+    EXPECT_EQ(static_cast<std::size_t>(stable_count), map.size());
+    for (int key = 0; key < stable_count + writer_count * block_size; ++key) {
+        EXPECT_EQ(key < stable_count, map.contains(key));
+    }
+}
@@ -0,0 +1,107 @@
+/************************************************
+ *  epoch_test.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#include <cstddef>
+
+#include <atomic>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <bptree/internal/epoch.hpp>
+
+using bptree::internal::epoch_domain;
+using bptree::internal::epoch_guard;
+
+namespace {
+
+std::atomic<int> freed(0);
+
+void free_int(void* ptr) noexcept {
+    delete static_cast<int*>(ptr);
+    ++freed;
+}
+
+// Retires one int from inside a critical section, and collects a few times.
+void retire_int() {
+    epoch_guard guard;
+    epoch_domain::instance().retire(new int(0), &free_int);
+}
+
+void collect(int times) {
+    for (int i = 0; i < times; ++i) {
+        epoch_domain::instance().collect();
+    }
+}
+
+}  // namespace
+
+TEST(EpochTest, RetiredPointersOutliveReaders) {
+    auto& domain = epoch_domain::instance();
+    collect(3);
+    freed = 0;
+
+    // a reader that entered before the retirement holds it back, however often others collect
+    std::atomic<bool> entered(false);
+    std::atomic<bool> done(false);
+    std::thread reader([&] {
+        epoch_guard guard;
+        entered = true;
+        while (!done) {
+            std::this_thread::yield();
+        }
+    });
+
+    while (!entered) {
+        std::this_thread::yield();
+    }
+
+    retire_int();
+    EXPECT_EQ(1u, domain.pending());
+    collect(10);
+    EXPECT_EQ(0, freed.load());
+
+    done = true;
+    reader.join();
+    collect(3);
+    EXPECT_EQ(1, freed.load());
+    EXPECT_EQ(0u, domain.pending());
+}
+
+TEST(EpochTest, NestedGuardsAndBatches) {
+    auto& domain = epoch_domain::instance();
+    collect(3);
+    freed = 0;
+
+    // leaving a nested section keeps the thread protected, and leaving the outermost one stops
+    // it from holding back its own retirements
+    {
+        epoch_guard outer;
+        {
+            epoch_guard inner;
+            domain.retire(new int(0), &free_int);
+        }
+
+        auto epoch = domain.epoch();
+        collect(3);
+        EXPECT_GE(epoch + 1, domain.epoch());
+        EXPECT_EQ(0, freed.load());
+    }
+
+    collect(3);
+    EXPECT_EQ(1, freed.load());
+    EXPECT_EQ(0u, domain.pending());
+
+    // retiring frees older pointers in batches on its own
+    for (std::size_t i = 0; i < 10 * epoch_domain::collect_threshold; ++i) {
+        retire_int();
+    }
+
+    EXPECT_LT(0, freed.load());
+    EXPECT_GE(2 * epoch_domain::collect_threshold, domain.pending());
+}
@@ -0,0 +1,118 @@
+/************************************************
+ *  frozen_tree_test.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <bptree/bptree.hpp>
+
+// Checks every lookup against `std::set` for keys in and around `keys`, which must be sorted
+// according to `Compare` and made of even numbers only.
+template <typename Set, typename Compare = std::less<int>>
+void expect_same_lookups(std::vector<int> const& keys) {
+    std::multiset<int, Compare> expected(keys.begin(), keys.end());
+    Set set(keys.begin(), keys.end());
+    ASSERT_EQ(expected.size(), set.size());
+    ASSERT_TRUE(std::equal(expected.begin(), expected.end(), set.begin(), set.end()));
+
+    auto lo = keys.empty() ? 0 : std::min(keys.front(), keys.back()) - 3;
+    auto hi = keys.empty() ? 0 : std::max(keys.front(), keys.back()) + 3;
+    for (auto key = lo; key <= hi; ++key) {
+        EXPECT_EQ(std::distance(expected.begin(), expected.lower_bound(key)),
+                  set.lower_bound(key) - set.begin()) << "key " << key;
+        EXPECT_EQ(std::distance(expected.begin(), expected.upper_bound(key)),
+                  set.upper_bound(key) - set.begin()) << "key " << key;
+        EXPECT_EQ(expected.count(key), set.count(key));
+        EXPECT_EQ(expected.count(key) > 0, set.find(key) != set.end());
+    }
+}
+
+// Every size up to a few full levels of small blocks, to cover partial blocks and subtrees.
+TEST(FrozenTreeTest, MatchStdSetForAllSizes) {
+    for (int n = 0; n < 200; ++n) {
+        std::vector<int> keys(n);
+        for (int i = 0; i < n; ++i) {
+            keys[i] = i * 2;
+        }
+
+        expect_same_lookups<bptree::frozen_set<int, std::less<int>, 2>>(keys);
+        expect_same_lookups<bptree::frozen_set<int, std::less<int>, 3>>(keys);
+        expect_same_lookups<bptree::frozen_set<int>>(keys);
+
+        std::reverse(keys.begin(), keys.end());
+        expect_same_lookups<bptree::frozen_set<int, std::greater<int>, 4>, std::greater<int>>(keys);
+    }
+}
+
+TEST(FrozenTreeTest, Duplicates) {
+    std::vector<int> keys = {2, 2, 2, 4, 6, 6, 8, 8, 8, 8, 8, 10, 12, 12};
+    expect_same_lookups<bptree::frozen_set<int, std::less<int>, 2>>(keys);
+    expect_same_lookups<bptree::frozen_set<int, std::less<int>, 4>>(keys);
+
+    bptree::multiset<int> tree(keys.begin(), keys.end());
+    auto frozen = tree.freeze();
+    EXPECT_EQ(5u, frozen.count(8));
+    EXPECT_EQ(0u, frozen.count(9));
+}
+
+TEST(FrozenTreeTest, FreezeMap) {
+    bptree::map<std::int64_t, std::int64_t> tree;
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<std::int64_t> dist(0, 1000000);
+    for (int i = 0; i < 20000; ++i) {
+        auto key = dist(gen);
+        tree.insert({key, -key});
+    }
+
+    auto frozen = tree.freeze();
+    EXPECT_EQ(tree.size(), frozen.size());
+    EXPECT_EQ(5u, frozen.height());
+    EXPECT_TRUE(std::equal(tree.begin(), tree.end(), frozen.begin(), frozen.end()));
+
+    for (std::int64_t key = 0; key <= 1000000; key += 97) {
+        auto it = frozen.find(key);
+        if (tree.count(key)) {
+            ASSERT_NE(frozen.end(), it);
+            EXPECT_EQ(-key, it->second);
+        } else {
+            EXPECT_EQ(frozen.end(), it);
+        }
+    }
+
+    auto copy = frozen;
+    EXPECT_TRUE(std::equal(frozen.begin(), frozen.end(), copy.begin(), copy.end()));
+    EXPECT_EQ(frozen.lower_bound(500000) - frozen.begin(),
+              copy.lower_bound(500000) - copy.begin());
+}
+
+TEST(FrozenTreeTest, StringKeys) {
+    std::set<std::string> expected;
+    for (int i = 0; i < 500; ++i) {
+        expected.insert(std::to_string(i * 7));
+    }
+
+    bptree::frozen_set<std::string, std::less<std::string>, 4> set(expected.begin(),
+                                                                   expected.end());
+    for (int i = 0; i < 3500; ++i) {
+        auto key = std::to_string(i);
+        EXPECT_EQ(expected.count(key), set.count(key));
+        EXPECT_EQ(std::distance(expected.begin(), expected.lower_bound(key)),
+                  set.lower_bound(key) - set.begin());
+    }
+}
@@ -0,0 +1,84 @@
+/************************************************
+ *  map_test_util.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#ifndef BPTREE_TEST_MAP_TEST_UTIL_HPP_
+#define BPTREE_TEST_MAP_TEST_UTIL_HPP_
+
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// Number of random writes that the map tests replay, enough for trees with small nodes to split,
+// borrow and merge many times over.
+constexpr int random_write_count = 20000;
+
+// Calls `f(i, n, erase)` for `write_count` random writes to the keys numbered [0, key_count):
+// every third write erases key `n`, and the others insert it with `i` as the value. The writes
+// only depend on `seed`, so that a failing test can be replayed.
+template <typename F>
+void random_writes(unsigned seed, int key_count, int write_count, F f) {
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> dist(0, key_count - 1);
+    for (int i = 0; i < write_count; ++i) {
+        f(i, dist(gen), i % 3 == 2);
+    }
+}
+
+// Whether an insert took place, for the maps that return a flag and for those that return an
+// iterator along with it.
+inline bool inserted(bool result) {
+    return result;
+}
+
+template <typename Iterator>
+bool inserted(std::pair<Iterator, bool> const& result) {
+    return result.second;
+}
+
+// Applies a write of `random_writes` to both `map` and the reference map `expected`, and checks
+// that they agree on whether it changed anything.
+template <typename Map, typename Expected>
+void expect_same_write(Map& map, Expected& expected, typename Expected::key_type const& key,
+                       int value, bool erase) {
+    if (erase) {
+        EXPECT_EQ(expected.erase(key), map.erase(key));
+    } else {
+        EXPECT_EQ(expected.emplace(key, value).second, inserted(map.insert({key, value})));
+    }
+}
+
+// Checks `map.find(key, f)` against `expected` for every key in [0, key_count), for the maps that
+// pass the value found to a callback rather than return an iterator.
+template <typename Map>
+void expect_same_lookups(Map const& map, std::map<int, int> const& expected, int key_count) {
+    for (int key = 0; key < key_count; ++key) {
+        auto it = expected.find(key);
+        int value = -1;
+        EXPECT_EQ(it != expected.end(), map.find(key, [&](std::pair<int const, int> const& v) {
+            value = v.second;
+        }));
+        EXPECT_EQ(it != expected.end() ? it->second : -1, value);
+    }
+}
+
+// Same as above, after checking the size and the values that `map.for_each` visits, in order.
+template <typename Map>
+void expect_same_contents(Map& map, std::map<int, int> const& expected, int key_count) {
+    ASSERT_EQ(expected.size(), map.size());
+
+    std::vector<std::pair<int, int>> values;
+    map.for_each([&](std::pair<int const, int> const& v) { values.emplace_back(v); });
+    EXPECT_EQ((std::vector<std::pair<int, int>>(expected.begin(), expected.end())), values);
+
+    expect_same_lookups(map, expected, key_count);
+}
+
+#endif  // BPTREE_TEST_MAP_TEST_UTIL_HPP_
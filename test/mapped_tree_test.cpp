@@ -0,0 +1,180 @@
+/************************************************
+ *  mapped_tree_test.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#include <cstddef>
+#include <cstdio>
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <bptree/bptree.hpp>
+
+// Small pages, so that the trees below grow a few levels deep.
+using small_mapped_map = bptree::mapped_map<int, int, std::less<int>, 128>;
+using small_mapped_set = bptree::mapped_set<int, std::less<int>, 128>;
+
+std::string temp_path(std::string const& name) {
+    return testing::TempDir() + "bptree_" + name;
+}
+
+TEST(MappedTreeTest, PageCapacity) {
+    EXPECT_EQ(13, small_mapped_map::leaf_capacity());
+    EXPECT_EQ(7, small_mapped_map::inner_capacity());
+    EXPECT_LE(sizeof(small_mapped_map::leaf_page_type), small_mapped_map::page_size());
+    EXPECT_LE(sizeof(small_mapped_map::inner_page_type), small_mapped_map::page_size());
+}
+
+TEST(MappedTreeTest, LookupWrittenMap) {
+    std::map<int, int> expected;
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> dist(0, 100000);
+    for (int i = 0; i < 5000; ++i) {
+        auto key = dist(gen);
+        expected.emplace(key, key * 3);
+    }
+
+    auto path = temp_path("mapped_map");
+    bptree::map<int, int> tree(expected.begin(), expected.end());
+    small_mapped_map::write(path, tree.begin(), tree.end());
+
+    small_mapped_map map(path);
+    EXPECT_EQ(expected.size(), map.size());
+    EXPECT_EQ(5u, map.height());
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), map.begin(), map.end()));
+    EXPECT_TRUE(std::equal(expected.rbegin(), expected.rend(),
+                           std::make_reverse_iterator(map.end()),
+                           std::make_reverse_iterator(map.begin())));
+
+    for (int key = -10; key < 100010; key += 37) {
+        auto it = map.find(key);
+        auto expected_it = expected.find(key);
+        if (expected_it == expected.end()) {
+            EXPECT_EQ(map.end(), it);
+        } else {
+            ASSERT_NE(map.end(), it);
+            EXPECT_EQ(expected_it->second, it->second);
+        }
+
+        EXPECT_EQ(expected.count(key), map.count(key));
+        EXPECT_EQ(std::distance(expected.begin(), expected.lower_bound(key)),
+                  std::distance(map.begin(), map.lower_bound(key)));
+        EXPECT_EQ(std::distance(expected.begin(), expected.upper_bound(key)),
+                  std::distance(map.begin(), map.upper_bound(key)));
+    }
+
+    long sum = 0;
+    map.for_each_span(1000, 50000, [&](std::pair<int const, int> const* data, std::size_t size) {
+        for (std::size_t i = 0; i < size; ++i) {
+            sum += data[i].second;
+        }
+    });
+
+    long expected_sum = 0;
+    for (auto it = expected.lower_bound(1000); it != expected.lower_bound(50000); ++it) {
+        expected_sum += it->second;
+    }
+
+    EXPECT_EQ(expected_sum, sum);
+
+    // a second mapping of the same file, as another process would open it
+    small_mapped_map other(path);
+    EXPECT_TRUE(std::equal(map.begin(), map.end(), other.begin(), other.end()));
+
+    small_mapped_map moved(std::move(other));
+    EXPECT_EQ(map.size(), moved.size());
+    EXPECT_TRUE(other.empty());
+    EXPECT_EQ(other.begin(), other.end());
+
+    std::remove(path.c_str());
+}
+
+TEST(MappedTreeTest, WriteEmptyAndSmallSets) {
+    auto path = temp_path("mapped_set");
+
+    std::vector<int> keys;
+    small_mapped_set::write(path, keys.begin(), keys.end());
+    {
+        small_mapped_set set(path);
+        EXPECT_TRUE(set.empty());
+        EXPECT_EQ(0u, set.height());
+        EXPECT_EQ(set.begin(), set.end());
+        EXPECT_EQ(set.end(), set.find(1));
+        EXPECT_TRUE(set.range(0, 10).empty());
+    }
+
+    keys = {1, 3, 5};
+    small_mapped_set::write(path, keys.begin(), keys.end());
+    {
+        small_mapped_set set(path);
+        EXPECT_EQ(1u, set.height());
+        EXPECT_TRUE(std::equal(keys.begin(), keys.end(), set.begin(), set.end()));
+        EXPECT_NE(set.end(), set.find(3));
+        EXPECT_EQ(set.end(), set.find(4));
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(MappedTreeTest, RejectForeignFiles) {
+    auto path = temp_path("mapped_foreign");
+    EXPECT_THROW(small_mapped_map(temp_path("mapped_missing")), std::system_error);
+
+    std::vector<int> keys = {1, 2, 3};
+    small_mapped_set::write(path, keys.begin(), keys.end());
+    EXPECT_THROW(small_mapped_map map(path), std::runtime_error);
+    EXPECT_THROW((bptree::mapped_set<int, std::less<int>, 256>(path)), std::runtime_error);
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << std::string(256, 'x');
+    EXPECT_THROW(small_mapped_set set(path), std::runtime_error);
+
+    std::remove(path.c_str());
+}
+
+TEST(MappedTreeTest, RejectCorruptedChildren) {
+    auto path = temp_path("mapped_corrupted");
+    std::vector<std::pair<int, int>> values;
+    for (int i = 0; i < 200; ++i) {
+        values.emplace_back(i, i);
+    }
+
+    small_mapped_map::write(path, values.begin(), values.end());
+    std::size_t page_count;
+    {
+        small_mapped_map map(path);
+        EXPECT_EQ(3u, map.height());
+        EXPECT_EQ(std::prev(map.end())->first, 199);
+        page_count = std::ifstream(path, std::ios::binary | std::ios::ate).tellg() /
+                     small_mapped_map::page_size();
+    }
+
+    // replace the root with one whose second child lies beyond the end of the file
+    std::vector<char> buffer(small_mapped_map::page_size());
+    auto root = new (buffer.data()) small_mapped_map::inner_page_type();
+    root->entries().emplace_back(0, page_count - 4);
+    root->entries().emplace_back(100, page_count + 100);
+
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp((page_count - 1) * small_mapped_map::page_size());
+    file.write(buffer.data(), buffer.size());
+    file.close();
+    EXPECT_THROW(small_mapped_map map(path), std::runtime_error);
+
+    std::remove(path.c_str());
+}
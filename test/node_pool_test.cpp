@@ -0,0 +1,112 @@
+/************************************************
+ *  node_pool_test.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <bptree/internal/node_pool.hpp>
+
+using bptree::internal::has_bulk_release;
+using bptree::internal::node_pool;
+using bptree::internal::pool_allocator;
+
+struct alignas(64) aligned_block {
+    char data[100];
+};
+
+TEST(NodePoolTest, AllocateDistinctAlignedBlocks) {
+    node_pool pool(sizeof(aligned_block), alignof(aligned_block));
+    EXPECT_EQ(128, pool.block_size());
+
+    std::set<void*> blocks;
+    for (std::size_t i = 0; i < 1000; ++i) {
+        auto block = pool.allocate();
+        EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(block) % alignof(aligned_block));
+        EXPECT_TRUE(blocks.insert(block).second);
+    }
+
+    // adjacent blocks must not overlap
+    for (auto it = blocks.begin(), next = std::next(it); next != blocks.end(); ++it, ++next) {
+        EXPECT_LE(static_cast<char*>(*it) + pool.block_size(), static_cast<char*>(*next));
+    }
+}
+
+TEST(NodePoolTest, ReuseFreedBlocks) {
+    node_pool pool(sizeof(int), alignof(int));
+    EXPECT_EQ(sizeof(void*), pool.block_size());
+
+    auto first = pool.allocate();
+    auto second = pool.allocate();
+    pool.deallocate(first);
+    pool.deallocate(second);
+
+    EXPECT_EQ(second, pool.allocate());
+    EXPECT_EQ(first, pool.allocate());
+}
+
+TEST(NodePoolTest, ReleaseAllBlocks) {
+    node_pool pool(sizeof(aligned_block), alignof(aligned_block));
+    for (std::size_t i = 0; i < 1000; ++i) {
+        ::new(pool.allocate()) aligned_block();
+    }
+
+    pool.release();
+
+    // the pool remains usable after being released
+    std::set<void*> blocks;
+    for (std::size_t i = 0; i < 100; ++i) {
+        EXPECT_TRUE(blocks.insert(pool.allocate()).second);
+    }
+}
+
+TEST(PoolAllocatorTest, RebindSharesPools) {
+    pool_allocator<int> alloc;
+    pool_allocator<aligned_block> rebound(alloc);
+    pool_allocator<int> rebound_back(rebound);
+
+    EXPECT_TRUE(alloc == rebound);
+    EXPECT_TRUE(alloc == rebound_back);
+    EXPECT_FALSE(alloc != rebound);
+    EXPECT_FALSE(alloc == pool_allocator<int>());
+    EXPECT_FALSE(alloc == alloc.select_on_container_copy_construction());
+
+    // blocks may be returned through any allocator sharing the pool
+    auto p = alloc.allocate(1);
+    rebound_back.deallocate(p, 1);
+    EXPECT_EQ(p, alloc.allocate(1));
+
+    auto block = rebound.allocate(1);
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(block) % alignof(aligned_block));
+    rebound.deallocate(block, 1);
+
+    alloc.release();
+}
+
+TEST(PoolAllocatorTest, AllocateArrays) {
+    pool_allocator<int> alloc;
+    auto p = alloc.allocate(100);
+    std::fill(p, p + 100, 42);
+    alloc.deallocate(p, 100);
+
+    std::vector<int, pool_allocator<int>> values(1000, 1, alloc);
+    EXPECT_EQ(1000, values.size());
+}
+
+TEST(PoolAllocatorTest, BulkReleaseTrait) {
+    EXPECT_TRUE(has_bulk_release<pool_allocator<int>>::value);
+    EXPECT_FALSE(has_bulk_release<std::allocator<int>>::value);
+}
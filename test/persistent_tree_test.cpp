@@ -0,0 +1,169 @@
+/************************************************
+ *  persistent_tree_test.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#include <cstddef>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <bptree/bptree.hpp>
+
+#include "./map_test_util.hpp"
+
+// Small nodes, so that writes split, borrow and merge often.
+using small_map = bptree::persistent_map<int, int, std::less<int>, 4, 4>;
+
+TEST(PersistentTreeTest, SnapshotsKeepTheirContents) {
+    small_map map;
+    std::map<int, int> expected;
+    std::vector<std::pair<small_map::snapshot_type, std::map<int, int>>> snapshots;
+
+    random_writes(42, 500, random_write_count, [&](int i, int key, bool erase) {
+        expect_same_write(map, expected, key, i, erase);
+        if (i % 1000 == 999) {
+            snapshots.emplace_back(map.snapshot(), expected);
+        }
+    });
+
+    expect_same_contents(map, expected, 500);
+    for (auto const& snapshot : snapshots) {
+        expect_same_contents(snapshot.first, snapshot.second, 500);
+    }
+
+    // dropping the snapshots in any order leaves the tree intact
+    std::shuffle(snapshots.begin(), snapshots.end(), std::mt19937(42));
+    snapshots.resize(snapshots.size() / 2);
+    while (!map.empty()) {
+        auto key = expected.begin()->first;
+        expected.erase(key);
+        EXPECT_EQ(1u, map.erase(key));
+    }
+
+    EXPECT_EQ(0u, map.height());
+    for (auto const& snapshot : snapshots) {
+        expect_same_contents(snapshot.first, snapshot.second, 500);
+    }
+}
+
+TEST(PersistentTreeTest, RangeAndCopies) {
+    small_map map;
+    for (int i = 0; i < 1000; i += 2) {
+        map.insert({i, -i});
+    }
+
+    auto snapshot = map.snapshot();
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(500u, snapshot.size());
+
+    std::vector<int> keys;
+    snapshot.for_each(101, 121, [&](std::pair<int const, int> const& value) {
+        keys.push_back(value.first);
+    });
+    EXPECT_EQ((std::vector<int>{102, 104, 106, 108, 110, 112, 114, 116, 118, 120}), keys);
+
+    keys.clear();
+    snapshot.for_each(500, 500, [&](std::pair<int const, int> const& value) {
+        keys.push_back(value.first);
+    });
+    EXPECT_TRUE(keys.empty());
+
+    // a copy of a tree shares its nodes like a snapshot, and writes to either stay apart
+    small_map copy;
+    copy.insert({1, 1});
+    small_map other = copy;
+    other.insert({2, 2});
+    copy.erase(1);
+    EXPECT_TRUE(copy.empty());
+    EXPECT_TRUE(other.contains(1));
+    EXPECT_TRUE(other.contains(2));
+
+    auto moved = std::move(snapshot);
+    EXPECT_EQ(500u, moved.size());
+    EXPECT_TRUE(moved.contains(998));
+}
+
+// Values count their copies, to check that a write only copies the nodes on its path.
+struct counted {
+    static int copies;
+
+    counted() = default;
+    counted(counted const&) { ++copies; }
+    counted& operator=(counted const&) { ++copies; return *this; }
+};
+
+int counted::copies = 0;
+
+TEST(PersistentTreeTest, WritesCopyOnlyTheirPath) {
+    bptree::persistent_map<int, counted, std::less<int>, 8, 8> map;
+    for (int i = 0; i < 10000; ++i) {
+        map.insert({i, counted()});
+    }
+
+    auto snapshot = map.snapshot();
+    counted::copies = 0;
+    map.insert({-1, counted()});
+    EXPECT_GE(8 + 2, counted::copies);  // the leaf of the new value, then the value into a pair
+                                        // and into the leaf
+
+    counted::copies = 0;
+    map.erase(5000);
+    EXPECT_GE(8 + 8, counted::copies);  // the leaf of the key, and maybe a sibling
+    EXPECT_EQ(10000u, snapshot.size());
+    EXPECT_TRUE(snapshot.contains(5000));
+    EXPECT_FALSE(snapshot.contains(-1));
+}
+
+TEST(PersistentTreeTest, ReadSnapshotsWhileWriting) {
+    bptree::persistent_set<int> set;
+    for (int i = 0; i < 10000; ++i) {
+        set.insert(i);
+    }
+
+    // each reader holds (and eventually drops) a copy of the snapshot
+    std::atomic<bool> done(false);
+    auto snapshot = set.snapshot();
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&done, snapshot]() {
+            while (!done) {
+                long long sum = 0;
+                snapshot.for_each([&](int key) { sum += key; });
+                EXPECT_EQ(9999LL * 10000 / 2, sum);
+            }
+        });
+    }
+
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> dist(0, 19999);
+    for (int i = 0; i < 20000; ++i) {
+        auto key = dist(gen);
+        if (i % 2) {
+            set.erase(key);
+        } else {
+            set.insert(key);
+        }
+    }
+
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(10000u, snapshot.size());
+    EXPECT_LT(0u, set.size());
+}
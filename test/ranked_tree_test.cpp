@@ -0,0 +1,150 @@
+/************************************************
+ *  ranked_tree_test.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#include <cstddef>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <bptree/bptree.hpp>
+
+#include "./map_test_util.hpp"
+
+// Checks every position and every key in and around `expected` against the ranked `tree`.
+template <typename Tree, typename Expected, typename MakeKey>
+void expect_same_ranks(Tree const& tree, Expected const& expected, int num_keys,
+                       MakeKey make_key) {
+    ASSERT_EQ(expected.size(), tree.size());
+    ASSERT_TRUE(std::equal(expected.begin(), expected.end(), tree.begin(), tree.end()));
+
+    std::size_t index = 0;
+    for (auto it = tree.begin(); it != tree.end(); ++it, ++index) {
+        ASSERT_EQ(it, tree.nth(index));
+        ASSERT_EQ(index, tree.index_of(it));
+    }
+
+    EXPECT_EQ(tree.end(), tree.nth(tree.size()));
+    EXPECT_EQ(tree.size(), tree.index_of(tree.end()));
+
+    for (int n = -1; n <= num_keys; ++n) {
+        auto key = make_key(n);
+        auto rank = static_cast<std::size_t>(
+            std::distance(expected.begin(), expected.lower_bound(key)));
+        ASSERT_EQ(rank, tree.rank(key));
+        ASSERT_EQ(rank, tree.index_of(tree.lower_bound(key)));
+    }
+}
+
+// Small nodes, so that leaves and inner nodes split, borrow and merge all the time.
+TEST(RankedTreeTest, MatchStdMultiset) {
+    bptree::ranked_multiset<int, std::less<int>, 4, 4> set;
+    std::multiset<int> expected;
+    auto make_key = [](int n) { return n; };
+    expect_same_ranks(set, expected, 0, make_key);
+
+    random_writes(11, 500, 10000, [&](int i, int key, bool erase) {
+        if (erase) {
+            EXPECT_EQ(expected.erase(key), set.erase(key));
+        } else {
+            expected.insert(key);
+            set.insert(key);
+        }
+
+        if (i % 1000 == 999) {
+            expect_same_ranks(set, expected, 500, make_key);
+        }
+    });
+
+    // erasing a range rebalances the tree many times over
+    auto lo = set.lower_bound(100);
+    auto hi = set.lower_bound(400);
+    EXPECT_EQ(std::distance(lo, hi),
+              static_cast<std::ptrdiff_t>(set.index_of(hi) - set.index_of(lo)));
+    set.erase(lo, hi);
+    expected.erase(expected.lower_bound(100), expected.lower_bound(400));
+    expect_same_ranks(set, expected, 500, make_key);
+
+    while (!set.empty()) {
+        set.erase(set.nth(set.size() / 2));
+    }
+
+    EXPECT_EQ(0u, set.rank(7));
+    EXPECT_EQ(set.end(), set.nth(0));
+}
+
+TEST(RankedTreeTest, BulkLoadAndCopy) {
+    std::vector<int> keys(5000);
+    for (int i = 0; i < 5000; ++i) {
+        keys[i] = i * 2;
+    }
+
+    bptree::ranked_set<int, std::less<int>, 8, 4> set;
+    set.bulk_load(keys.begin(), keys.end(), 0.7);
+    std::set<int> expected(keys.begin(), keys.end());
+    auto make_key = [](int n) { return n; };
+    expect_same_ranks(set, expected, 10000, make_key);
+
+    auto copy = set;
+    copy.insert(1);
+    expected.insert(1);
+    expect_same_ranks(copy, expected, 10000, make_key);
+    EXPECT_EQ(2u, set.rank(3));
+    EXPECT_EQ(3u, copy.rank(3));
+}
+
+TEST(RankedTreeTest, Map) {
+    bptree::ranked_map<int, int, std::less<int>, 4, 4> map;
+    for (int i = 0; i < 1000; ++i) {
+        map[(i * 7) % 1000] = i;
+    }
+
+    EXPECT_EQ(500, map.nth(500)->first);
+    EXPECT_EQ(500u, map.rank(500));
+    EXPECT_EQ(500u, map.index_of(map.find(500)));
+
+    map.erase(map.nth(0), map.nth(250));
+    EXPECT_EQ(750u, map.size());
+    EXPECT_EQ(500, map.nth(250)->first);
+    EXPECT_EQ(0u, map.rank(-1));
+    EXPECT_EQ(750u, map.rank(1000));
+}
+
+// String keys use the prefix-compressed inner nodes, which have to carry the counts as well.
+TEST(RankedTreeTest, StringKeys) {
+    bptree::ranked_map<std::string, int, std::less<std::string>, 4, 4> map;
+    std::map<std::string, int> expected;
+    auto make_key = [](int n) {
+        return "https://example.com/" + std::to_string(n % 7) + "/item/" + std::to_string(n);
+    };
+
+    random_writes(5, 1000, 5000, [&](int i, int n, bool erase) {
+        expect_same_write(map, expected, make_key(n), i, erase);
+    });
+
+    expect_same_ranks(map, expected, 1000, make_key);
+    expect_same_ranks(decltype(map)(map), expected, 1000, make_key);
+}
+
+TEST(RankedTreeTest, TransparentKeys) {
+    bptree::ranked_set<std::string, std::less<>, 4, 4> set;
+    for (int i = 0; i < 1000; ++i) {
+        set.insert("key" + std::to_string(i));
+    }
+
+    // "key0" < "key1" < "key10" < "key100" < ... < "key99" < "key990"
+    EXPECT_EQ(0u, set.rank("key0"));
+    EXPECT_EQ(1000u, set.rank("l"));
+    EXPECT_EQ("key990", *set.nth(set.rank("key99") + 1));
+}
@@ -0,0 +1,117 @@
+/************************************************
+ *  search_test.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <bptree/internal/deny_duplicates.hpp>
+#include <bptree/internal/map_traits.hpp>
+#include <bptree/internal/search.hpp>
+#include <bptree/internal/set_traits.hpp>
+#include <bptree/internal/static_assoc.hpp>
+#include <bptree/internal/static_vector.hpp>
+
+using bptree::internal::deny_duplicates;
+using bptree::internal::linear_search_max_size;
+using bptree::internal::map_traits;
+using bptree::internal::search_kernel;
+using bptree::internal::set_traits;
+using bptree::internal::static_assoc;
+using bptree::internal::static_vector;
+
+template <typename Key>
+Key make_value(Key key, Key const*) {
+    return key;
+}
+
+template <typename Key, typename T>
+std::pair<Key const, T> make_value(Key key, std::pair<Key const, T> const*) {
+    return {key, T()};
+}
+
+template <typename Traits, std::size_t N>
+void test_search_kernel(unsigned seed) {
+    using key_type = typename Traits::key_type;
+    using value_type = typename Traits::value_type;
+    using key_compare = typename Traits::key_compare;
+
+    struct traits : Traits {
+        using typename Traits::core_compare;
+    };
+
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> dist(-20, 20);
+    key_compare comp;
+
+    for (std::size_t size = 0; size <= N; size += (size < 20 ? 1 : 7)) {
+        std::vector<key_type> keys(size);
+        std::generate(keys.begin(), keys.end(), [&]() { return static_cast<key_type>(dist(gen)); });
+        std::sort(keys.begin(), keys.end(), comp);
+
+        static_vector<value_type, N> values;
+        for (auto key : keys) {
+            values.push_back(make_value(key, static_cast<value_type const*>(nullptr)));
+        }
+
+        typename traits::core_compare core_comp(comp);
+        for (int k = -22; k <= 22; ++k) {
+            std::ostringstream ss;
+            ss << "size = " << size << "\tkey = " << k;
+            SCOPED_TRACE(ss.str());
+
+            auto key = static_cast<key_type>(k);
+            auto first = values.cbegin();
+            auto last = values.cend();
+            EXPECT_EQ(std::lower_bound(first, last, key, core_comp),
+                      (search_kernel<Traits, N>::lower_bound(first, last, key, core_comp)));
+            EXPECT_EQ(std::upper_bound(first, last, key, core_comp),
+                      (search_kernel<Traits, N>::upper_bound(first, last, key, core_comp)));
+        }
+    }
+}
+
+#define TEST_SEARCH_KERNEL(name, key_type)                                                    \
+    TEST(SearchTest, name) {                                                                  \
+        std::size_t constexpr small_n = linear_search_max_size;                               \
+        std::size_t constexpr large_n = linear_search_max_size * 2;                           \
+        test_search_kernel<set_traits<key_type>, small_n>(1);                                 \
+        test_search_kernel<set_traits<key_type>, large_n>(2);                                 \
+        test_search_kernel<set_traits<key_type, std::greater<key_type>>, small_n>(3);         \
+        test_search_kernel<set_traits<key_type, std::greater<key_type>>, large_n>(4);         \
+        test_search_kernel<set_traits<key_type, std::less<>>, small_n>(5);                    \
+        test_search_kernel<map_traits<key_type, int>, small_n>(6);                            \
+        test_search_kernel<map_traits<key_type, int>, large_n>(7);                            \
+        test_search_kernel<map_traits<key_type, int, std::greater<key_type>>, small_n>(8);    \
+    }
+
+TEST_SEARCH_KERNEL(SearchInt32, std::int32_t)
+TEST_SEARCH_KERNEL(SearchInt64, std::int64_t)
+TEST_SEARCH_KERNEL(SearchUnsigned, unsigned)
+TEST_SEARCH_KERNEL(SearchFloat, float)
+TEST_SEARCH_KERNEL(SearchDouble, double)
+
+TEST(SearchTest, LookupWithGreaterCompare) {
+    using set_type = static_assoc<set_traits<int, std::greater<int>>, deny_duplicates, 16>;
+    set_type set({5, 1, 9, 3, 7});
+
+    EXPECT_EQ(set.begin(), set.find(9));
+    EXPECT_EQ(set.begin() + 4, set.find(1));
+    EXPECT_EQ(set.end(), set.find(4));
+    EXPECT_EQ(set.begin() + 3, set.lower_bound(4));
+    EXPECT_EQ(set.begin() + 3, set.upper_bound(5));
+    EXPECT_EQ(1, set.count(7));
+}
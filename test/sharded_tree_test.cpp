@@ -0,0 +1,131 @@
+/************************************************
+ *  sharded_tree_test.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#include <cstddef>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <bptree/bptree.hpp>
+
+#include "./map_test_util.hpp"
+
+// Small nodes, so that the shards below split often and grow a few levels deep.
+using small_map = bptree::sharded_map<int, int, 4, std::less<int>, 4, 4>;
+using small_set = bptree::sharded_set<int, 4, std::less<int>, 4, 4>;
+
+TEST(ShardedTreeTest, MatchStdMap) {
+    std::vector<int> splits = {250, 500, 750};
+    small_map map(splits.begin(), splits.end());
+    std::map<int, int> expected;
+    random_writes(42, 1000, random_write_count, [&](int i, int key, bool erase) {
+        expect_same_write(map, expected, key, i, erase);
+    });
+
+    expect_same_contents(map, expected, 1000);
+}
+
+TEST(ShardedTreeTest, SplitPoints) {
+    // keys equal to a split point belong to the shard on its right, and extra points are ignored
+    std::vector<int> fixed = {10, 20, 30, 40, 50};
+    small_set set(fixed.begin(), fixed.end());
+    EXPECT_EQ((std::vector<int>{10, 20, 30}), set.splits());
+    EXPECT_EQ(0u, set.shard_of(9));
+    EXPECT_EQ(1u, set.shard_of(10));
+    EXPECT_EQ(2u, set.shard_of(29));
+    EXPECT_EQ(3u, set.shard_of(1000));
+
+    // sampled points cut the sample evenly, and repeated keys give a single point
+    std::vector<int> sample;
+    for (int key = 399; key >= 0; --key) {
+        sample.push_back(key);
+    }
+
+    EXPECT_EQ((std::vector<int>{100, 200, 300}), small_set::sample_splits(sample.begin(),
+                                                                          sample.end()));
+    std::vector<int> repeated(100, 7);
+    EXPECT_EQ((std::vector<int>{7}), small_set::sample_splits(repeated.begin(), repeated.end()));
+    EXPECT_TRUE(small_set::sample_splits(sample.end(), sample.end()).empty());
+}
+
+TEST(ShardedTreeTest, OrderedScansAcrossShards) {
+    std::vector<int> splits = {100, 200, 300};
+    small_set set(splits.begin(), splits.end());
+    EXPECT_TRUE(set.empty());
+    for (int key = 399; key >= 0; key -= 3) {
+        set.insert(key);
+    }
+
+    std::vector<int> all;
+    set.for_each([&](int key) { all.push_back(key); });
+    ASSERT_EQ(134u, all.size());
+    EXPECT_TRUE(std::is_sorted(all.begin(), all.end()));
+
+    for (int lo = 0; lo < 400; lo += 37) {
+        for (int hi = lo - 20; hi < 420; hi += 53) {
+            std::vector<int> expected;
+            std::copy_if(all.begin(), all.end(), std::back_inserter(expected),
+                         [=](int key) { return lo <= key && key < hi; });
+
+            std::vector<int> actual;
+            set.for_each(lo, hi, [&](int key) { actual.push_back(key); });
+            EXPECT_EQ(expected, actual);
+        }
+    }
+}
+
+TEST(ShardedTreeTest, ConcurrentWriters) {
+    constexpr int thread_count = 8;
+    constexpr int per_thread = 5000;
+
+    std::vector<int> keys;
+    for (int key = 0; key < thread_count * per_thread; key += 97) {
+        keys.push_back(key);
+    }
+
+    auto splits = small_map::sample_splits(keys.begin(), keys.end());
+    small_map map(splits.begin(), splits.end());
+
+    // every thread writes keys spread over all the shards, and erases every other one
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&map, t] {
+            for (int i = 0; i < per_thread; ++i) {
+                auto key = i * thread_count + t;
+                EXPECT_TRUE(map.insert({key, -key}));
+                if (i % 2 == 0) {
+                    EXPECT_EQ(1u, map.erase(key));
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(static_cast<std::size_t>(thread_count * per_thread / 2), map.size());
+
+    std::vector<int> scanned;
+    map.for_each([&](std::pair<int const, int> const& value) {
+        EXPECT_EQ(-value.first, value.second);
+        scanned.push_back(value.first);
+    });
+
+    ASSERT_EQ(map.size(), scanned.size());
+    EXPECT_TRUE(std::is_sorted(scanned.begin(), scanned.end()));
+    for (auto key : scanned) {
+        EXPECT_NE(0, key / thread_count % 2);
+    }
+}
@@ -13,8 +13,11 @@
 #include <list>
 #include <memory>
 #include <sstream>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -22,12 +25,14 @@
 #include <bptree/internal/deny_duplicates.hpp>
 #include <bptree/internal/map_traits.hpp>
 #include <bptree/internal/set_traits.hpp>
+#include <bptree/internal/split_map_traits.hpp>
 #include <bptree/internal/static_assoc.hpp>
 
 using bptree::internal::allow_duplicates;
 using bptree::internal::deny_duplicates;
 using bptree::internal::map_traits;
 using bptree::internal::set_traits;
+using bptree::internal::split_map_traits;
 using bptree::internal::static_assoc;
 
 template <typename Key, typename T, std::size_t N, typename Compare = std::less<Key>>
@@ -36,6 +41,12 @@ using static_map = static_assoc<map_traits<Key, T, Compare>, deny_duplicates, N>
 template <typename Key, typename T, std::size_t N, typename Compare = std::less<Key>>
 using static_multimap = static_assoc<map_traits<Key, T, Compare>, allow_duplicates, N>;
 
+template <typename Key, typename T, std::size_t N, typename Compare = std::less<Key>>
+using static_split_map = static_assoc<split_map_traits<Key, T, Compare>, deny_duplicates, N>;
+
+template <typename Key, typename T, std::size_t N, typename Compare = std::less<Key>>
+using static_split_multimap = static_assoc<split_map_traits<Key, T, Compare>, allow_duplicates, N>;
+
 template <typename T, std::size_t N, typename Compare = std::less<T>>
 using static_set = static_assoc<set_traits<T, Compare>, deny_duplicates, N>;
 
@@ -420,3 +431,256 @@ TEST(StaticAssocTest, AccessMapWithIndex) {
     EXPECT_EQ(nonexistent_value, map.at(nonexistent_key));
     EXPECT_EQ(nonexistent_value, map[nonexistent_key]);
 }
+
+TEST(StaticAssocTest, SplitMapLayout) {
+    using test_split_map = static_split_map<int, char, assoc_size>;
+    test_split_map map(test_values);
+
+    EXPECT_EQ(num_test_values, map.size());
+    EXPECT_TRUE(std::equal(sorted_test_values.begin(), sorted_test_values.end(), map.begin(),
+                           [](test_value_type const& lhs, test_split_map::const_reference rhs) {
+                               return lhs.first == rhs.first && lhs.second == rhs.second;
+                           }));
+
+    // keys are stored contiguously, apart from the mapped values
+    auto keys = map.begin().keys();
+    for (std::size_t i = 0; i < map.size(); ++i) {
+        EXPECT_EQ(&map.begin()[i].first, keys + i);
+    }
+
+    EXPECT_EQ(map.begin() + 2, map.find(5));
+    EXPECT_EQ(map.end(), map.find(nonexistent_key));
+    EXPECT_EQ(map.begin() + 2, map.lower_bound(4));
+    EXPECT_EQ(map.begin() + 3, map.upper_bound(5));
+
+    auto result = map.insert(duplicated_inserted_value);
+    EXPECT_FALSE(result.second);
+    EXPECT_EQ(map.begin() + duplicated_index, result.first);
+
+    result = map.emplace(4, 'z');
+    EXPECT_TRUE(result.second);
+    EXPECT_EQ(4, result.first->first);
+    EXPECT_EQ('z', result.first->second);
+
+    // mapped values are writable through the proxies
+    result.first->second = 'y';
+    (*map.find(1)).second = 'x';
+    EXPECT_EQ('y', map.at(4));
+    EXPECT_EQ('x', map[1]);
+
+    map[nonexistent_key] = nonexistent_value;
+    EXPECT_EQ(nonexistent_value, map.begin()->second);
+    EXPECT_THROW(map.at(100), std::out_of_range);
+
+    EXPECT_EQ(1, map.erase(5));
+    EXPECT_EQ(0, map.erase(5));
+    EXPECT_EQ(num_test_values + 1, map.size());
+
+    test_split_map copied(map);
+    EXPECT_TRUE(copied == map);
+    copied[3] = 'w';
+    EXPECT_TRUE(copied != map);
+    EXPECT_TRUE(copied > map);
+}
+
+TEST(StaticAssocTest, SplitMultiMapLayout) {
+    static_split_multimap<int, int, assoc_size> map;
+    for (int i = 0; i < static_cast<int>(assoc_size); ++i) {
+        map.emplace(i % 3, i);
+    }
+
+    EXPECT_TRUE(map.full());
+    EXPECT_EQ(4, map.count(0));
+    EXPECT_EQ(3, map.count(2));
+
+    auto range = map.equal_range(1);
+    int expected = 1;
+    for (auto it = range.first; it != range.second; ++it, expected += 3) {
+        EXPECT_EQ(1, it->first);
+        EXPECT_EQ(expected, it->second);
+    }
+
+    map.erase(map.begin(), map.begin() + 4);
+    EXPECT_EQ(0, map.count(0));
+    EXPECT_EQ(1, map.begin()->first);
+    EXPECT_EQ(2, map.rbegin().base()[-1].first);
+}
+
+TEST(StaticAssocTest, ConstructWithSortedInput) {
+    test_map map(bptree::internal::sorted_input, sorted_test_values.begin(),
+                 sorted_test_values.end());
+    assert_assoc_values(map, sorted_test_values);
+
+    test_value_list sorted_values_with_duplication = {
+        test_value_type(1, 'b'),
+        test_value_type(3, 'e'),
+        test_value_type(3, 'x'),
+        test_value_type(5, 'c'),
+        test_value_type(6, 'a'),
+        test_value_type(7, 'd')
+    };
+
+    test_map map_from_duplication(bptree::internal::sorted_input,
+                                  sorted_values_with_duplication.begin(),
+                                  sorted_values_with_duplication.end());
+    assert_assoc_values(map_from_duplication, sorted_test_values);
+
+    test_multimap multimap(bptree::internal::sorted_input, sorted_values_with_duplication.begin(),
+                           sorted_values_with_duplication.end());
+    assert_assoc_values(multimap, sorted_values_with_duplication);
+}
+
+template <typename Assoc, typename ValueList>
+void test_insert_batch(Assoc assoc, ValueList const& batch) {
+    auto expected = assoc;
+    std::vector<typename Assoc::value_type> expected_values;
+    std::vector<bool> expected_inserted;
+    for (auto const& value : batch) {
+        auto result = expected.insert(value);
+        expected_values.emplace_back(*result.first);
+        expected_inserted.push_back(result.second);
+    }
+
+    auto results = assoc.insert_batch(batch.begin(), batch.end());
+    EXPECT_TRUE(expected == assoc);
+    ASSERT_EQ(batch.size(), results.size());
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        std::ostringstream ss;
+        ss << "index = " << i;
+        SCOPED_TRACE(ss.str());
+
+        EXPECT_EQ(expected_inserted[i], results[i].second);
+        EXPECT_EQ(expected_values[i].first, results[i].first->first);
+        EXPECT_EQ(expected_values[i].second, results[i].first->second);
+    }
+}
+
+TEST(StaticAssocTest, InsertBatchIntoMap) {
+    test_value_list batch = {
+        test_value_type(4, 'v'),
+        test_value_type(6, 'w'),
+        test_value_type(0, 'x'),
+        test_value_type(4, 'y'),
+        test_value_type(9, 'z')
+    };
+
+    test_insert_batch(test_map(), batch);
+    test_insert_batch(test_map(test_values), batch);
+    test_insert_batch(test_map(test_values), test_value_list());
+    test_insert_batch(test_map(), test_values);
+    test_insert_batch(static_split_map<int, char, assoc_size>(test_values), batch);
+}
+
+// Only the values that are accepted need room in the node, and a batch may not hold more values
+// than the node could.
+TEST(StaticAssocTest, InsertBatchIntoFullMap) {
+    using small_map = static_map<int, char, 4>;
+    small_map map({test_value_type(1, 'a'), test_value_type(2, 'b'),
+                   test_value_type(3, 'c'), test_value_type(4, 'd')});
+    auto expected = map;
+
+    test_value_list duplicates = {test_value_type(2, 'x'), test_value_type(1, 'y')};
+    test_insert_batch(map, duplicates);
+
+    test_value_list too_many = {test_value_type(2, 'x'), test_value_type(5, 'y')};
+    EXPECT_THROW(map.insert_batch(too_many.begin(), too_many.end()), std::length_error);
+    EXPECT_TRUE(expected == map);
+
+    std::vector<test_value_type> too_large(5, test_value_type(1, 'x'));
+    EXPECT_THROW(map.insert_batch(too_large.begin(), too_large.end()), std::length_error);
+    EXPECT_THROW(small_map().insert_batch(too_large.begin(), too_large.end()), std::length_error);
+    EXPECT_TRUE(expected == map);
+}
+
+// Counts its constructions, to check that nothing is built for keys that are already there.
+struct counted {
+    static int constructions;
+
+    explicit counted(int v = 0)
+      : value(v)
+        { ++constructions; }
+
+    int value;
+};
+
+int counted::constructions = 0;
+
+template <typename Map>
+void test_try_emplace() {
+    Map map;
+    for (int key = 0; key < 8; key += 2) {
+        EXPECT_TRUE(map.try_emplace(key, key * 10).second);
+    }
+
+    counted::constructions = 0;
+    for (int key = 0; key < 8; key += 2) {
+        auto result = map.try_emplace(key, -1);
+        EXPECT_FALSE(result.second);
+        EXPECT_EQ(key * 10, result.first->second.value);
+    }
+
+    EXPECT_EQ(0, counted::constructions);
+
+    auto result = map.try_emplace(3, 30);
+    EXPECT_TRUE(result.second);
+    EXPECT_EQ(3, result.first->first);
+    EXPECT_EQ(30, result.first->second.value);
+    EXPECT_EQ(1, counted::constructions);
+
+    result = map.insert_or_assign(4, counted(-4));
+    EXPECT_FALSE(result.second);
+    EXPECT_EQ(-4, map.at(4).value);
+    result = map.insert_or_assign(5, counted(-5));
+    EXPECT_TRUE(result.second);
+    EXPECT_EQ(-5, map.at(5).value);
+    EXPECT_EQ(6u, map.size());
+}
+
+TEST(StaticAssocTest, TryEmplaceAndInsertOrAssign) {
+    test_try_emplace<static_map<int, counted, assoc_size>>();
+    test_try_emplace<static_split_map<int, counted, assoc_size>>();
+}
+
+template <typename Map>
+void test_transparent_keys() {
+    Map map;
+    map["b"] = 2;
+    map[std::string("a")] = 1;
+    EXPECT_EQ(2u, map.size());
+    EXPECT_EQ(1, map.at("a"));
+    EXPECT_EQ(2, static_cast<Map const&>(map).at("b"));
+    EXPECT_THROW(map.at("c"), std::out_of_range);
+
+    map.at("a") = 3;
+    EXPECT_EQ(3, map["a"]);
+    EXPECT_FALSE(map.try_emplace("a", 4).second);
+    EXPECT_TRUE(map.try_emplace("c", 4).second);
+    EXPECT_EQ(1u, map.erase("c"));
+    EXPECT_EQ(1u, map.erase("a"));
+    EXPECT_EQ(0u, map.erase("a"));
+    EXPECT_EQ(map.end(), map.erase(map.cbegin()));
+    EXPECT_TRUE(map.empty());
+}
+
+TEST(StaticAssocTest, TransparentKeys) {
+    test_transparent_keys<static_map<std::string, int, assoc_size, std::less<>>>();
+    test_transparent_keys<static_split_map<std::string, int, assoc_size, std::less<>>>();
+}
+
+TEST(StaticAssocTest, InsertBatchIntoMultiMap) {
+    test_multimap multimap(test_values);
+    test_multimap expected(test_values);
+    for (auto const& value : test_values_with_duplications) {
+        expected.insert(value);
+    }
+
+    auto results = multimap.insert_batch(test_values_with_duplications.begin(),
+                                         test_values_with_duplications.end());
+    EXPECT_TRUE(expected == multimap);
+
+    auto it = test_values_with_duplications.begin();
+    for (auto result : results) {
+        EXPECT_EQ(*it, *result);
+        ++it;
+    }
+}
@@ -14,6 +14,9 @@
 #include <iterator>
 #include <sstream>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -136,6 +139,20 @@ class custom_type {
     static std::size_t num_instances_;
 };
 
+// Same as `custom_type`, but declared trivially relocatable, so that static vectors move its values
+// without calling any constructor or destructor.
+class relocatable_type : public custom_type {
+ public:  // Public Method(s)
+    using custom_type::custom_type;
+};
+
+namespace bptree {
+
+template <>
+struct is_trivially_relocatable<relocatable_type> : std::true_type {};
+
+}  // namespace bptree
+
 template <std::size_t N>
 class expected_result {
  public:  // Public Method(s)
@@ -718,6 +735,37 @@ TEST_F(StaticVectorTest, InsertForwardIteratorPair) {
     test_insert<num_inserted>(insert, num_inserted, extra_test_values, constructed_with::copy_ctor);
 }
 
+TEST_F(StaticVectorTest, InsertAtOffsets) {
+    using vector = static_vector<custom_type, vector_size>;
+    vector v = {custom_type(1), custom_type(3), custom_type(5)};
+    std::array<custom_type, 4> arr = {custom_type(0), custom_type(2), custom_type(4),
+                                      custom_type(6)};
+    std::array<std::size_t, 4> offsets = {0, 1, 2, 3};
+    std::for_each(v.begin(), v.end(), [](custom_type& item) { item.skip_ctor(); });
+
+    v.insert_at(offsets.begin(), arr.begin(), arr.end());
+
+    EXPECT_EQ(v.size() + arr.size(), custom_type::num_instances());
+    int values[] = {0, 1, 2, 3, 4, 5, 6};
+    constructed_with ctors[] = {
+        constructed_with::copy_ctor, constructed_with::move_ctor, constructed_with::copy_ctor,
+        constructed_with::move_ctor, constructed_with::copy_ctor, constructed_with::move_ctor,
+        constructed_with::copy_ctor
+    };
+    for (std::size_t pos = 0; pos < v.size(); ++pos) {
+        EXPECT_EQ(custom_type(ctors[pos], values[pos]), v[pos]);
+    }
+
+    // several values may share an offset, and offsets may point past the last value
+    std::array<std::size_t, 3> more_offsets = {0, 0, 7};
+    v.insert_at(more_offsets.begin(), arr.begin(), arr.begin() + 3);
+    EXPECT_EQ(10, v.size());
+    EXPECT_EQ(custom_type(constructed_with::copy_ctor, 0), v[0]);
+    EXPECT_EQ(custom_type(constructed_with::copy_ctor, 2), v[1]);
+    EXPECT_EQ(custom_type(constructed_with::move_ctor, 0), v[2]);
+    EXPECT_EQ(custom_type(constructed_with::copy_ctor, 4), v[9]);
+}
+
 TEST_F(StaticVectorTest, InsertInitializerList) {
     using vector = static_vector<custom_type, vector_size>;
     auto insert = [](vector& v, typename vector::iterator it) {
@@ -800,3 +848,50 @@ TEST_F(StaticVectorTest, CompareValues) {
     EXPECT_FALSE(v5 < v6); EXPECT_FALSE(v5 <= v6);
     EXPECT_TRUE(v5 > v6); EXPECT_TRUE(v5 >= v6);
 }
+
+TEST_F(StaticVectorTest, RelocateValues) {
+    EXPECT_TRUE(bptree::is_trivially_relocatable<int>::value);
+    EXPECT_TRUE((bptree::is_trivially_relocatable<std::pair<int const, int>>::value));
+    EXPECT_FALSE(bptree::is_trivially_relocatable<custom_type>::value);
+    EXPECT_TRUE(bptree::is_trivially_relocatable<relocatable_type>::value);
+
+    using vector = static_vector<relocatable_type, vector_size>;
+    auto assert_values = [](vector const& v, std::vector<int> const& values) {
+        ASSERT_EQ(values.size(), v.size());
+        for (std::size_t pos = 0; pos < v.size(); ++pos) {
+            EXPECT_EQ(custom_type::skipped(values[pos]), v[pos]);
+        }
+    };
+
+    vector v = WRAP_VALUES(relocatable_type, TEST_VALUES);
+    std::for_each(v.begin(), v.end(), [](relocatable_type& item) { item.skip_ctor(); });
+
+    v.insert(v.begin(), relocatable_type(inserted_value))->skip_ctor();
+    assert_values(v, {inserted_value, TEST_VALUES});
+
+    v.erase(v.begin(), v.begin() + 2);
+    assert_values(v, {2, 3, 5, 8});
+
+    std::array<relocatable_type, 2> arr = {relocatable_type(0), relocatable_type(4)};
+    std::array<std::size_t, 2> offsets = {0, 2};
+    v.insert_at(offsets.begin(), arr.begin(), arr.end());
+    v[0].skip_ctor();
+    v[3].skip_ctor();
+    assert_values(v, {0, 2, 3, 4, 5, 8});
+
+    vector moved(std::move(v));
+    EXPECT_TRUE(v.empty());
+    assert_values(moved, {0, 2, 3, 4, 5, 8});
+
+    vector other = WRAP_VALUES(relocatable_type, EXTRA_TEST_VALUES);
+    std::for_each(other.begin(), other.end(), [](relocatable_type& item) { item.skip_ctor(); });
+    moved.swap(other);
+    assert_values(moved, {EXTRA_TEST_VALUES});
+    assert_values(other, {0, 2, 3, 4, 5, 8});
+
+    v = std::move(other);
+    EXPECT_TRUE(other.empty());
+    assert_values(v, {0, 2, 3, 4, 5, 8});
+
+    EXPECT_EQ(v.size() + moved.size() + arr.size(), custom_type::num_instances());
+}
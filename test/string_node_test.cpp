@@ -0,0 +1,167 @@
+/************************************************
+ *  string_node_test.hpp
+ *  bptree
+ *
+ *  Copyright (c) 2017, Chi-En Wu
+ *  Distributed under MIT License
+ ************************************************/
+
+#include <cstddef>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <bptree/bptree.hpp>
+#include <bptree/internal/string_node.hpp>
+
+#include "./map_test_util.hpp"
+
+using string_node = bptree::internal::string_inner_node<std::less<std::string>, 8, false>;
+
+// Counts the keys of `keys` (but the first, like an inner node) that precede `key`.
+template <typename Compare>
+std::size_t count_separators(std::vector<std::string> const& keys, std::string const& key,
+                             Compare comp) {
+    return std::count_if(keys.begin() + 1, keys.end(), [&](std::string const& sep) {
+        return comp(sep, key);
+    });
+}
+
+void expect_same_children(string_node const& node, std::vector<std::string> const& keys,
+                          std::vector<std::string> const& probes) {
+    ASSERT_EQ(keys.size(), node.size());
+    for (std::size_t pos = 0; pos < keys.size(); ++pos) {
+        EXPECT_EQ(keys[pos], node.key(pos));
+    }
+
+    for (auto const& probe : probes) {
+        SCOPED_TRACE(probe);
+        EXPECT_EQ(count_separators(keys, probe, std::less<std::string>()),
+                  node.lower_child(probe));
+        EXPECT_EQ(count_separators(keys, probe, std::less_equal<std::string>()),
+                  node.upper_child(probe));
+    }
+}
+
+TEST(StringNodeTest, SharePrefixAndCompareHeads) {
+    std::vector<string_node::node_type> children(8);
+    string_node node{std::less<std::string>()};
+
+    // the heads of the last three keys tie, and one key ends with a zero byte
+    std::vector<std::string> keys = {
+        "http://a.com/", "http://a.com/x", "http://a.com/y", "http://a.com/yyyyyyyy1",
+        "http://a.com/yyyyyyyy2", "http://a.com/yyyyyyyy2", "http://a.com/yyyyyyyy2"
+    };
+    keys.back().push_back('\0');
+    for (std::size_t pos = 0; pos < keys.size(); ++pos) {
+        node.insert_child(pos, keys[pos], &children[pos]);
+    }
+
+    EXPECT_EQ(13u, node.prefix_size());
+    EXPECT_EQ(&node, children[0].parent());
+
+    std::vector<std::string> probes = {
+        "", "http://", "http://a.com", "http://a.com/", "http://a.com/a", "http://a.com/x",
+        "http://a.com/y", "http://a.com/yyyyyyyy", "http://a.com/yyyyyyyy2",
+        "http://a.com/yyyyyyyy3", "http://b.com/", "z"
+    };
+    probes.push_back(keys.back());
+    expect_same_children(node, keys, probes);
+
+    // a key out of the shared prefix shortens it
+    keys.insert(keys.begin(), "http://");
+    node.insert_child(0, "http://", &children[7]);
+    EXPECT_EQ(7u, node.prefix_size());
+    expect_same_children(node, keys, probes);
+
+    EXPECT_EQ(7u, node.index_of(&children[6]));
+    node.erase_child(0);
+    keys.erase(keys.begin());
+    expect_same_children(node, keys, probes);
+
+    node.replace_key(0, "http://a");
+    keys[0] = "http://a";
+    expect_same_children(node, keys, probes);
+}
+
+TEST(StringNodeTest, SplitAndMerge) {
+    std::vector<string_node::node_type> children(8);
+    string_node left{std::less<std::string>()};
+    string_node right{std::less<std::string>()};
+
+    std::vector<std::string> keys = {
+        "aaa", "abc", "abd", "abe", "bcd000", "bcd001", "bcd002", "bcd003"
+    };
+    for (std::size_t pos = 0; pos < keys.size(); ++pos) {
+        left.insert_child(pos, keys[pos], &children[pos]);
+    }
+
+    EXPECT_EQ(0u, left.prefix_size());
+    left.split_into(right);
+    EXPECT_EQ(1u, left.prefix_size());
+    EXPECT_EQ(5u, right.prefix_size());
+    EXPECT_EQ(&right, children[4].parent());
+
+    std::vector<std::string> probes = {"", "a", "abd", "abz", "bcd", "bcd002", "bcd01", "c"};
+    expect_same_children(left, {keys.begin(), keys.begin() + 4}, probes);
+    expect_same_children(right, {keys.begin() + 4, keys.end()}, probes);
+
+    left.borrow_from_right(right, right.first_key());
+    expect_same_children(left, {keys.begin(), keys.begin() + 5}, probes);
+    expect_same_children(right, {keys.begin() + 5, keys.end()}, probes);
+
+    right.borrow_from_left(left, keys[5]);
+    expect_same_children(right, {keys.begin() + 4, keys.end()}, probes);
+
+    left.merge_from(right, keys[4]);
+    EXPECT_TRUE(right.empty());
+    EXPECT_EQ(&left, children[7].parent());
+    expect_same_children(left, keys, probes);
+}
+
+// Small nodes, so that inner nodes split, borrow and merge all the time.
+TEST(StringNodeTest, MatchStdMap) {
+    bptree::map<std::string, int, std::less<std::string>, 4, 4> map;
+    std::map<std::string, int> expected;
+
+    auto make_key = [](int n) {
+        return "https://example.com/" + std::to_string(n % 7) + "/item/" + std::to_string(n);
+    };
+
+    random_writes(7, 3000, random_write_count, [&](int i, int n, bool erase) {
+        expect_same_write(map, expected, make_key(n), i, erase);
+    });
+
+    EXPECT_LT(4u, map.height());
+    ASSERT_EQ(expected.size(), map.size());
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), map.begin(), map.end()));
+
+    for (int n = 0; n < 3000; n += 7) {
+        auto key = make_key(n);
+        EXPECT_EQ(expected.count(key), map.count(key));
+        EXPECT_EQ(std::distance(expected.begin(), expected.lower_bound(key)),
+                  std::distance(map.begin(), map.lower_bound(key)));
+        EXPECT_EQ(std::distance(expected.begin(), expected.upper_bound(key + "/")),
+                  std::distance(map.begin(), map.upper_bound(key + "/")));
+    }
+
+    auto copy = map;
+    EXPECT_TRUE(std::equal(copy.begin(), copy.end(), map.begin(), map.end()));
+}
+
+TEST(StringNodeTest, TransparentKeys) {
+    bptree::set<std::string, std::less<>, 4, 4> set;
+    for (int i = 0; i < 1000; ++i) {
+        set.insert("key" + std::to_string(i));
+    }
+
+    EXPECT_NE(set.end(), set.find("key500"));
+    EXPECT_EQ(set.end(), set.find("key1000"));
+    EXPECT_EQ("key990", *set.upper_bound("key99"));
+}